@@ -0,0 +1,655 @@
+#include "apu.hh"
+
+#include <algorithm>
+
+namespace apu
+{
+
+namespace
+{
+    constexpr std::array<uint8_t, 32U> LENGTH_TABLE = {
+        10, 254, 20, 2,  40, 4,  80, 6,  160, 8,  60, 10, 14, 12, 26, 14,
+        12, 16,  24, 18, 48, 20, 96, 22, 192, 24, 72, 26, 16, 28, 32, 30};
+
+    constexpr std::array<std::array<uint8_t, 8U>, 4U> DUTY_TABLE = {{
+        {0, 1, 0, 0, 0, 0, 0, 0},
+        {0, 1, 1, 0, 0, 0, 0, 0},
+        {0, 1, 1, 1, 1, 0, 0, 0},
+        {1, 0, 0, 1, 1, 1, 1, 1}}};
+
+    constexpr std::array<uint8_t, 32U> TRIANGLE_TABLE = {
+        15, 14, 13, 12, 11, 10, 9,  8,  7,  6,  5,  4,  3,  2,  1,  0,
+        0,  1,  2,  3,  4,  5,  6,  7,  8,  9,  10, 11, 12, 13, 14, 15};
+
+    constexpr std::array<uint16_t, 16U> NOISE_PERIODS = {
+        4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068};
+
+    constexpr std::array<uint16_t, 16U> DMC_RATES = {
+        428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54};
+
+    // Frame-counter step times, in CPU cycles from the start of the sequence.
+    constexpr std::array<uint32_t, 4U> FOUR_STEP = {7457U, 14913U, 22371U, 29829U};
+    constexpr std::array<uint32_t, 5U> FIVE_STEP = {7457U, 14913U, 22371U, 29829U, 37281U};
+    constexpr uint32_t FOUR_STEP_PERIOD = 29830U;
+    constexpr uint32_t FIVE_STEP_PERIOD = 37282U;
+
+    // Linear approximation of the mixer, per unit of channel amplitude.
+    // Reference: https://www.nesdev.org/wiki/APU_Mixer
+    constexpr std::array<float, 5U> CHANNEL_WEIGHTS = {0.00752F, 0.00752F, 0.00851F, 0.00494F, 0.00335F};
+
+    enum channel : std::size_t
+    {
+        PULSE_1,
+        PULSE_2,
+        TRIANGLE,
+        NOISE,
+        DMC
+    };
+
+    // Samples per blip frame; samples are published to the ring at least this often.
+    constexpr std::size_t BLIP_MAX_SAMPLES  = 4096U;
+    constexpr uint64_t    BLIP_FRAME_CLOCKS = 8192U;
+
+    uint16_t sweep_target(const pulse &p, const bool ones_complement)
+    {
+        const uint16_t change = p.period >> p.sweep_shift;
+        if(!p.sweep_negate)
+        {
+            return p.period + change;
+        }
+
+        const uint16_t decrement = change + (ones_complement ? 1U : 0U);
+        return (decrement > p.period) ? 0U : p.period - decrement;
+    }
+
+    uint8_t pulse_output(const pulse &p, const bool ones_complement)
+    {
+        if(p.length == 0U || p.period < 8U || sweep_target(p, ones_complement) > 0x7FFU
+           || DUTY_TABLE[p.duty][p.sequence] == 0U)
+        {
+            return 0U;
+        }
+
+        return p.env.volume();
+    }
+
+    void clock_envelope(envelope &e)
+    {
+        if(e.start)
+        {
+            e.start   = false;
+            e.decay   = 15U;
+            e.divider = e.period;
+        }
+        else if(e.divider == 0U)
+        {
+            e.divider = e.period;
+            if(e.decay > 0U)
+            {
+                --e.decay;
+            }
+            else if(e.loop)
+            {
+                e.decay = 15U;
+            }
+        }
+        else
+        {
+            --e.divider;
+        }
+    }
+
+    void clock_sweep(pulse &p, const bool ones_complement)
+    {
+        const uint16_t target = sweep_target(p, ones_complement);
+        if(p.sweep_divider == 0U && p.sweep_enabled && p.sweep_shift > 0U && p.period >= 8U && target <= 0x7FFU)
+        {
+            p.period = target;
+        }
+
+        if(p.sweep_divider == 0U || p.sweep_reload)
+        {
+            p.sweep_divider = p.sweep_period;
+            p.sweep_reload  = false;
+        }
+        else
+        {
+            --p.sweep_divider;
+        }
+    }
+
+    // One noise timer clock: mode 1 takes the feedback from bit 6 instead of bit 1.
+    void step_lfsr(noise &n)
+    {
+        const uint16_t feedback = (n.shift & 1U) ^ ((n.shift >> (n.mode ? 6U : 1U)) & 1U);
+        n.shift = static_cast<uint16_t>((n.shift >> 1U) | (feedback << 14U));
+    }
+
+    // Advances a down-counting timer from `from` to `to`, calling `expire(cycle)` each
+    // time it reaches zero and is reloaded with `period` cycles.
+    template<typename Expire>
+    void run_timer(uint32_t &timer, const uint32_t period, const uint64_t from, const uint64_t to, Expire expire)
+    {
+        uint64_t now = from;
+        while(timer <= to - now)
+        {
+            now += timer;
+            timer = period;
+            expire(now);
+        }
+
+        timer -= static_cast<uint32_t>(to - now);
+    }
+
+    // Same as `run_timer`, for channels whose output cannot change. Only returns how
+    // many times the timer expired.
+    uint64_t skip_timer(uint32_t &timer, const uint32_t period, const uint64_t from, const uint64_t to)
+    {
+        const uint64_t elapsed = to - from;
+        if(timer > elapsed)
+        {
+            timer -= static_cast<uint32_t>(elapsed);
+            return 0U;
+        }
+
+        const uint64_t remaining = elapsed - timer;
+        timer = period - static_cast<uint32_t>(remaining % period);
+        return 1U + (remaining / period);
+    }
+
+} // namespace
+
+processor::processor()
+    : blip_(CPU_CLOCK_RATE, SAMPLE_RATE, BLIP_MAX_SAMPLES),
+      ring_(std::make_unique<sample_ring>())
+{
+}
+
+void processor::write(const uint16_t address, const uint8_t value, const uint64_t cpu_cycle)
+{
+    run_until(cpu_cycle);
+
+    switch(address)
+    {
+        case 0x4000:
+        case 0x4004:
+        {
+            pulse &p       = state_.pulses[(address - 0x4000U) / 4U];
+            p.duty         = value >> 6U;
+            p.env.loop     = (value & 0x20U) != 0U;
+            p.env.constant = (value & 0x10U) != 0U;
+            p.env.period   = value & 0x0FU;
+            break;
+        }
+
+        case 0x4001:
+        case 0x4005:
+        {
+            pulse &p        = state_.pulses[(address - 0x4000U) / 4U];
+            p.sweep_enabled = (value & 0x80U) != 0U;
+            p.sweep_period  = (value >> 4U) & 0x07U;
+            p.sweep_negate  = (value & 0x08U) != 0U;
+            p.sweep_shift   = value & 0x07U;
+            p.sweep_reload  = true;
+            break;
+        }
+
+        case 0x4002:
+        case 0x4006:
+        {
+            pulse &p = state_.pulses[(address - 0x4000U) / 4U];
+            p.period = (p.period & 0x0700U) | value;
+            break;
+        }
+
+        case 0x4003:
+        case 0x4007:
+        {
+            const std::size_t index = (address - 0x4000U) / 4U;
+            pulse            &p     = state_.pulses[index];
+
+            p.period = (p.period & 0x00FFU) | ((value & 0x07U) << 8U);
+            if(state_.enabled & (1U << index))
+            {
+                p.length = LENGTH_TABLE[value >> 3U];
+            }
+            p.sequence  = 0U;
+            p.env.start = true;
+            break;
+        }
+
+        case 0x4008:
+            state_.tri.control       = (value & 0x80U) != 0U;
+            state_.tri.linear_period = value & 0x7FU;
+            break;
+
+        case 0x400A:
+            state_.tri.period = (state_.tri.period & 0x0700U) | value;
+            break;
+
+        case 0x400B:
+            state_.tri.period = (state_.tri.period & 0x00FFU) | ((value & 0x07U) << 8U);
+            if(state_.enabled & 0x04U)
+            {
+                state_.tri.length = LENGTH_TABLE[value >> 3U];
+            }
+            state_.tri.linear_reload = true;
+            break;
+
+        case 0x400C:
+            state_.noi.env.loop     = (value & 0x20U) != 0U;
+            state_.noi.env.constant = (value & 0x10U) != 0U;
+            state_.noi.env.period   = value & 0x0FU;
+            break;
+
+        case 0x400E:
+            state_.noi.mode   = (value & 0x80U) != 0U;
+            state_.noi.period = NOISE_PERIODS[value & 0x0FU];
+            break;
+
+        case 0x400F:
+            if(state_.enabled & 0x08U)
+            {
+                state_.noi.length = LENGTH_TABLE[value >> 3U];
+            }
+            state_.noi.env.start = true;
+            break;
+
+        case 0x4010:
+            state_.dm.irq_enabled = (value & 0x80U) != 0U;
+            state_.dm.loop        = (value & 0x40U) != 0U;
+            state_.dm.rate        = DMC_RATES[value & 0x0FU];
+            if(!state_.dm.irq_enabled)
+            {
+                state_.dmc_irq = false;
+            }
+            break;
+
+        case 0x4011:
+            state_.dm.level = value & 0x7FU;
+            break;
+
+        case 0x4012:
+            state_.dm.sample_address = 0xC000U + (value * 64U);
+            break;
+
+        case 0x4013:
+            state_.dm.sample_length = (value * 16U) + 1U;
+            break;
+
+        case 0x4015:
+            state_.enabled = value & 0x1FU;
+            if(!(value & 0x01U)) { state_.pulses[0].length = 0U; }
+            if(!(value & 0x02U)) { state_.pulses[1].length = 0U; }
+            if(!(value & 0x04U)) { state_.tri.length = 0U; }
+            if(!(value & 0x08U)) { state_.noi.length = 0U; }
+
+            state_.dmc_irq = false;
+            if(!(value & 0x10U))
+            {
+                state_.dm.bytes_remaining = 0U;
+            }
+            else if(state_.dm.bytes_remaining == 0U)
+            {
+                state_.dm.current_address = state_.dm.sample_address;
+                state_.dm.bytes_remaining = state_.dm.sample_length;
+                fetch_dmc_sample();
+            }
+            break;
+
+        case 0x4017:
+            state_.five_step   = (value & 0x80U) != 0U;
+            state_.irq_inhibit = (value & 0x40U) != 0U;
+            state_.frame_step  = 0U;
+            state_.frame_start = cpu_cycle;
+            if(state_.irq_inhibit)
+            {
+                state_.frame_irq = false;
+            }
+            if(state_.five_step)
+            {
+                quarter_frame();
+                half_frame();
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    update_output(state_.cycle);
+}
+
+uint8_t processor::read_status(const uint64_t cpu_cycle)
+{
+    run_until(cpu_cycle);
+
+    uint8_t status = 0x00U;
+    status |= (state_.pulses[0].length > 0U) ? 0x01U : 0x00U;
+    status |= (state_.pulses[1].length > 0U) ? 0x02U : 0x00U;
+    status |= (state_.tri.length > 0U) ? 0x04U : 0x00U;
+    status |= (state_.noi.length > 0U) ? 0x08U : 0x00U;
+    status |= (state_.dm.bytes_remaining > 0U) ? 0x10U : 0x00U;
+    status |= state_.frame_irq ? 0x40U : 0x00U;
+    status |= state_.dmc_irq ? 0x80U : 0x00U;
+
+    state_.frame_irq = false;
+    return status;
+}
+
+void processor::run_until(const uint64_t cpu_cycle)
+{
+    while(state_.cycle < cpu_cycle)
+    {
+        const uint32_t step_time = state_.five_step ? FIVE_STEP[state_.frame_step] : FOUR_STEP[state_.frame_step];
+        const uint64_t frame_event = state_.frame_start + step_time;
+        const uint64_t blip_event  = blip_start_ + BLIP_FRAME_CLOCKS;
+        const uint64_t next        = std::min({cpu_cycle, frame_event, blip_event});
+
+        run_channels(next);
+
+        if(next == frame_event)
+        {
+            clock_frame_counter();
+            update_output(next);
+        }
+
+        if(next == blip_event)
+        {
+            end_blip_frame(next);
+        }
+    }
+}
+
+void processor::flush(const uint64_t cpu_cycle)
+{
+    run_until(cpu_cycle);
+    end_blip_frame(state_.cycle);
+}
+
+void processor::restore(const state &s)
+{
+    // The blip buffer only accepts deltas after its current frame start, so close it
+    // and restart it where the restored state is.
+    end_blip_frame(state_.cycle);
+    state_      = s;
+    blip_start_ = state_.cycle;
+}
+
+void processor::set_output_enabled(const bool enabled)
+{
+    if(enabled == output_enabled_)
+    {
+        return;
+    }
+
+    end_blip_frame(state_.cycle);
+    output_enabled_ = enabled;
+}
+
+void processor::run_channels(const uint64_t until)
+{
+    const uint64_t from = state_.cycle;
+
+    // Pulses: the sequencer steps every (period + 1) * 2 CPU cycles.
+    for(std::size_t i = 0U; i < state_.pulses.size(); ++i)
+    {
+        pulse         &p      = state_.pulses[i];
+        const uint32_t period = (p.period + 1U) * 2U;
+        const bool     ones   = (i == 0U);
+
+        if(p.length == 0U || p.env.volume() == 0U)
+        {
+            p.sequence = (p.sequence + skip_timer(p.timer, period, from, until)) & 0x07U;
+            continue;
+        }
+
+        run_timer(p.timer, period, from, until, [&](const uint64_t now)
+        {
+            p.sequence = (p.sequence + 1U) & 0x07U;
+            emit(PULSE_1 + i, pulse_output(p, ones), now);
+        });
+    }
+
+    // Triangle: only steps while both counters are non-zero. Ultrasonic periods are
+    // held rather than stepped, as they would only produce a pop.
+    triangle &t = state_.tri;
+    if(t.length == 0U || t.linear_counter == 0U || t.period < 2U)
+    {
+        skip_timer(t.timer, t.period + 1U, from, until);
+    }
+    else
+    {
+        run_timer(t.timer, t.period + 1U, from, until, [&](const uint64_t now)
+        {
+            t.sequence = (t.sequence + 1U) & 0x1FU;
+            emit(TRIANGLE, TRIANGLE_TABLE[t.sequence], now);
+        });
+    }
+
+    // Noise: 15-bit LFSR. Silent, it still shifts, but there is nothing to emit.
+    noise &n = state_.noi;
+    if(n.length == 0U || n.env.volume() == 0U)
+    {
+        for(uint64_t steps = skip_timer(n.timer, n.period, from, until); steps > 0U; --steps)
+        {
+            step_lfsr(n);
+        }
+    }
+    else
+    {
+        run_timer(n.timer, n.period, from, until, [&](const uint64_t now)
+        {
+            step_lfsr(n);
+            emit(NOISE, (n.shift & 1U) == 0U ? n.env.volume() : 0U, now);
+        });
+    }
+
+    // DMC output unit.
+    dmc &d = state_.dm;
+    run_timer(d.timer, d.rate, from, until, [&](const uint64_t now)
+    {
+        if(!d.silence)
+        {
+            if(d.shift & 1U)
+            {
+                d.level = (d.level <= 125U) ? d.level + 2U : d.level;
+            }
+            else
+            {
+                d.level = (d.level >= 2U) ? d.level - 2U : d.level;
+            }
+        }
+
+        d.shift >>= 1U;
+        if(--d.bits_remaining == 0U)
+        {
+            d.bits_remaining = 8U;
+            d.silence        = !d.buffer_full;
+            if(d.buffer_full)
+            {
+                d.shift       = d.buffer;
+                d.buffer_full = false;
+                fetch_dmc_sample();
+            }
+        }
+
+        emit(DMC, d.level, now);
+    });
+
+    state_.cycle = until;
+}
+
+void processor::fetch_dmc_sample()
+{
+    dmc &d = state_.dm;
+    if(d.buffer_full || d.bytes_remaining == 0U)
+    {
+        return;
+    }
+
+    d.buffer          = reader_ ? reader_(d.current_address) : 0x00U;
+    d.buffer_full     = true;
+    d.current_address = (d.current_address == 0xFFFFU) ? 0x8000U : d.current_address + 1U;
+
+    if(--d.bytes_remaining == 0U)
+    {
+        if(d.loop)
+        {
+            d.current_address = d.sample_address;
+            d.bytes_remaining = d.sample_length;
+        }
+        else if(d.irq_enabled)
+        {
+            state_.dmc_irq = true;
+        }
+    }
+}
+
+void processor::clock_frame_counter()
+{
+    const uint32_t step = state_.frame_step;
+
+    if(!state_.five_step)
+    {
+        quarter_frame();
+        if(step == 1U || step == 3U)
+        {
+            half_frame();
+        }
+
+        if(step == 3U)
+        {
+            state_.frame_irq   = state_.frame_irq || !state_.irq_inhibit;
+            state_.frame_start += FOUR_STEP_PERIOD;
+            state_.frame_step  = 0U;
+            return;
+        }
+    }
+    else
+    {
+        if(step != 3U)
+        {
+            quarter_frame();
+        }
+        if(step == 1U || step == 4U)
+        {
+            half_frame();
+        }
+
+        if(step == 4U)
+        {
+            state_.frame_start += FIVE_STEP_PERIOD;
+            state_.frame_step  = 0U;
+            return;
+        }
+    }
+
+    ++state_.frame_step;
+}
+
+void processor::quarter_frame()
+{
+    clock_envelope(state_.pulses[0].env);
+    clock_envelope(state_.pulses[1].env);
+    clock_envelope(state_.noi.env);
+
+    triangle &t = state_.tri;
+    if(t.linear_reload)
+    {
+        t.linear_counter = t.linear_period;
+    }
+    else if(t.linear_counter > 0U)
+    {
+        --t.linear_counter;
+    }
+
+    if(!t.control)
+    {
+        t.linear_reload = false;
+    }
+}
+
+void processor::half_frame()
+{
+    for(std::size_t i = 0U; i < state_.pulses.size(); ++i)
+    {
+        pulse &p = state_.pulses[i];
+        if(!p.env.loop && p.length > 0U)
+        {
+            --p.length;
+        }
+        clock_sweep(p, i == 0U);
+    }
+
+    if(!state_.tri.control && state_.tri.length > 0U)
+    {
+        --state_.tri.length;
+    }
+
+    if(!state_.noi.env.loop && state_.noi.length > 0U)
+    {
+        --state_.noi.length;
+    }
+}
+
+void processor::update_output(const uint64_t cycle)
+{
+    emit(PULSE_1, pulse_output(state_.pulses[0], true), cycle);
+    emit(PULSE_2, pulse_output(state_.pulses[1], false), cycle);
+    emit(TRIANGLE, TRIANGLE_TABLE[state_.tri.sequence], cycle);
+    emit(NOISE, ((state_.noi.shift & 1U) == 0U && state_.noi.length > 0U) ? state_.noi.env.volume() : 0U, cycle);
+    emit(DMC, state_.dm.level, cycle);
+}
+
+void processor::emit(const std::size_t channel, const uint8_t amplitude, const uint64_t cycle)
+{
+    const uint8_t previous = state_.output[channel];
+    if(amplitude == previous)
+    {
+        return;
+    }
+
+    state_.output[channel] = amplitude;
+    if(!output_enabled_)
+    {
+        return;
+    }
+
+    blip_.add_delta(cycle - blip_start_,
+                    (static_cast<float>(amplitude) - static_cast<float>(previous)) * CHANNEL_WEIGHTS[channel]);
+}
+
+void processor::end_blip_frame(const uint64_t cycle)
+{
+    if(!output_enabled_)
+    {
+        blip_start_ = cycle;
+        return;
+    }
+
+    blip_.end_frame(cycle - blip_start_);
+    blip_start_ = cycle;
+
+    std::array<int16_t, 1024U> samples;
+    while(const std::size_t n = blip_.read_samples(samples.data(), samples.size()))
+    {
+        dropped_ += n - ring_->push(samples.data(), n);
+    }
+}
+
+std::size_t drain(sample_ring &ring, utils::wav_writer &out)
+{
+    std::array<int16_t, 1024U> samples;
+    std::size_t                total = 0U;
+
+    while(const std::size_t n = ring.pop(samples.data(), samples.size()))
+    {
+        out.write(samples.data(), n);
+        total += n;
+    }
+
+    return total;
+}
+
+} // namespace apu
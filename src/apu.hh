@@ -0,0 +1,187 @@
+#include "blip_buffer.hh"
+#include "ring_buffer.hh"
+#include "utils.hh"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#pragma once
+
+//
+// Implements the 2A03 APU.
+//
+// Channels are clocked from the CPU cycle counter and are event driven: rather than
+// stepping every channel on every CPU cycle, each channel jumps straight from one
+// timer expiry to the next and only reports amplitude changes to the blip buffer.
+// Finished 48 kHz samples are published through a wait-free SPSC ring.
+//
+
+namespace apu
+{
+
+constexpr uint32_t CPU_CLOCK_RATE = 1789773U;  // NTSC
+constexpr uint32_t SAMPLE_RATE    = 48000U;
+
+// Audio output ring; roughly 0.7s at 48 kHz.
+using sample_ring = utils::spsc_ring<int16_t, 1U << 15U>;
+
+// Volume envelope (pulse and noise).
+struct envelope
+{
+    bool    start    = false;
+    bool    loop     = false;  // Also halts the length counter.
+    bool    constant = false;
+    uint8_t period   = 0U;     // Also the constant volume.
+    uint8_t divider  = 0U;
+    uint8_t decay    = 0U;
+
+    uint8_t volume() const { return constant ? period : decay; }
+};
+
+struct pulse
+{
+    envelope env;
+    uint8_t  duty     = 0U;
+    uint8_t  sequence = 0U;
+    uint16_t period   = 0U;
+    uint32_t timer    = 0U;   // CPU cycles until the next sequencer step.
+    uint8_t  length   = 0U;
+
+    // Sweep unit.
+    bool    sweep_enabled = false;
+    bool    sweep_negate  = false;
+    bool    sweep_reload  = false;
+    uint8_t sweep_period  = 0U;
+    uint8_t sweep_shift   = 0U;
+    uint8_t sweep_divider = 0U;
+};
+
+struct triangle
+{
+    bool     control        = false;  // Also halts the length counter.
+    bool     linear_reload  = false;
+    uint8_t  linear_period  = 0U;
+    uint8_t  linear_counter = 0U;
+    uint8_t  sequence       = 0U;
+    uint16_t period         = 0U;
+    uint32_t timer          = 0U;
+    uint8_t  length         = 0U;
+};
+
+struct noise
+{
+    envelope env;
+    bool     mode   = false;
+    uint16_t period = 4U;
+    uint32_t timer  = 0U;
+    uint16_t shift  = 1U;
+    uint8_t  length = 0U;
+};
+
+struct dmc
+{
+    bool     irq_enabled     = false;
+    bool     loop            = false;
+    uint16_t rate            = 428U;
+    uint32_t timer           = 0U;
+    uint8_t  level           = 0U;
+    uint16_t sample_address  = 0xC000U;
+    uint16_t sample_length   = 1U;
+    uint16_t current_address = 0xC000U;
+    uint16_t bytes_remaining = 0U;
+    uint8_t  buffer          = 0U;
+    bool     buffer_full     = false;
+    uint8_t  shift           = 0U;
+    uint8_t  bits_remaining  = 8U;
+    bool     silence         = true;
+};
+
+// APU state. Plain data so that it can be copied for snapshots.
+struct state
+{
+    std::array<pulse, 2U> pulses;
+    triangle              tri;
+    noise                 noi;
+    dmc                   dm;
+
+    uint8_t enabled = 0x00U;  // $4015 channel enables.
+
+    // Frame counter
+    bool     five_step   = false;
+    bool     irq_inhibit = false;
+    bool     frame_irq   = false;
+    bool     dmc_irq     = false;
+    uint32_t frame_step  = 0U;
+    uint64_t frame_start = 0U;  // CPU cycle the current frame-counter sequence started on.
+
+    uint64_t cycle = 0U;  // CPU cycle the channels have been run up to.
+
+    // Last amplitude reported to the blip buffer, per channel.
+    std::array<uint8_t, 5U> output{};
+};
+
+class processor
+{
+public:
+    // Used to fetch DMC sample bytes from CPU memory.
+    using memory_reader = std::function<uint8_t(uint16_t)>;
+
+    processor();
+
+    void set_memory_reader(memory_reader reader) { reader_ = std::move(reader); }
+
+    // Register access ($4000 - $4013, $4015, $4017). Runs the channels up to
+    // `cpu_cycle` first.
+    void    write(uint16_t address, uint8_t value, uint64_t cpu_cycle);
+    uint8_t read_status(uint64_t cpu_cycle);
+
+    // Run the channels up to `cpu_cycle`, publishing samples as the blip buffer fills.
+    void run_until(uint64_t cpu_cycle);
+
+    // Run up to `cpu_cycle` and publish every finished sample.
+    void flush(uint64_t cpu_cycle);
+
+    bool irq_pending() const { return state_.frame_irq || state_.dmc_irq; }
+
+    const state &get_state() const { return state_; }
+
+    // Rewinds (or fast-forwards) the channels to `s`. Audio already produced is kept.
+    void restore(const state &s);
+
+    // While disabled the channels still run but nothing is synthesized or published.
+    void set_output_enabled(bool enabled);
+    bool output_enabled() const { return output_enabled_; }
+
+    // Consumer end of the output. Samples that do not fit are dropped, audio never
+    // stalls emulation.
+    sample_ring &output() { return *ring_; }
+    uint64_t     dropped_samples() const { return dropped_; }
+
+private:
+    void run_channels(uint64_t until);
+    void clock_frame_counter();
+    void quarter_frame();
+    void half_frame();
+    void fetch_dmc_sample();
+    void update_output(uint64_t cycle);
+    void emit(std::size_t channel, uint8_t amplitude, uint64_t cycle);
+    void end_blip_frame(uint64_t cycle);
+
+    state         state_;
+    memory_reader reader_;
+    blip_buffer   blip_;
+    uint64_t      blip_start_     = 0U;  // CPU cycle the blip buffer frame started on.
+    uint64_t      dropped_        = 0U;
+    bool          output_enabled_ = true;
+
+    std::unique_ptr<sample_ring> ring_;
+};
+
+// Moves every queued sample from `ring` into `out`, returns the number moved. This is
+// the consumer used when running headless.
+std::size_t drain(sample_ring &ring, utils::wav_writer &out);
+
+} // namespace apu
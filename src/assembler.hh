@@ -0,0 +1,854 @@
+#include "cpu.hh"
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+#pragma once
+
+//
+// 6502 assembler that runs at compile time.
+//
+//     constexpr auto program = cpu::assembler::assemble([]() { return R"(
+//             .org $8000
+//     reset:  ldx #$08
+//     loop:   dex
+//             bne loop
+//             jmp reset
+//     )"; });
+//
+// gives a `std::array<uint8_t, 8>`. The source is passed as a lambda returning it, so
+// its length can become the array size; `assemble<N>(source)` does the same at run
+// time for sources that are not constants.
+//
+// One statement per line, with `;` comments and case-insensitive mnemonics:
+//
+//  - `label:` defines a label at the current address, and may be followed by a
+//    statement on the same line.
+//  - Operands use the usual syntax: `#v`, `v`, `v,X`, `v,Y`, `(v)`, `(v,X)`, `(v),Y`
+//    and `A` or nothing for the accumulator. Branches take their target address.
+//  - Values are `$hex`, `%binary`, decimal, `'c'`, a label or `*` (the current
+//    address), added or subtracted, and `<v`/`>v` take the low/high byte.
+//  - `.org v` sets the address of what follows, padding with zeros if code came
+//    before; `.byte` takes values and "strings", `.word` little-endian values.
+//
+// Zero-page forms are picked for values of at most two hex digits or below 256 in
+// decimal, and for `<`/`>`; labels and sums always use the absolute form, so the size
+// of every instruction is known before the labels are.
+//
+// Errors throw `std::invalid_argument`, which makes a constant evaluation fail to
+// compile with the message in the diagnostic.
+//
+
+namespace cpu
+{
+
+namespace assembler
+{
+
+enum class mode : uint8_t
+{
+    IMPLIED,
+    ACCUMULATOR,
+    IMMEDIATE,
+    ZERO_PAGE,
+    ZERO_PAGE_X,
+    ZERO_PAGE_Y,
+    ABSOLUTE,
+    ABSOLUTE_X,
+    ABSOLUTE_Y,
+    INDIRECT,
+    INDIRECT_X,
+    INDIRECT_Y,
+    RELATIVE
+};
+
+struct encoding
+{
+    std::string_view mnemonic;
+    mode             addressing;
+    op::codes        code;
+};
+
+using op::codes;
+
+// Every official opcode by mnemonic and addressing mode.
+constexpr std::array<encoding, 151U> ENCODINGS = {{
+    {"ADC", mode::IMMEDIATE,   codes::ADC_IMMEDIATE},
+    {"ADC", mode::ZERO_PAGE,   codes::ADC_ZERO_PAGE},
+    {"ADC", mode::ZERO_PAGE_X, codes::ADC_ZERO_PAGE_X},
+    {"ADC", mode::ABSOLUTE,    codes::ADC_ABSOLUTE},
+    {"ADC", mode::ABSOLUTE_X,  codes::ADC_ABSOLUTE_X},
+    {"ADC", mode::ABSOLUTE_Y,  codes::ADC_ABSOLUTE_Y},
+    {"ADC", mode::INDIRECT_X,  codes::ADC_INDIRECT_X},
+    {"ADC", mode::INDIRECT_Y,  codes::ADC_INDIRECT_Y},
+    {"AND", mode::IMMEDIATE,   codes::AND_IMMEDIATE},
+    {"AND", mode::ZERO_PAGE,   codes::AND_ZERO_PAGE},
+    {"AND", mode::ZERO_PAGE_X, codes::AND_ZERO_PAGE_X},
+    {"AND", mode::ABSOLUTE,    codes::AND_ABSOLUTE},
+    {"AND", mode::ABSOLUTE_X,  codes::AND_ABSOLUTE_X},
+    {"AND", mode::ABSOLUTE_Y,  codes::AND_ABSOLUTE_Y},
+    {"AND", mode::INDIRECT_X,  codes::AND_INDIRECT_X},
+    {"AND", mode::INDIRECT_Y,  codes::AND_INDIRECT_Y},
+    {"ASL", mode::ACCUMULATOR, codes::ASL_ACCUMULATOR},
+    {"ASL", mode::ZERO_PAGE,   codes::ASL_ZERO_PAGE},
+    {"ASL", mode::ZERO_PAGE_X, codes::ASL_ZERO_PAGE_X},
+    {"ASL", mode::ABSOLUTE,    codes::ASL_ABSOLUTE},
+    {"ASL", mode::ABSOLUTE_X,  codes::ASL_ABSOLUTE_X},
+    {"BIT", mode::ZERO_PAGE,   codes::BIT_ZERO_PAGE},
+    {"BIT", mode::ABSOLUTE,    codes::BIT_ABSOLUTE},
+    {"BPL", mode::RELATIVE,    codes::BPL},
+    {"BMI", mode::RELATIVE,    codes::BMI},
+    {"BVC", mode::RELATIVE,    codes::BVC},
+    {"BVS", mode::RELATIVE,    codes::BVS},
+    {"BCC", mode::RELATIVE,    codes::BCC},
+    {"BCS", mode::RELATIVE,    codes::BCS},
+    {"BNE", mode::RELATIVE,    codes::BNE},
+    {"BEQ", mode::RELATIVE,    codes::BEQ},
+    {"BRK", mode::IMPLIED,     codes::BRK},
+    {"CMP", mode::IMMEDIATE,   codes::CMP_IMMEDIATE},
+    {"CMP", mode::ZERO_PAGE,   codes::CMP_ZERO_PAGE},
+    {"CMP", mode::ZERO_PAGE_X, codes::CMP_ZERO_PAGE_X},
+    {"CMP", mode::ABSOLUTE,    codes::CMP_ABSOLUTE},
+    {"CMP", mode::ABSOLUTE_X,  codes::CMP_ABSOLUTE_X},
+    {"CMP", mode::ABSOLUTE_Y,  codes::CMP_ABSOLUTE_Y},
+    {"CMP", mode::INDIRECT_X,  codes::CMP_INDIRECT_X},
+    {"CMP", mode::INDIRECT_Y,  codes::CMP_INDIRECT_Y},
+    {"CPX", mode::IMMEDIATE,   codes::CPX_IMMEDIATE},
+    {"CPX", mode::ZERO_PAGE,   codes::CPX_ZERO_PAGE},
+    {"CPX", mode::ABSOLUTE,    codes::CPX_ABSOLUTE},
+    {"CPY", mode::IMMEDIATE,   codes::CPY_IMMEDIATE},
+    {"CPY", mode::ZERO_PAGE,   codes::CPY_ZERO_PAGE},
+    {"CPY", mode::ABSOLUTE,    codes::CPY_ABSOLUTE},
+    {"DEC", mode::ZERO_PAGE,   codes::DEC_ZERO_PAGE},
+    {"DEC", mode::ZERO_PAGE_X, codes::DEC_ZERO_PAGE_X},
+    {"DEC", mode::ABSOLUTE,    codes::DEC_ABSOLUTE},
+    {"DEC", mode::ABSOLUTE_X,  codes::DEC_ABSOLUTE_X},
+    {"EOR", mode::IMMEDIATE,   codes::EOR_IMMEDIATE},
+    {"EOR", mode::ZERO_PAGE,   codes::EOR_ZERO_PAGE},
+    {"EOR", mode::ZERO_PAGE_X, codes::EOR_ZERO_PAGE_X},
+    {"EOR", mode::ABSOLUTE,    codes::EOR_ABSOLUTE},
+    {"EOR", mode::ABSOLUTE_X,  codes::EOR_ABSOLUTE_X},
+    {"EOR", mode::ABSOLUTE_Y,  codes::EOR_ABSOLUTE_Y},
+    {"EOR", mode::INDIRECT_X,  codes::EOR_INDIRECT_X},
+    {"EOR", mode::INDIRECT_Y,  codes::EOR_INDIRECT_Y},
+    {"CLC", mode::IMPLIED,     codes::CLC},
+    {"SEC", mode::IMPLIED,     codes::SEC},
+    {"CLI", mode::IMPLIED,     codes::CLI},
+    {"SEI", mode::IMPLIED,     codes::SEI},
+    {"CLV", mode::IMPLIED,     codes::CLV},
+    {"CLD", mode::IMPLIED,     codes::CLD},
+    {"SED", mode::IMPLIED,     codes::SED},
+    {"INC", mode::ZERO_PAGE,   codes::INC_ZERO_PAGE},
+    {"INC", mode::ZERO_PAGE_X, codes::INC_ZERO_PAGE_X},
+    {"INC", mode::ABSOLUTE,    codes::INC_ABSOLUTE},
+    {"INC", mode::ABSOLUTE_X,  codes::INC_ABSOLUTE_X},
+    {"JMP", mode::ABSOLUTE,    codes::JMP_ABSOLUTE},
+    {"JMP", mode::INDIRECT,    codes::JMP_INDIRECT},
+    {"JSR", mode::ABSOLUTE,    codes::JSR_ABSOLUTE},
+    {"LDA", mode::IMMEDIATE,   codes::LDA_IMMEDIATE},
+    {"LDA", mode::ZERO_PAGE,   codes::LDA_ZERO_PAGE},
+    {"LDA", mode::ZERO_PAGE_X, codes::LDA_ZERO_PAGE_X},
+    {"LDA", mode::ABSOLUTE,    codes::LDA_ABSOLUTE},
+    {"LDA", mode::ABSOLUTE_X,  codes::LDA_ABSOLUTE_X},
+    {"LDA", mode::ABSOLUTE_Y,  codes::LDA_ABSOLUTE_Y},
+    {"LDA", mode::INDIRECT_X,  codes::LDA_INDIRECT_X},
+    {"LDA", mode::INDIRECT_Y,  codes::LDA_INDIRECT_Y},
+    {"LDX", mode::IMMEDIATE,   codes::LDX_IMMEDIATE},
+    {"LDX", mode::ZERO_PAGE,   codes::LDX_ZERO_PAGE},
+    {"LDX", mode::ZERO_PAGE_Y, codes::LDX_ZERO_PAGE_Y},
+    {"LDX", mode::ABSOLUTE,    codes::LDX_ABSOLUTE},
+    {"LDX", mode::ABSOLUTE_Y,  codes::LDX_ABSOLUTE_Y},
+    {"LDY", mode::IMMEDIATE,   codes::LDY_IMMEDIATE},
+    {"LDY", mode::ZERO_PAGE,   codes::LDY_ZERO_PAGE},
+    {"LDY", mode::ZERO_PAGE_X, codes::LDY_ZERO_PAGE_X},
+    {"LDY", mode::ABSOLUTE,    codes::LDY_ABSOLUTE},
+    {"LDY", mode::ABSOLUTE_X,  codes::LDY_ABSOLUTE_X},
+    {"LSR", mode::ACCUMULATOR, codes::LSR_ACCUMULATOR},
+    {"LSR", mode::ZERO_PAGE,   codes::LSR_ZERO_PAGE},
+    {"LSR", mode::ZERO_PAGE_X, codes::LSR_ZERO_PAGE_X},
+    {"LSR", mode::ABSOLUTE,    codes::LSR_ABSOLUTE},
+    {"LSR", mode::ABSOLUTE_X,  codes::LSR_ABSOLUTE_X},
+    {"NOP", mode::IMPLIED,     codes::NOP},
+    {"ORA", mode::IMMEDIATE,   codes::ORA_IMMEDIATE},
+    {"ORA", mode::ZERO_PAGE,   codes::ORA_ZERO_PAGE},
+    {"ORA", mode::ZERO_PAGE_X, codes::ORA_ZERO_PAGE_X},
+    {"ORA", mode::ABSOLUTE,    codes::ORA_ABSOLUTE},
+    {"ORA", mode::ABSOLUTE_X,  codes::ORA_ABSOLUTE_X},
+    {"ORA", mode::ABSOLUTE_Y,  codes::ORA_ABSOLUTE_Y},
+    {"ORA", mode::INDIRECT_X,  codes::ORA_INDIRECT_X},
+    {"ORA", mode::INDIRECT_Y,  codes::ORA_INDIRECT_Y},
+    {"TAX", mode::IMPLIED,     codes::REG_TAX},
+    {"TXA", mode::IMPLIED,     codes::REG_TXA},
+    {"DEX", mode::IMPLIED,     codes::REG_DEX},
+    {"INX", mode::IMPLIED,     codes::REG_INX},
+    {"TAY", mode::IMPLIED,     codes::REG_TAY},
+    {"TYA", mode::IMPLIED,     codes::REG_TYA},
+    {"DEY", mode::IMPLIED,     codes::REG_DEY},
+    {"INY", mode::IMPLIED,     codes::REG_INY},
+    {"ROL", mode::ACCUMULATOR, codes::ROL_ACCUMULATOR},
+    {"ROL", mode::ZERO_PAGE,   codes::ROL_ZERO_PAGE},
+    {"ROL", mode::ZERO_PAGE_X, codes::ROL_ZERO_PAGE_X},
+    {"ROL", mode::ABSOLUTE,    codes::ROL_ABSOLUTE},
+    {"ROL", mode::ABSOLUTE_X,  codes::ROL_ABSOLUTE_X},
+    {"ROR", mode::ACCUMULATOR, codes::ROR_ACCUMULATOR},
+    {"ROR", mode::ZERO_PAGE,   codes::ROR_ZERO_PAGE},
+    {"ROR", mode::ZERO_PAGE_X, codes::ROR_ZERO_PAGE_X},
+    {"ROR", mode::ABSOLUTE,    codes::ROR_ABSOLUTE},
+    {"ROR", mode::ABSOLUTE_X,  codes::ROR_ABSOLUTE_X},
+    {"RTI", mode::IMPLIED,     codes::RTI},
+    {"RTS", mode::IMPLIED,     codes::RTS},
+    {"SBC", mode::IMMEDIATE,   codes::SBC_IMMEDIATE},
+    {"SBC", mode::ZERO_PAGE,   codes::SBC_ZERO_PAGE},
+    {"SBC", mode::ZERO_PAGE_X, codes::SBC_ZERO_PAGE_X},
+    {"SBC", mode::ABSOLUTE,    codes::SBC_ABSOLUTE},
+    {"SBC", mode::ABSOLUTE_X,  codes::SBC_ABSOLUTE_X},
+    {"SBC", mode::ABSOLUTE_Y,  codes::SBC_ABSOLUTE_Y},
+    {"SBC", mode::INDIRECT_X,  codes::SBC_INDIRECT_X},
+    {"SBC", mode::INDIRECT_Y,  codes::SBC_INDIRECT_Y},
+    {"STA", mode::ZERO_PAGE,   codes::STA_ZERO_PAGE},
+    {"STA", mode::ZERO_PAGE_X, codes::STA_ZERO_PAGE_X},
+    {"STA", mode::ABSOLUTE,    codes::STA_ABSOLUTE},
+    {"STA", mode::ABSOLUTE_X,  codes::STA_ABSOLUTE_X},
+    {"STA", mode::ABSOLUTE_Y,  codes::STA_ABSOLUTE_Y},
+    {"STA", mode::INDIRECT_X,  codes::STA_INDIRECT_X},
+    {"STA", mode::INDIRECT_Y,  codes::STA_INDIRECT_Y},
+    {"TXS", mode::IMPLIED,     codes::TXS},
+    {"TSX", mode::IMPLIED,     codes::TSX},
+    {"PHA", mode::IMPLIED,     codes::PHA},
+    {"PLA", mode::IMPLIED,     codes::PLA},
+    {"PHP", mode::IMPLIED,     codes::PHP},
+    {"PLP", mode::IMPLIED,     codes::PLP},
+    {"STX", mode::ZERO_PAGE,   codes::STX_ZERO_PAGE},
+    {"STX", mode::ZERO_PAGE_Y, codes::STX_ZERO_PAGE_Y},
+    {"STX", mode::ABSOLUTE,    codes::STX_ABSOLUTE},
+    {"STY", mode::ZERO_PAGE,   codes::STY_ZERO_PAGE},
+    {"STY", mode::ZERO_PAGE_X, codes::STY_ZERO_PAGE_X},
+    {"STY", mode::ABSOLUTE,    codes::STY_ABSOLUTE},
+}};
+
+namespace detail
+{
+    constexpr std::size_t MAX_LABELS = 256U;
+
+    constexpr std::size_t operand_bytes(const mode m)
+    {
+        switch(m)
+        {
+            case mode::IMPLIED:
+            case mode::ACCUMULATOR: return 0U;
+            case mode::ABSOLUTE:
+            case mode::ABSOLUTE_X:
+            case mode::ABSOLUTE_Y:
+            case mode::INDIRECT: return 2U;
+            default: return 1U;
+        }
+    }
+
+    constexpr char upper(const char c)
+    {
+        return (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+    }
+
+    constexpr bool is_identifier(const char c, const bool first)
+    {
+        return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || c == '_' || (!first && c >= '0' && c <= '9');
+    }
+
+    constexpr bool same_word(const std::string_view a, const std::string_view b)
+    {
+        if(a.size() != b.size())
+        {
+            return false;
+        }
+        for(std::size_t i = 0U; i < a.size(); ++i)
+        {
+            if(upper(a[i]) != upper(b[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    struct label
+    {
+        std::string_view name;
+        uint16_t         address = 0U;
+    };
+
+    struct symbols
+    {
+        std::array<label, MAX_LABELS> entries{};
+        std::size_t                   count = 0U;
+
+        constexpr const label *find(const std::string_view name) const
+        {
+            for(std::size_t i = 0U; i < count; ++i)
+            {
+                if(entries[i].name == name)
+                {
+                    return &entries[i];
+                }
+            }
+            return nullptr;
+        }
+
+        constexpr void define(const std::string_view name, const uint16_t address)
+        {
+            if(find(name) != nullptr)
+            {
+                throw std::invalid_argument("Label defined twice!");
+            }
+            if(count == MAX_LABELS)
+            {
+                throw std::invalid_argument("Too many labels!");
+            }
+            entries[count++] = label{name, address};
+        }
+    };
+
+    // Where the bytes go: nowhere when sizing (N == 0), else into the array.
+    template<std::size_t N>
+    struct output
+    {
+        std::array<uint8_t, N> bytes{};
+        std::size_t            size = 0U;
+
+        constexpr void put(const uint8_t value)
+        {
+            if constexpr(N > 0U)
+            {
+                if(size == N)
+                {
+                    throw std::invalid_argument("Program is larger than its array!");
+                }
+                bytes[size] = value;
+            }
+            ++size;
+        }
+    };
+
+    struct value
+    {
+        uint16_t number = 0U;
+        bool     narrow = false;  // Written as a single byte.
+    };
+
+    // One line being parsed.
+    class cursor
+    {
+    public:
+        constexpr cursor(const std::string_view text, const symbols &labels, const bool resolve, const uint16_t here)
+            : text_(text), labels_(labels), resolve_(resolve), here_(here)
+        {
+        }
+
+        constexpr bool done()
+        {
+            skip_spaces();
+            return pos_ == text_.size();
+        }
+
+        constexpr char peek()
+        {
+            skip_spaces();
+            return pos_ < text_.size() ? text_[pos_] : '\0';
+        }
+
+        constexpr bool accept(const char c)
+        {
+            if(pos_ < text_.size() && upper(peek()) == upper(c))
+            {
+                ++pos_;
+                return true;
+            }
+            return false;
+        }
+
+        constexpr void expect(const char c)
+        {
+            if(!accept(c))
+            {
+                throw std::invalid_argument("Malformed operand!");
+            }
+        }
+
+        // Accepts `,X` or `,Y` if that is all that is left.
+        constexpr bool accept_index(const char reg)
+        {
+            const std::size_t start = pos_;
+            if(accept(',') && accept(reg) && done())
+            {
+                return true;
+            }
+            pos_ = start;
+            return false;
+        }
+
+        // Accepts `word` if that is all that is left.
+        constexpr bool accept_last(const std::string_view word)
+        {
+            const std::size_t start = pos_;
+            if(same_word(identifier(), word) && done())
+            {
+                return true;
+            }
+            pos_ = start;
+            return false;
+        }
+
+        constexpr std::string_view identifier()
+        {
+            skip_spaces();
+            const std::size_t start = pos_;
+            while(pos_ < text_.size() && is_identifier(text_[pos_], pos_ == start))
+            {
+                ++pos_;
+            }
+            return text_.substr(start, pos_ - start);
+        }
+
+        constexpr value expression()
+        {
+            if(accept('<'))
+            {
+                return value{static_cast<uint16_t>(sum() & 0xFFU), true};
+            }
+            if(accept('>'))
+            {
+                return value{static_cast<uint16_t>(sum() >> 8U), true};
+            }
+
+            value result = term();
+            if(peek() == '+' || peek() == '-')
+            {
+                result = value{sum_rest(result.number), false};
+            }
+            return result;
+        }
+
+        // A string literal's characters, with C escapes.
+        template<typename Put>
+        constexpr void string(Put &&put)
+        {
+            expect('"');
+            while(pos_ < text_.size() && text_[pos_] != '"')
+            {
+                put(character());
+            }
+            if(pos_++ == text_.size())
+            {
+                throw std::invalid_argument("Unterminated string!");
+            }
+        }
+
+    private:
+        constexpr void skip_spaces()
+        {
+            while(pos_ < text_.size() && (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\r'))
+            {
+                ++pos_;
+            }
+        }
+
+        constexpr uint16_t sum() { return sum_rest(term().number); }
+
+        constexpr uint16_t sum_rest(uint16_t total)
+        {
+            for(;;)
+            {
+                if(accept('+'))
+                {
+                    total = static_cast<uint16_t>(total + term().number);
+                }
+                else if(accept('-'))
+                {
+                    total = static_cast<uint16_t>(total - term().number);
+                }
+                else
+                {
+                    return total;
+                }
+            }
+        }
+
+        constexpr value term()
+        {
+            const char c = peek();
+            if(c == '$')
+            {
+                ++pos_;
+                return number(16U);
+            }
+            if(c == '%')
+            {
+                ++pos_;
+                return number(2U);
+            }
+            if(c >= '0' && c <= '9')
+            {
+                const value result = number(10U);
+                return value{result.number, result.number < 0x100U};
+            }
+            if(c == '\'')
+            {
+                ++pos_;
+                const uint8_t result = character();
+                expect('\'');
+                return value{result, true};
+            }
+            if(c == '*')
+            {
+                ++pos_;
+                return value{here_, false};
+            }
+
+            const std::string_view name = identifier();
+            if(name.empty())
+            {
+                throw std::invalid_argument("Malformed operand!");
+            }
+            const label *found = labels_.find(name);
+            if(found == nullptr && resolve_)
+            {
+                throw std::invalid_argument("Unknown label!");
+            }
+            // Forward references are sized before they are known.
+            return value{found != nullptr ? found->address : uint16_t{0U}, false};
+        }
+
+        // Digits in `base`; narrow if they fit two hex or eight binary digits.
+        constexpr value number(const uint32_t base)
+        {
+            uint32_t          result = 0U;
+            const std::size_t start  = pos_;
+            for(; pos_ < text_.size(); ++pos_)
+            {
+                const char c     = upper(text_[pos_]);
+                uint32_t   digit = base;
+                if(c >= '0' && c <= '9')
+                {
+                    digit = static_cast<uint32_t>(c - '0');
+                }
+                else if(c >= 'A' && c <= 'F')
+                {
+                    digit = static_cast<uint32_t>(c - 'A' + 10);
+                }
+                if(digit >= base)
+                {
+                    break;
+                }
+                result = result * base + digit;
+                if(result > 0xFFFFU)
+                {
+                    throw std::invalid_argument("Value does not fit in 16 bits!");
+                }
+            }
+            const std::size_t digits = pos_ - start;
+            if(digits == 0U)
+            {
+                throw std::invalid_argument("Malformed number!");
+            }
+            return value{static_cast<uint16_t>(result), (base == 16U && digits <= 2U) || (base == 2U && digits <= 8U)};
+        }
+
+        constexpr uint8_t character()
+        {
+            if(pos_ == text_.size())
+            {
+                throw std::invalid_argument("Malformed character!");
+            }
+            const char c = text_[pos_++];
+            if(c != '\\')
+            {
+                return static_cast<uint8_t>(c);
+            }
+            if(pos_ == text_.size())
+            {
+                throw std::invalid_argument("Malformed character!");
+            }
+            switch(text_[pos_++])
+            {
+                case 'n': return '\n';
+                case 'r': return '\r';
+                case 't': return '\t';
+                case '0': return 0U;
+                case '\\': return '\\';
+                case '\'': return '\'';
+                case '"': return '"';
+                default: throw std::invalid_argument("Unknown escape!");
+            }
+        }
+
+        std::string_view text_;
+        std::size_t      pos_ = 0U;
+        const symbols   &labels_;
+        bool             resolve_;
+        uint16_t         here_;
+    };
+
+    constexpr const encoding *find_encoding(const std::string_view mnemonic, const mode m)
+    {
+        for(const encoding &e : ENCODINGS)
+        {
+            if(e.addressing == m && same_word(e.mnemonic, mnemonic))
+            {
+                return &e;
+            }
+        }
+        return nullptr;
+    }
+
+    // The mode, and the value for it, that `operand` has for `mnemonic`.
+    constexpr const encoding *select(const std::string_view mnemonic, cursor &operand, value &v)
+    {
+        // Picks the first of `modes` the mnemonic has.
+        const auto first_of = [mnemonic](const mode a, const mode b) -> const encoding *
+        {
+            const encoding *found = find_encoding(mnemonic, a);
+            return found != nullptr ? found : find_encoding(mnemonic, b);
+        };
+
+        if(operand.done() || operand.accept_last("A"))
+        {
+            return first_of(mode::IMPLIED, mode::ACCUMULATOR);
+        }
+        if(operand.accept('#'))
+        {
+            v = operand.expression();
+            return find_encoding(mnemonic, mode::IMMEDIATE);
+        }
+        if(operand.accept('('))
+        {
+            v = operand.expression();
+            if(operand.accept(','))
+            {
+                operand.expect('X');
+                operand.expect(')');
+                return find_encoding(mnemonic, mode::INDIRECT_X);
+            }
+            operand.expect(')');
+            if(operand.accept(','))
+            {
+                operand.expect('Y');
+                return find_encoding(mnemonic, mode::INDIRECT_Y);
+            }
+            return find_encoding(mnemonic, mode::INDIRECT);
+        }
+
+        v = operand.expression();
+        if(const encoding *branch = find_encoding(mnemonic, mode::RELATIVE))
+        {
+            return branch;
+        }
+        if(operand.accept_index('X'))
+        {
+            return v.narrow ? first_of(mode::ZERO_PAGE_X, mode::ABSOLUTE_X) : first_of(mode::ABSOLUTE_X, mode::ZERO_PAGE_X);
+        }
+        if(operand.accept_index('Y'))
+        {
+            return v.narrow ? first_of(mode::ZERO_PAGE_Y, mode::ABSOLUTE_Y) : first_of(mode::ABSOLUTE_Y, mode::ZERO_PAGE_Y);
+        }
+        return v.narrow ? first_of(mode::ZERO_PAGE, mode::ABSOLUTE) : first_of(mode::ABSOLUTE, mode::ZERO_PAGE);
+    }
+
+    // Assembles `source` once. The sizing pass (`resolve` false) defines the labels; the
+    // second resolves them and checks what depends on their values.
+    template<std::size_t N>
+    constexpr void pass(const std::string_view source, symbols &labels, const bool resolve, output<N> &out)
+    {
+        uint16_t here     = 0U;
+        bool     placed   = false;  // Whether `.org` still sets the origin without padding.
+        const auto put    = [&out, &here, &placed](const uint8_t value)
+        {
+            out.put(value);
+            ++here;
+            placed = true;
+        };
+        const auto put_word = [&put](const uint16_t value)
+        {
+            put(static_cast<uint8_t>(value));
+            put(static_cast<uint8_t>(value >> 8U));
+        };
+
+        for(std::size_t start = 0U; start <= source.size();)
+        {
+            std::size_t end = source.find('\n', start);
+            if(end == std::string_view::npos)
+            {
+                end = source.size();
+            }
+            std::string_view line = source.substr(start, end - start);
+            start                 = end + 1U;
+
+            // Comments, outside strings and characters.
+            bool quoted = false;
+            for(std::size_t i = 0U; i < line.size(); ++i)
+            {
+                if(line[i] == '"' || (line[i] == '\'' && i + 2U < line.size() && line[i + 2U] == '\''))
+                {
+                    quoted = line[i] == '"' ? !quoted : quoted;
+                    i += line[i] == '\'' ? 2U : 0U;
+                }
+                else if(line[i] == '\\' && quoted)
+                {
+                    ++i;
+                }
+                else if(line[i] == ';' && !quoted)
+                {
+                    line = line.substr(0U, i);
+                    break;
+                }
+            }
+
+            cursor statement(line, labels, resolve, here);
+            if(statement.done())
+            {
+                continue;
+            }
+
+            bool             directive = statement.accept('.');
+            std::string_view word      = statement.identifier();
+            if(!directive && statement.accept(':'))
+            {
+                if(!resolve)
+                {
+                    labels.define(word, here);
+                }
+                if(statement.done())
+                {
+                    continue;
+                }
+                directive = statement.accept('.');
+                word      = statement.identifier();
+            }
+            if(word.empty())
+            {
+                throw std::invalid_argument("Malformed statement!");
+            }
+
+            if(directive && same_word(word, "org"))
+            {
+                const uint16_t origin = statement.expression().number;
+                if(placed && origin < here)
+                {
+                    throw std::invalid_argument(".org moves backwards!");
+                }
+                while(placed && here < origin)
+                {
+                    put(0U);
+                }
+                here = origin;
+            }
+            else if(directive && (same_word(word, "byte") || same_word(word, "word")))
+            {
+                const bool bytes = same_word(word, "byte");
+                do
+                {
+                    if(bytes && statement.peek() == '"')
+                    {
+                        statement.string(put);
+                        continue;
+                    }
+                    const value v = statement.expression();
+                    if(!bytes)
+                    {
+                        put_word(v.number);
+                    }
+                    else if(resolve && v.number > 0xFFU)
+                    {
+                        throw std::invalid_argument("Value does not fit in a byte!");
+                    }
+                    else
+                    {
+                        put(static_cast<uint8_t>(v.number));
+                    }
+                } while(statement.accept(','));
+            }
+            else if(directive)
+            {
+                throw std::invalid_argument("Unknown directive!");
+            }
+            else
+            {
+                value           v;
+                const encoding *e = select(word, statement, v);
+                if(e == nullptr)
+                {
+                    throw std::invalid_argument("Unknown instruction or addressing mode!");
+                }
+
+                const uint16_t address = here;
+                put(static_cast<uint8_t>(e->code));
+                switch(operand_bytes(e->addressing))
+                {
+                    case 2U: put_word(v.number); break;
+                    case 1U:
+                        if(e->addressing == mode::RELATIVE)
+                        {
+                            const int offset = static_cast<int>(v.number) - (address + 2);
+                            if(resolve && (offset < -128 || offset > 127))
+                            {
+                                throw std::invalid_argument("Branch out of range!");
+                            }
+                            put(static_cast<uint8_t>(offset));
+                        }
+                        else if(resolve && v.number > 0xFFU)
+                        {
+                            throw std::invalid_argument("Value does not fit in a byte!");
+                        }
+                        else
+                        {
+                            put(static_cast<uint8_t>(v.number));
+                        }
+                        break;
+                    default: break;
+                }
+            }
+
+            if(!statement.done())
+            {
+                throw std::invalid_argument("Unexpected text after statement!");
+            }
+        }
+    }
+} // namespace detail
+
+// Bytes `source` assembles to.
+constexpr std::size_t assembled_size(const std::string_view source)
+{
+    detail::symbols   labels;
+    detail::output<0U> out;
+    detail::pass(source, labels, false, out);
+    return out.size;
+}
+
+template<std::size_t N>
+constexpr std::array<uint8_t, N> assemble(const std::string_view source)
+{
+    detail::symbols    labels;
+    detail::output<0U> sizing;
+    detail::pass(source, labels, false, sizing);
+    if(sizing.size != N)
+    {
+        throw std::invalid_argument("Program size does not match its array!");
+    }
+
+    detail::output<N> out;
+    detail::pass(source, labels, true, out);
+    return out.bytes;
+}
+
+// `source` is a lambda returning the program text.
+template<typename Source>
+constexpr auto assemble(const Source source)
+{
+    constexpr std::string_view text = source();
+    return assemble<assembled_size(text)>(text);
+}
+
+} // namespace assembler
+
+} // namespace cpu
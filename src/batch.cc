@@ -0,0 +1,149 @@
+#include "batch.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace nes
+{
+
+batch::batch(const cartridge &cart, const std::size_t instances, std::size_t threads)
+{
+    if(instances == 0U)
+    {
+        throw std::invalid_argument("A batch needs at least one instance!");
+    }
+
+    consoles_.reserve(instances);
+    for(std::size_t i = 0U; i < instances; ++i)
+    {
+        consoles_.push_back(std::make_unique<console>(cart));
+    }
+
+    if(threads == 0U)
+    {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    threads = std::min(threads, instances);
+
+    for(std::size_t i = 1U; i < threads; ++i)
+    {
+        workers_.emplace_back([this] { work_loop(); });
+    }
+}
+
+batch::~batch()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    start_.notify_all();
+
+    for(auto &worker : workers_)
+    {
+        worker.join();
+    }
+}
+
+void batch::step(const uint8_t *actions, const uint32_t frames, uint8_t *observations)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job_   = {actions, frames, observations};
+        error_ = nullptr;
+        busy_  = workers_.size();
+        next_.store(0U, std::memory_order_relaxed);
+        ++generation_;
+    }
+    start_.notify_all();
+
+    run_job();
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [this] { return busy_ == 0U; });
+
+    if(error_)
+    {
+        std::rethrow_exception(error_);
+    }
+}
+
+const uint8_t *batch::framebuffer(const std::size_t i)
+{
+    return consoles_[i]->latest_frame().pixels.data();
+}
+
+void batch::work_loop()
+{
+    uint64_t seen = 0U;
+    for(;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_.wait(lock, [this, seen] { return stop_ || generation_ != seen; });
+            if(stop_)
+            {
+                return;
+            }
+            seen = generation_;
+        }
+
+        run_job();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(--busy_ == 0U)
+        {
+            done_.notify_one();
+        }
+    }
+}
+
+void batch::run_job()
+{
+    for(std::size_t i = next_.fetch_add(1U, std::memory_order_relaxed); i < consoles_.size();
+        i = next_.fetch_add(1U, std::memory_order_relaxed))
+    {
+        try
+        {
+            run_instance(i);
+        }
+        catch(...)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if(!error_)
+            {
+                error_ = std::current_exception();
+            }
+        }
+    }
+}
+
+void batch::run_instance(const std::size_t i)
+{
+    console &c = *consoles_[i];
+    c.set_input(0U, job_.actions != nullptr ? job_.actions[i] : 0x00U);
+
+    // Frames skipped over are never looked at, so only the last one is drawn.
+    if(job_.frames > 1U)
+    {
+        c.set_rendering(false);
+        for(uint32_t f = 1U; f < job_.frames; ++f)
+        {
+            c.run_frame();
+        }
+        c.set_rendering(true);
+    }
+    if(job_.frames > 0U)
+    {
+        c.run_frame();
+    }
+
+    if(job_.observations != nullptr)
+    {
+        std::memcpy(job_.observations + i * OBSERVATION_SIZE, c.latest_frame().pixels.data(),
+                    OBSERVATION_SIZE);
+    }
+}
+
+} // namespace nes
@@ -0,0 +1,87 @@
+#include "cartridge.hh"
+#include "console.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#pragma once
+
+//
+// Many consoles stepped together, for training loops.
+//
+// `step()` hands the instances out to a pool of worker threads (the calling thread
+// helps too) and returns once every instance has run. When stepping several frames at
+// once only the last one is drawn. Observations are the palette indices of each
+// instance's last frame, copied from its frame buffer into one caller-provided
+// [instances][240][256] array by the thread that stepped it, while the frame is still
+// in that core's cache. The copy is 60 KiB per instance, a few microseconds against
+// the frame's fraction of a millisecond; `framebuffer()` avoids it.
+//
+
+namespace nes
+{
+
+class batch
+{
+public:
+    static constexpr std::size_t OBSERVATION_SIZE = ppu::SCREEN_WIDTH * ppu::SCREEN_HEIGHT;
+
+    // `threads` counts the calling thread; zero means one per hardware thread.
+    batch(const cartridge &cart, std::size_t instances, std::size_t threads = 0U);
+    ~batch();
+
+    batch(const batch &)            = delete;
+    batch &operator=(const batch &) = delete;
+
+    // Runs `frames` frames on every instance with `actions[i]` held on instance i's
+    // first controller. If `observations` is not null, instance i's last frame goes to
+    // `observations + i * OBSERVATION_SIZE`. Rethrows the first instance's exception.
+    void step(const uint8_t *actions, uint32_t frames, uint8_t *observations);
+
+    std::size_t size() const { return consoles_.size(); }
+    std::size_t threads() const { return workers_.size() + 1U; }
+
+    console &instance(const std::size_t i) { return *consoles_[i]; }
+
+    // Instance i's work RAM and last frame's pixels. The frame pointer stays valid
+    // until the next `step()`.
+    const uint8_t *ram(const std::size_t i) const { return consoles_[i]->ram().data(); }
+    const uint8_t *framebuffer(std::size_t i);
+
+private:
+    struct job
+    {
+        const uint8_t *actions;
+        uint32_t       frames;
+        uint8_t       *observations;
+    };
+
+    void work_loop();
+
+    // Steps instances until none are left to claim.
+    void run_job();
+    void run_instance(std::size_t i);
+
+    std::vector<std::unique_ptr<console>> consoles_;
+    std::vector<std::thread>              workers_;
+
+    std::mutex              mutex_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    uint64_t                generation_ = 0U;  // Bumped for every job.
+    std::size_t             busy_       = 0U;  // Workers still on the current job.
+    bool                    stop_       = false;
+
+    job                      job_{};
+    std::atomic<std::size_t> next_{0U};
+    std::exception_ptr       error_;
+};
+
+} // namespace nes
@@ -0,0 +1,80 @@
+#include "battery.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace nes
+{
+
+battery_file::battery_file(const std::string &path, const std::size_t size)
+    : size_(size)
+{
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if(fd < 0)
+    {
+        throw std::runtime_error("Failed to open save file!");
+    }
+
+    // New and short files are extended with zeros; longer ones keep their tail.
+    struct stat info;
+    if(fstat(fd, &info) != 0 ||
+       (static_cast<std::size_t>(info.st_size) < size && ftruncate(fd, static_cast<off_t>(size)) != 0))
+    {
+        close(fd);
+        throw std::runtime_error("Failed to size save file!");
+    }
+
+    void *mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map save file!");
+    }
+    data_ = static_cast<uint8_t *>(mapping);
+    flushed_.assign(data_, data_ + size_);
+}
+
+battery_file::~battery_file()
+{
+    flush();
+    munmap(data_, size_);
+}
+
+void battery_file::flush()
+{
+    if(private_ || std::memcmp(data_, flushed_.data(), size_) == 0)
+    {
+        return;
+    }
+
+    if(msync(data_, size_, MS_SYNC) == 0)
+    {
+        std::memcpy(flushed_.data(), data_, size_);
+        ++flushes_;
+    }
+}
+
+void battery_file::make_private()
+{
+    if(private_)
+    {
+        return;
+    }
+
+    const std::vector<uint8_t> contents(data_, data_ + size_);
+    void *mapping = mmap(data_, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+    if(mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to detach save file!");
+    }
+    std::memcpy(data_, contents.data(), size_);
+    private_ = true;
+}
+
+} // namespace nes
@@ -0,0 +1,56 @@
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma once
+
+//
+// Battery-backed PRG-RAM kept in a save file.
+//
+// The file is mapped shared and the console puts the mapping straight into its page
+// table, so the game's writes land in the page cache with nothing copied: a crash of
+// the process loses nothing. `flush()` writes the pages out with msync; the console
+// calls it at the end of committed frames that wrote PRG-RAM, which bounds what an OS
+// crash or power loss can lose to the current frame.
+//
+
+namespace nes
+{
+
+class battery_file
+{
+public:
+    // Maps the first `size` bytes of `path`, creating or zero-extending it as needed.
+    // Throws std::runtime_error on failure.
+    battery_file(const std::string &path, std::size_t size);
+
+    // Flushes and unmaps.
+    ~battery_file();
+
+    battery_file(const battery_file &)            = delete;
+    battery_file &operator=(const battery_file &) = delete;
+
+    uint8_t    *data() { return data_; }
+    std::size_t size() const { return size_; }
+
+    // Writes modified pages to the file and waits for them, unless the contents are
+    // what the last flush wrote, as after a speculative write is undone.
+    void flush();
+
+    // Replaces the mapping, at the same address, with private memory holding the same
+    // contents, so later writes no longer reach the file. Used by forked workers.
+    void make_private();
+    bool is_private() const { return private_; }
+
+    uint64_t flushes() const { return flushes_; }
+
+private:
+    uint8_t             *data_ = nullptr;
+    std::size_t          size_ = 0U;
+    std::vector<uint8_t> flushed_;  // The file's contents as of the last flush.
+    bool                 private_ = false;
+    uint64_t             flushes_ = 0U;
+};
+
+} // namespace nes
@@ -0,0 +1,129 @@
+#include "blip_buffer.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace apu
+{
+
+namespace
+{
+    constexpr double PI = 3.14159265358979323846;
+
+    // Fraction of the output Nyquist rate that the kernel passes.
+    constexpr double CUTOFF = 0.9;
+
+    // Output scale and DC-blocker pole.
+    constexpr float OUTPUT_SCALE = 30000.0F;
+    constexpr float DC_POLE      = 1.0F / 1024.0F;
+} // namespace
+
+blip_buffer::blip_buffer(const uint32_t clock_rate, const uint32_t sample_rate, const std::size_t max_samples)
+    : factor_(static_cast<uint64_t>(std::ceil(std::ldexp(static_cast<double>(sample_rate) / clock_rate, FRAC_BITS)))),
+      max_samples_(max_samples),
+      buffer_(max_samples + KERNEL_WIDTH, 0.0F)
+{
+    // Windowed-sinc impulse for every sub-sample phase, each normalised to unit gain so
+    // that a step integrates back to exactly its height.
+    const double half = KERNEL_WIDTH / 2.0;
+
+    for(std::size_t phase = 0U; phase < PHASES; ++phase)
+    {
+        const double frac = static_cast<double>(phase) / PHASES;
+        double       sum  = 0.0;
+        std::array<double, KERNEL_WIDTH> taps;
+
+        for(std::size_t tap = 0U; tap < KERNEL_WIDTH; ++tap)
+        {
+            const double x      = (static_cast<double>(tap) - half + 1.0) - frac;
+            const double sinc   = (x == 0.0) ? 1.0 : std::sin(PI * CUTOFF * x) / (PI * CUTOFF * x);
+            const double w      = (x + half) / KERNEL_WIDTH;
+            const double window = 0.42 - 0.5 * std::cos(2.0 * PI * w) + 0.08 * std::cos(4.0 * PI * w);
+
+            taps[tap] = sinc * std::max(window, 0.0);
+            sum += taps[tap];
+        }
+
+        for(std::size_t tap = 0U; tap < KERNEL_WIDTH; ++tap)
+        {
+            kernel_[phase][tap] = static_cast<float>(taps[tap] / sum);
+        }
+    }
+}
+
+void blip_buffer::add_delta(const uint64_t clock, const float delta)
+{
+    const uint64_t    position = offset_ + (clock * factor_);
+    const std::size_t index    = static_cast<std::size_t>(position >> FRAC_BITS);
+    const std::size_t phase    = static_cast<std::size_t>(position >> (FRAC_BITS - PHASE_BITS)) & (PHASES - 1U);
+
+    if(index >= max_samples_)
+    {
+        // Caller ran past `clocks_until_full()`; drop rather than write out of bounds.
+        return;
+    }
+
+    float       *out    = &buffer_[index];
+    const float *kernel = kernel_[phase].data();
+
+#if defined(__SSE2__)
+    const __m128 scale = _mm_set1_ps(delta);
+    for(std::size_t tap = 0U; tap < KERNEL_WIDTH; tap += 4U)
+    {
+        const __m128 k = _mm_loadu_ps(kernel + tap);
+        const __m128 o = _mm_loadu_ps(out + tap);
+        _mm_storeu_ps(out + tap, _mm_add_ps(o, _mm_mul_ps(k, scale)));
+    }
+#else
+    for(std::size_t tap = 0U; tap < KERNEL_WIDTH; ++tap)
+    {
+        out[tap] += kernel[tap] * delta;
+    }
+#endif
+}
+
+void blip_buffer::end_frame(const uint64_t clocks)
+{
+    offset_ += clocks * factor_;
+}
+
+uint64_t blip_buffer::clocks_until_full() const
+{
+    const uint64_t limit = static_cast<uint64_t>(max_samples_) << FRAC_BITS;
+    return (limit > offset_) ? (limit - offset_) / factor_ : 0U;
+}
+
+std::size_t blip_buffer::read_samples(int16_t *out, const std::size_t count)
+{
+    const std::size_t n = std::min(count, samples_available());
+
+    for(std::size_t i = 0U; i < n; ++i)
+    {
+        integrator_ += buffer_[i];
+        dc_ += (integrator_ - dc_) * DC_POLE;
+
+        const float sample = (integrator_ - dc_) * OUTPUT_SCALE;
+        out[i] = static_cast<int16_t>(std::clamp(sample, -32768.0F, 32767.0F));
+    }
+
+    // Shift the unfinished tail (including pending kernel taps) to the front.
+    std::copy(buffer_.begin() + n, buffer_.end(), buffer_.begin());
+    std::fill(buffer_.end() - n, buffer_.end(), 0.0F);
+    offset_ -= static_cast<uint64_t>(n) << FRAC_BITS;
+
+    return n;
+}
+
+void blip_buffer::clear()
+{
+    std::fill(buffer_.begin(), buffer_.end(), 0.0F);
+    offset_     = 0U;
+    integrator_ = 0.0F;
+    dc_         = 0.0F;
+}
+
+} // namespace apu
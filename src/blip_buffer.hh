@@ -0,0 +1,66 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#pragma once
+
+//
+// Band-limited delta synthesizer.
+//
+// Channels report amplitude *changes* along with the clock cycle they happened on,
+// instead of being sampled every cycle. Each change is added into the output buffer
+// as a band-limited impulse (a polyphase windowed-sinc FIR kernel picked by the
+// sub-sample position of the change), and reading integrates the impulses back into
+// a waveform. Adding the kernel is the only per-change cost, and is done 4 taps at a
+// time with SSE2 where available. This resamples straight from the CPU clock to the
+// output rate without ever producing a sample at the CPU rate.
+//
+
+namespace apu
+{
+
+class blip_buffer
+{
+public:
+    // Kernel geometry.
+    static constexpr std::size_t KERNEL_WIDTH = 16U;  // Taps per impulse.
+    static constexpr std::size_t PHASE_BITS   = 6U;
+    static constexpr std::size_t PHASES       = 1U << PHASE_BITS;
+
+    blip_buffer(uint32_t clock_rate, uint32_t sample_rate, std::size_t max_samples);
+
+    // Add an amplitude change of `delta` at `clock` cycles after the start of the
+    // current frame.
+    void add_delta(uint64_t clock, float delta);
+
+    // Ends the current frame `clocks` cycles after its start, making the samples it
+    // covered available to `read_samples`.
+    void end_frame(uint64_t clocks);
+
+    // Number of clocks that can be added before `max_samples` is exceeded.
+    uint64_t clocks_until_full() const;
+
+    std::size_t samples_available() const { return static_cast<std::size_t>(offset_ >> FRAC_BITS); }
+
+    // Reads up to `count` finished samples, returns the number read.
+    std::size_t read_samples(int16_t *out, std::size_t count);
+
+    void clear();
+
+private:
+    static constexpr uint32_t FRAC_BITS = 32U;
+
+    uint64_t           factor_;       // Output samples per clock, 32.32 fixed-point.
+    uint64_t           offset_ = 0U;  // Start of the current frame, 32.32 fixed-point.
+    std::size_t        max_samples_;
+    std::vector<float> buffer_;
+
+    std::array<std::array<float, KERNEL_WIDTH>, PHASES> kernel_;
+
+    // Integrator and DC-blocker state.
+    float integrator_ = 0.0F;
+    float dc_         = 0.0F;
+};
+
+} // namespace apu
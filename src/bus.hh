@@ -0,0 +1,124 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+
+#pragma once
+
+//
+// CPU address space as a table of 256-byte pages.
+//
+// Pages backed by plain memory (RAM, PRG-ROM, PRG-RAM) point straight at it, so an
+// access is one table lookup and one load/store. Pages left unmapped (null) belong to
+// I/O and are handed to the owner's register handlers instead.
+//
+// Each writable page also points at a dirty flag for its backing memory, set on every
+// write, so that state hashing only has to look at pages that changed.
+//
+// A page can be watched: it stays mapped, but its reads and/or writes are sent to the
+// I/O handlers, which find the memory through `mapped_read_page()` and
+// `mapped_write_page()`. Only watched pages pay for the detour.
+//
+
+namespace nes
+{
+
+class memory_map
+{
+public:
+    static constexpr uint32_t    PAGE_BITS  = 8U;
+    static constexpr std::size_t PAGE_SIZE  = 1U << PAGE_BITS;
+    static constexpr std::size_t PAGE_COUNT = 0x10000U / PAGE_SIZE;
+
+    enum class access : uint8_t
+    {
+        READ_ONLY,
+        READ_WRITE
+    };
+
+    memory_map() { dirty_.fill(&discard_); }
+
+    memory_map(const memory_map &)            = delete;
+    memory_map &operator=(const memory_map &) = delete;
+
+    // Maps `[address, address + size)` onto `memory`, repeating it if the range is larger
+    // (mirroring). Both sizes must be whole pages. `dirty`, if given, holds one flag per
+    // page of `memory`.
+    void map(const uint16_t address, const std::size_t size, uint8_t *memory, const std::size_t memory_size,
+             const access a, uint8_t *dirty = nullptr)
+    {
+        if((address % PAGE_SIZE) != 0U || (size % PAGE_SIZE) != 0U || (memory_size % PAGE_SIZE) != 0U ||
+           memory_size == 0U || address + size > 0x10000U)
+        {
+            throw std::invalid_argument("Mappings must cover whole pages!");
+        }
+
+        for(std::size_t offset = 0U; offset < size; offset += PAGE_SIZE)
+        {
+            const std::size_t page = (address + offset) >> PAGE_BITS;
+            uint8_t *target        = memory + (offset % memory_size);
+
+            mapped_read_[page]  = target;
+            mapped_write_[page] = (a == access::READ_WRITE) ? target : nullptr;
+            dirty_[page]        = (dirty != nullptr) ? dirty + ((offset % memory_size) / PAGE_SIZE) : &discard_;
+            apply_watch(page);
+        }
+    }
+
+    // Hands `[address, address + size)` back to the I/O handlers.
+    void unmap(const uint16_t address, const std::size_t size)
+    {
+        for(std::size_t offset = 0U; offset < size; offset += PAGE_SIZE)
+        {
+            const std::size_t page = (address + offset) >> PAGE_BITS;
+
+            mapped_read_[page]  = nullptr;
+            mapped_write_[page] = nullptr;
+            dirty_[page]        = &discard_;
+            apply_watch(page);
+        }
+    }
+
+    // Sends reads and/or writes of the page containing `address` to the I/O handlers,
+    // or with both false, returns it to the fast path.
+    void watch(const uint16_t address, const bool reads, const bool writes)
+    {
+        const std::size_t page = address >> PAGE_BITS;
+
+        watch_reads_[page]  = reads;
+        watch_writes_[page] = writes;
+        apply_watch(page);
+    }
+
+    // Backing memory for the page containing `address`, or null for I/O.
+    const uint8_t *read_page(const uint16_t address) const { return read_[address >> PAGE_BITS]; }
+    uint8_t       *write_page(const uint16_t address) const { return write_[address >> PAGE_BITS]; }
+
+    // The same, watched or not.
+    const uint8_t *mapped_read_page(const uint16_t address) const { return mapped_read_[address >> PAGE_BITS]; }
+    uint8_t       *mapped_write_page(const uint16_t address) const { return mapped_write_[address >> PAGE_BITS]; }
+
+    // Flags the backing page of `address` as written.
+    void mark_dirty(const uint16_t address) { *dirty_[address >> PAGE_BITS] = 1U; }
+
+private:
+    void apply_watch(const std::size_t page)
+    {
+        read_[page]  = watch_reads_[page] ? nullptr : mapped_read_[page];
+        write_[page] = watch_writes_[page] ? nullptr : mapped_write_[page];
+    }
+
+    // What the accessors hand out, with watched pages nulled.
+    std::array<const uint8_t *, PAGE_COUNT> read_{};
+    std::array<uint8_t *, PAGE_COUNT>       write_{};
+    std::array<uint8_t *, PAGE_COUNT>       dirty_{};
+
+    std::array<const uint8_t *, PAGE_COUNT> mapped_read_{};
+    std::array<uint8_t *, PAGE_COUNT>       mapped_write_{};
+    std::array<bool, PAGE_COUNT>            watch_reads_{};
+    std::array<bool, PAGE_COUNT>            watch_writes_{};
+
+    uint8_t discard_ = 0U;  // Dirty flag for pages nobody tracks.
+};
+
+} // namespace nes
@@ -0,0 +1,129 @@
+#include "cartridge.hh"
+#include "utils.hh"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+
+namespace nes
+{
+
+namespace
+{
+    constexpr std::size_t HEADER_SIZE  = 16U;
+    constexpr std::size_t TRAINER_SIZE = 512U;
+
+    // Flags 6
+    constexpr uint8_t FLAG_VERTICAL    = 1U << 0U;
+    constexpr uint8_t FLAG_BATTERY     = 1U << 1U;
+    constexpr uint8_t FLAG_TRAINER     = 1U << 2U;
+    constexpr uint8_t FLAG_FOUR_SCREEN = 1U << 3U;
+
+    void check_header(const std::vector<uint8_t> &image)
+    {
+        if(image.size() < HEADER_SIZE || image[0] != 'N' || image[1] != 'E' || image[2] != 'S' ||
+           image[3] != 0x1AU)
+        {
+            throw std::runtime_error("Not an iNES image!");
+        }
+    }
+
+    std::size_t prg_offset(const std::vector<uint8_t> &image)
+    {
+        return HEADER_SIZE + ((image[6] & FLAG_TRAINER) ? TRAINER_SIZE : 0U);
+    }
+} // namespace
+
+cartridge load_ines(const std::vector<uint8_t> &image)
+{
+    check_header(image);
+
+    const std::size_t prg_size = image[4] * PRG_BANK_SIZE;
+    const std::size_t chr_size = image[5] * CHR_BANK_SIZE;
+    const uint8_t     flags_6  = image[6];
+    const uint8_t     flags_7  = image[7];
+
+    cartridge cart;
+    cart.mapper  = static_cast<uint8_t>((flags_7 & 0xF0U) | (flags_6 >> 4U));
+    cart.battery = (flags_6 & FLAG_BATTERY) != 0U;
+    cart.mode    = (flags_6 & FLAG_FOUR_SCREEN) ? ppu::mirroring::FOUR_SCREEN
+                 : (flags_6 & FLAG_VERTICAL)    ? ppu::mirroring::VERTICAL
+                                                : ppu::mirroring::HORIZONTAL;
+
+    if(cart.mapper != 0U)
+    {
+        throw std::runtime_error("Unsupported mapper!");
+    }
+
+    if(prg_size != PRG_BANK_SIZE && prg_size != 2U * PRG_BANK_SIZE)
+    {
+        throw std::runtime_error("NROM carts have 16 or 32 KiB of PRG-ROM!");
+    }
+
+    const std::size_t prg_start = prg_offset(image);
+    if(image.size() < prg_start + prg_size + chr_size)
+    {
+        throw std::runtime_error("iNES image is truncated!");
+    }
+
+    cart.prg_rom.assign(image.begin() + prg_start, image.begin() + prg_start + prg_size);
+
+    if(chr_size == 0U)
+    {
+        cart.chr_ram = true;
+        cart.chr.assign(CHR_BANK_SIZE, 0x00U);
+    }
+    else
+    {
+        const auto chr_start = image.begin() + prg_start + prg_size;
+        cart.chr.assign(chr_start, chr_start + CHR_BANK_SIZE);
+    }
+
+    cart.hash = utils::hash64(image.data() + prg_start, prg_size + chr_size);
+    return cart;
+}
+
+cartridge load_ines(const std::string &file_path)
+{
+    return load_ines(utils::read_file(file_path));
+}
+
+std::vector<uint8_t> ines_prg(const std::vector<uint8_t> &image)
+{
+    check_header(image);
+
+    const std::size_t prg_start = prg_offset(image);
+    const std::size_t prg_size  = image[4] * PRG_BANK_SIZE;
+    if(prg_size == 0U || image.size() < prg_start + prg_size)
+    {
+        throw std::runtime_error("iNES image is truncated!");
+    }
+    return std::vector<uint8_t>(image.begin() + prg_start, image.begin() + prg_start + prg_size);
+}
+
+std::vector<std::string> find_roms(const std::vector<std::string> &paths)
+{
+    std::vector<std::string> roms;
+    for(const std::string &path : paths)
+    {
+        if(!std::filesystem::is_directory(path))
+        {
+            roms.push_back(path);
+            continue;
+        }
+
+        std::vector<std::string> found;
+        for(const auto &entry : std::filesystem::recursive_directory_iterator(path))
+        {
+            if(entry.is_regular_file() && entry.path().extension() == ".nes")
+            {
+                found.push_back(entry.path().string());
+            }
+        }
+        std::sort(found.begin(), found.end());
+        roms.insert(roms.end(), found.begin(), found.end());
+    }
+    return roms;
+}
+
+} // namespace nes
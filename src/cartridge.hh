@@ -0,0 +1,48 @@
+#include "ppu.hh"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma once
+
+//
+// iNES cartridge images.
+//
+// Only mapper 0 (NROM) is supported: 16 or 32 KiB of PRG-ROM at $8000, 8 KiB of
+// CHR-ROM (or CHR-RAM when the image has none) and optional PRG-RAM at $6000.
+//
+
+namespace nes
+{
+
+constexpr std::size_t PRG_BANK_SIZE = 0x4000U;
+constexpr std::size_t CHR_BANK_SIZE = 0x2000U;
+constexpr std::size_t PRG_RAM_SIZE  = 0x2000U;
+
+struct cartridge
+{
+    std::vector<uint8_t> prg_rom;
+    std::vector<uint8_t> chr;              // CHR-ROM, or zeroed CHR-RAM.
+    bool                 chr_ram = false;
+    bool                 battery = false;  // PRG-RAM is battery backed.
+    uint8_t              mapper  = 0U;
+    ppu::mirroring       mode    = ppu::mirroring::HORIZONTAL;
+
+    // Hash of the PRG and CHR contents, used to tie movies and caches to a ROM.
+    uint64_t hash = 0U;
+};
+
+// Parses an iNES image. Throws std::runtime_error if the image is malformed or uses
+// an unsupported mapper.
+cartridge load_ines(const std::vector<uint8_t> &image);
+cartridge load_ines(const std::string &file_path);
+
+// PRG-ROM of an iNES image with any mapper, for tools that only look at the code.
+// Throws std::runtime_error if the image is malformed.
+std::vector<uint8_t> ines_prg(const std::vector<uint8_t> &image);
+
+// `paths` with each directory replaced by the *.nes files under it, in name order.
+std::vector<std::string> find_roms(const std::vector<std::string> &paths);
+
+} // namespace nes
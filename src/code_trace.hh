@@ -0,0 +1,108 @@
+#include "interpreter.hh"
+
+#include <cstdint>
+#include <vector>
+
+#pragma once
+
+//
+// Static control-flow tracing of PRG-ROM, shared by the ROM analyses: predecode, and
+// the disassembler's reachability statistics.
+//
+
+namespace cpu
+{
+
+// Conditional branches: BPL, BMI, BVC, BVS, BCC, BCS, BNE and BEQ.
+constexpr bool is_branch(const uint8_t opcode)
+{
+    return (opcode & 0x1FU) == 0x10U;
+}
+
+// The JAM/KIL opcodes, which lock up the CPU.
+constexpr bool is_halt(const uint8_t opcode)
+{
+    return (opcode & 0x0FU) == 0x02U && (opcode < 0x80U || (opcode & 0x10U) != 0U);
+}
+
+// Instructions after which execution may not simply go on to the next one.
+constexpr bool ends_block(const uint8_t opcode)
+{
+    using op::codes;
+    return is_branch(opcode) || is_halt(opcode) || opcode == static_cast<uint8_t>(codes::JMP_ABSOLUTE) ||
+           opcode == static_cast<uint8_t>(codes::JMP_INDIRECT) || opcode == static_cast<uint8_t>(codes::JSR_ABSOLUTE) ||
+           opcode == static_cast<uint8_t>(codes::RTS) || opcode == static_cast<uint8_t>(codes::RTI) ||
+           opcode == static_cast<uint8_t>(codes::BRK);
+}
+
+// Follows every path from the reset, NMI and IRQ vectors until it leaves $8000 - $FFFF,
+// returns, jumps indirectly, halts or joins code already traced. The callbacks:
+//
+//     uint8_t read(uint16_t address)                   The byte the CPU sees there.
+//     void    enter(uint16_t address, bool jumped)     A path starts here: at a vector,
+//                                                      or a branch, JSR or JMP target.
+//     bool    visit(uint16_t address, uint8_t opcode)  An instruction on a path; false
+//                                                      if already traced, ending it.
+template<typename Read, typename Enter, typename Visit>
+void trace_code(const Read &read, const Enter &enter, const Visit &visit)
+{
+    constexpr uint32_t PRG_START = 0x8000U;
+    constexpr uint32_t END       = 0x10000U;
+
+    const auto word = [&read](const uint32_t address)
+    {
+        return static_cast<uint16_t>(read(static_cast<uint16_t>(address)) |
+                                     (read(static_cast<uint16_t>(address + 1U)) << 8U));
+    };
+
+    std::vector<uint16_t> pending;
+    const auto            start = [&](const uint16_t address, const bool jumped)
+    {
+        if(address >= PRG_START)
+        {
+            enter(address, jumped);
+            pending.push_back(address);
+        }
+    };
+
+    start(word(RESET_VECTOR), false);
+    start(word(NMI_VECTOR), false);
+    start(word(IRQ_VECTOR), false);
+
+    while(!pending.empty())
+    {
+        uint32_t pc = pending.back();
+        pending.pop_back();
+
+        while(pc < END)
+        {
+            const uint8_t  opcode = read(static_cast<uint16_t>(pc));
+            const uint32_t next   = pc + LENGTHS[opcode];
+            if(next > END || !visit(static_cast<uint16_t>(pc), opcode))
+            {
+                break;
+            }
+
+            if(is_branch(opcode))
+            {
+                start(static_cast<uint16_t>(next + static_cast<int8_t>(read(static_cast<uint16_t>(pc + 1U)))), true);
+            }
+            else if(opcode == static_cast<uint8_t>(op::codes::JSR_ABSOLUTE))
+            {
+                start(word(pc + 1U), true);
+            }
+            else if(opcode == static_cast<uint8_t>(op::codes::JMP_ABSOLUTE))
+            {
+                start(word(pc + 1U), true);
+                break;
+            }
+            else if(ends_block(opcode))
+            {
+                break;
+            }
+            pc = next;
+        }
+    }
+}
+
+} // namespace cpu
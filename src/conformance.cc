@@ -0,0 +1,306 @@
+#include "conformance.hh"
+
+#include "console.hh"
+#include "interpreter.hh"
+#include "utils.hh"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace nes
+{
+
+namespace
+{
+    constexpr std::size_t CONTEXT_LINES = 4U;  // Instructions shown before a divergence.
+
+    constexpr uint16_t STATUS_ADDRESS  = 0x6000U;
+    constexpr uint8_t  STATUS_RUNNING  = 0x80U;
+    constexpr uint8_t  STATUS_RESET    = 0x81U;
+    constexpr uint16_t MESSAGE_ADDRESS = 0x6004U;
+
+    constexpr std::array<uint8_t, 3U> STATUS_SIGNATURE = {0xDEU, 0xB0U, 0x61U};
+
+    // Flags the logs leave out or always set.
+    constexpr uint8_t P_IGNORED = 0x30U;
+
+    // NROM memory without the PPU and APU: enough for CPU-only trace ROMs, and free of
+    // read side effects so the trace can show instruction bytes.
+    class trace_bus
+    {
+    public:
+        explicit trace_bus(const cartridge &cart) : prg_(cart.prg_rom) {}
+
+        uint8_t read(const uint16_t address) const
+        {
+            if(address < 0x2000U)
+            {
+                return ram_[address & (RAM_SIZE - 1U)];
+            }
+            if(address >= 0x8000U)
+            {
+                return prg_[(address - 0x8000U) % prg_.size()];
+            }
+            if(address >= 0x6000U)
+            {
+                return prg_ram_[address - 0x6000U];
+            }
+            return static_cast<uint8_t>(address >> 8U);  // Open bus.
+        }
+
+        void write(const uint16_t address, const uint8_t value)
+        {
+            if(address < 0x2000U)
+            {
+                ram_[address & (RAM_SIZE - 1U)] = value;
+            }
+            else if(address >= 0x6000U && address < 0x8000U)
+            {
+                prg_ram_[address - 0x6000U] = value;
+            }
+        }
+
+    private:
+        const std::vector<uint8_t>        &prg_;
+        std::array<uint8_t, RAM_SIZE>     ram_{};
+        std::array<uint8_t, PRG_RAM_SIZE> prg_ram_{};
+    };
+
+    std::string trace_line(const trace_bus &bus, const cpu::state &s)
+    {
+        const uint8_t             opcode = bus.read(s.pc);
+        std::array<uint8_t, 3U> bytes  = {opcode, bus.read(s.pc + 1U), bus.read(s.pc + 2U)};
+        return format_trace_line(s, bytes.data(), cpu::LENGTHS[opcode]);
+    }
+
+    bool matches(const trace_fields &expected, const cpu::state &s)
+    {
+        return expected.pc == s.pc && expected.a == s.reg_a && expected.x == s.reg_x && expected.y == s.reg_y &&
+               (expected.p & ~P_IGNORED) == (s.status.to_byte() & ~P_IGNORED) && expected.sp == (s.sp & 0xFFU) &&
+               (!expected.timed || expected.cycles == s.cycles);
+    }
+
+    // Hex value following `key` in `line`.
+    bool field(const std::string &line, const char *key, uint8_t &out)
+    {
+        const std::size_t at = line.find(key);
+        if(at == std::string::npos)
+        {
+            return false;
+        }
+        const char *start = line.c_str() + at + std::char_traits<char>::length(key);
+        char       *end   = nullptr;
+        out               = static_cast<uint8_t>(std::strtoul(start, &end, 16));
+        return end != start;
+    }
+
+    conformance_result run_path(const std::string &path, const uint64_t max_frames)
+    {
+        conformance_result result;
+        try
+        {
+            const cartridge cart = load_ines(utils::read_file(path));
+
+            const std::string golden_path = std::filesystem::path(path).replace_extension(".log").string();
+            std::ifstream     golden(golden_path);
+            result = golden ? run_trace(cart, golden) : run_status_rom(cart, max_frames);
+        }
+        catch(const std::exception &e)
+        {
+            result.passed = false;
+            result.detail = e.what();
+        }
+        result.rom = path;
+        return result;
+    }
+} // namespace
+
+bool parse_trace_line(const std::string &line, trace_fields &out)
+{
+    char *end = nullptr;
+    out.pc    = static_cast<uint16_t>(std::strtoul(line.c_str(), &end, 16));
+    if(end != line.c_str() + 4)
+    {
+        return false;
+    }
+
+    if(!field(line, " A:", out.a) || !field(line, " X:", out.x) || !field(line, " Y:", out.y) ||
+       !field(line, " P:", out.p) || !field(line, " SP:", out.sp))
+    {
+        return false;
+    }
+
+    // Logs with a "PPU:" field count CPU cycles in "CYC:". In the original nestest.log
+    // format ("SP:FD CYC:  0 SL:241"), "CYC:" is the PPU dot, which says nothing about
+    // the CPU's cycle count.
+    const std::size_t cycles = line.find(" CYC:");
+    out.timed                = cycles != std::string::npos && line.find(" PPU:") != std::string::npos;
+    if(out.timed)
+    {
+        out.cycles = std::strtoull(line.c_str() + cycles + 5U, nullptr, 10);
+    }
+    return true;
+}
+
+std::string format_trace_line(const cpu::state &s, const uint8_t *bytes, const std::size_t length)
+{
+    std::ostringstream out;
+    out << std::hex << std::uppercase << std::setfill('0') << std::setw(4) << s.pc << " ";
+    for(std::size_t i = 0U; i < 3U; ++i)
+    {
+        if(i < length)
+        {
+            out << " " << std::setw(2) << static_cast<unsigned>(bytes[i]);
+        }
+        else
+        {
+            out << "   ";
+        }
+    }
+    out << "  A:" << std::setw(2) << static_cast<unsigned>(s.reg_a) << " X:" << std::setw(2)
+        << static_cast<unsigned>(s.reg_x) << " Y:" << std::setw(2) << static_cast<unsigned>(s.reg_y)
+        << " P:" << std::setw(2) << static_cast<unsigned>(s.status.to_byte()) << " SP:" << std::setw(2)
+        << (s.sp & 0xFFU) << std::dec << " CYC:" << s.cycles;
+    return out.str();
+}
+
+conformance_result run_trace(const cartridge &cart, std::istream &golden)
+{
+    conformance_result result;
+    trace_bus          bus(cart);
+    cpu::state         s;
+
+    // The last few instructions run, for context.
+    std::array<std::string, CONTEXT_LINES> context;
+    std::size_t                            context_count = 0U;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    std::string  line;
+    trace_fields expected;
+    uint64_t     number = 0U;
+    while(std::getline(golden, line))
+    {
+        ++number;
+        if(line.empty() || line == "\r")
+        {
+            continue;
+        }
+        if(!parse_trace_line(line, expected))
+        {
+            result.detail = "Unreadable golden log line " + std::to_string(number) + ": " + line;
+            break;
+        }
+
+        // The log's first line is where the run starts.
+        if(result.instructions == 0U)
+        {
+            s.pc    = expected.pc;
+            s.reg_a = expected.a;
+            s.reg_x = expected.x;
+            s.reg_y = expected.y;
+            s.sp    = expected.sp;
+            s.status.from_byte(expected.p & ~P_IGNORED);
+            s.cycles = expected.timed ? expected.cycles : 0U;
+        }
+
+        if(!matches(expected, s))
+        {
+            std::ostringstream detail;
+            for(std::size_t i = context_count > CONTEXT_LINES ? context_count - CONTEXT_LINES : 0U; i < context_count; ++i)
+            {
+                detail << "           " << context[i % CONTEXT_LINES] << "\n";
+            }
+            detail << "  expected " << line << "\n"
+                   << "       got " << trace_line(bus, s) << "\n"
+                   << "  at golden log line " << number;
+            result.detail = detail.str();
+            break;
+        }
+
+        context[context_count++ % CONTEXT_LINES] = trace_line(bus, s);
+        cpu::step(bus, s);
+        ++result.instructions;
+    }
+
+    result.passed  = result.detail.empty() && result.instructions > 0U;
+    result.cycles  = s.cycles;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    if(result.detail.empty() && result.instructions == 0U)
+    {
+        result.detail = "Golden log is empty";
+    }
+    return result;
+}
+
+conformance_result run_status_rom(const cartridge &cart, const uint64_t max_frames)
+{
+    conformance_result result;
+    console            c(cart);
+    c.set_audio(false);
+
+    const auto start = std::chrono::steady_clock::now();
+
+    bool done = false;
+    for(uint64_t frame = 0U; frame < max_frames && !done; ++frame)
+    {
+        c.run_frame();
+
+        const uint8_t *ram    = c.prg_ram();
+        const uint8_t  status = ram[0];
+        if(!std::equal(STATUS_SIGNATURE.begin(), STATUS_SIGNATURE.end(), ram + 1U) || status == STATUS_RUNNING)
+        {
+            continue;
+        }
+
+        done = true;
+        if(status == STATUS_RESET)
+        {
+            result.detail = "ROM asks for a reset, which is not supported";
+            break;
+        }
+
+        const char       *message = reinterpret_cast<const char *>(ram + (MESSAGE_ADDRESS - STATUS_ADDRESS));
+        const std::size_t length  = std::find(message, message + (PRG_RAM_SIZE - 4U), '\0') - message;
+        result.detail             = std::string(message, length);
+        while(!result.detail.empty() && std::isspace(static_cast<unsigned char>(result.detail.back())))
+        {
+            result.detail.pop_back();
+        }
+        result.passed = status == 0U;
+        if(!result.passed)
+        {
+            result.detail = "Result " + std::to_string(status) + ": " + result.detail;
+        }
+    }
+
+    if(!done)
+    {
+        result.detail = "No result after " + std::to_string(max_frames) + " frames";
+    }
+    result.instructions = c.instructions();
+    result.cycles       = c.cpu_state().cycles;
+    result.seconds      = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+std::vector<conformance_result> run_conformance(const std::vector<std::string> &paths, const unsigned jobs,
+                                                const uint64_t max_frames)
+{
+    const std::vector<std::string> roms = find_roms(paths);
+
+    std::vector<conformance_result> results(roms.size());
+    utils::parallel_for_each(roms, jobs, [&results, max_frames](const std::string &rom, const std::size_t i)
+                             { results[i] = run_path(rom, max_frames); });
+    return results;
+}
+
+} // namespace nes
@@ -0,0 +1,77 @@
+#include "cartridge.hh"
+#include "cpu.hh"
+
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+#pragma once
+
+//
+// Conformance runs of test ROMs, for proving changes to the core behaviour-identical.
+//
+// Two kinds of ROM are understood:
+//
+//  - Trace ROMs such as nestest, which come with a golden CPU log. The ROM runs from
+//    the state on the log's first line and every instruction's registers and cycle
+//    count are compared against the next line, nestest.log style. The log is read a
+//    line at a time, so only a few lines of context are ever held.
+//  - Status ROMs following blargg's convention: $6000 holds $80 while running and the
+//    result code (0 passes) when done, $6001-$6003 the signature $DE $B0 $61, and
+//    $6004 a zero-terminated message.
+//
+// `run_conformance()` finds the ROMs, takes `<rom>.log` as a ROM's golden log if there
+// is one, and runs them in parallel.
+//
+
+namespace nes
+{
+
+struct conformance_result
+{
+    std::string rom;
+    bool        passed = false;
+    std::string detail;  // Where and how a trace diverged, or the ROM's own message.
+
+    uint64_t instructions = 0U;
+    uint64_t cycles       = 0U;
+    double   seconds      = 0.0;
+
+    double emulated_mhz() const { return seconds > 0.0 ? static_cast<double>(cycles) / seconds / 1e6 : 0.0; }
+};
+
+// Registers and cycle count of one golden log line.
+struct trace_fields
+{
+    uint16_t pc     = 0U;
+    uint8_t  a      = 0U;
+    uint8_t  x      = 0U;
+    uint8_t  y      = 0U;
+    uint8_t  p      = 0U;
+    uint8_t  sp     = 0U;
+    uint64_t cycles = 0U;
+    bool     timed  = false;  // Whether the line had a CPU cycle count.
+};
+
+// Reads the PC (the first field) and the A:, X:, Y:, P:, SP: and optional CYC: fields
+// of a nestest-style log line; anything else on it is ignored. CYC: is only read as the
+// CPU cycle count on lines with a PPU: field, as older logs use it for the PPU dot.
+// Returns false if any required field is missing.
+bool parse_trace_line(const std::string &line, trace_fields &out);
+
+// A line in the same format, with the instruction's bytes in place of its disassembly.
+std::string format_trace_line(const cpu::state &s, const uint8_t *bytes, std::size_t length);
+
+// Compares `cart`'s CPU trace with `golden` until the log ends or the first divergence.
+conformance_result run_trace(const cartridge &cart, std::istream &golden);
+
+// Runs a status ROM for up to `max_frames` frames.
+conformance_result run_status_rom(const cartridge &cart, uint64_t max_frames);
+
+// Runs the ROMs at `paths` (files, or directories searched for *.nes) on `jobs` threads
+// (0 for one per core). Results are in path order.
+std::vector<conformance_result> run_conformance(const std::vector<std::string> &paths, unsigned jobs,
+                                                uint64_t max_frames);
+
+} // namespace nes
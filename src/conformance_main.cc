@@ -0,0 +1,84 @@
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "conformance.hh"
+
+//
+// nes-emu-conformance: runs test ROMs against their golden logs or status bytes and
+// reports each one's result and emulated speed.
+//
+
+namespace
+{
+    constexpr uint64_t DEFAULT_FRAMES = 3600U;  // A minute of emulated time.
+
+    void print_usage()
+    {
+        std::cerr << "usage: nes-emu-conformance [--jobs <count>] [--frames <count>] <rom.nes|dir>...\n";
+    }
+
+    // Indents a multi-line detail under its result line.
+    void print_detail(const std::string &detail)
+    {
+        std::istringstream lines(detail);
+        std::string        line;
+        while(std::getline(lines, line))
+        {
+            std::cout << "    " << line << "\n";
+        }
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    unsigned                 jobs   = 0U;  // One per core.
+    uint64_t                 frames = DEFAULT_FRAMES;
+    std::vector<std::string> paths;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+        {
+            jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+        }
+        else if(std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frames = std::stoull(argv[++i]);
+        }
+        else if(argv[i][0] == '-')
+        {
+            print_usage();
+            return 2;
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+    if(paths.empty())
+    {
+        print_usage();
+        return 2;
+    }
+
+    const std::vector<nes::conformance_result> results = nes::run_conformance(paths, jobs, frames);
+
+    std::size_t passed = 0U;
+    for(const nes::conformance_result &result : results)
+    {
+        passed += result.passed ? 1U : 0U;
+        std::cout << (result.passed ? "PASS " : "FAIL ") << std::fixed << std::setprecision(1) << std::setw(8)
+                  << result.emulated_mhz() << " MHz  " << std::defaultfloat << result.rom << "\n";
+        if(!result.detail.empty() && (!result.passed || result.detail.find('\n') == std::string::npos))
+        {
+            print_detail(result.detail);
+        }
+    }
+    std::cout << passed << "/" << results.size() << " passed" << std::endl;
+
+    return passed == results.size() ? 0 : 1;
+}
@@ -0,0 +1,535 @@
+#include "console.hh"
+#include "interpreter.hh"
+#include "utils.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nes
+{
+
+namespace
+{
+    constexpr uint16_t PRG_RAM_START = 0x6000U;
+    constexpr uint16_t PRG_ROM_START = 0x8000U;
+    constexpr uint16_t IO_START      = 0x4000U;
+
+    constexpr uint16_t OAM_DMA_REGISTER = 0x4014U;
+    constexpr uint16_t APU_STATUS       = 0x4015U;
+    constexpr uint16_t JOYPAD_1         = 0x4016U;
+    constexpr uint16_t JOYPAD_2         = 0x4017U;
+
+    constexpr uint8_t CTRL_NMI_ENABLE = 0x80U;
+
+    ppu::state initial_ppu_state(const cartridge &cart)
+    {
+        ppu::state s;
+        std::copy_n(cart.chr.begin(), std::min(cart.chr.size(), s.chr.size()), s.chr.begin());
+        s.mode = cart.mode;
+        return s;
+    }
+} // namespace
+
+console::console(const cartridge &cart, const ppu::pipeline::mode m, const std::string &save_path)
+    : prg_rom_(cart.prg_rom),
+      ppu_(std::make_unique<ppu::pipeline>(initial_ppu_state(cart), m)),
+      rom_hash_(cart.hash)
+{
+    if(prg_rom_.empty())
+    {
+        throw std::invalid_argument("Cartridge has no PRG-ROM!");
+    }
+
+    if(cart.battery && !save_path.empty())
+    {
+        battery_ = std::make_unique<battery_file>(save_path, PRG_RAM_SIZE);
+        prg_ram_ = battery_->data();
+    }
+
+    const std::size_t ram_page = hasher_.add_region(ram_.data(), ram_.size());
+    prg_ram_page_              = hasher_.add_region(prg_ram_, PRG_RAM_SIZE);
+
+    const ppu::state &video = ppu_->shadow();
+    chr_page_     = hasher_.add_region(video.chr.data(), video.chr.size());
+    vram_page_    = hasher_.add_region(video.vram.data(), video.vram.size());
+    palette_page_ = hasher_.add_region(video.palette.data(), video.palette.size());
+    oam_page_     = hasher_.add_region(video.oam.data(), video.oam.size());
+
+    map_.map(0x0000U, 0x2000U, ram_.data(), ram_.size(), memory_map::access::READ_WRITE,
+             hasher_.dirty_flags(ram_page));
+    map_.map(PRG_RAM_START, PRG_RAM_SIZE, prg_ram_, PRG_RAM_SIZE, memory_map::access::READ_WRITE,
+             battery_ ? prg_ram_dirty_.data() : hasher_.dirty_flags(prg_ram_page_));
+    map_.map(PRG_ROM_START, 0x8000U, prg_rom_.data(), prg_rom_.size(), memory_map::access::READ_ONLY);
+
+    apu_.set_memory_reader([this](const uint16_t address) { return read(address); });
+
+    cpu::reset(*this, cpu_);
+}
+
+void console::set_input(const std::size_t port, const uint8_t held)
+{
+    controllers_.at(port).buttons = held;
+}
+
+bool console::run_frame()
+{
+    const uint64_t end = frame_start_cycle(frame_ + 1U);
+    stopped_           = false;
+
+    if(!in_vblank_)
+    {
+        if(!run_until(vblank_cycle(frame_)))
+        {
+            return false;
+        }
+        if(nmi_at_vblank())
+        {
+            interrupt(cpu::NMI_VECTOR);
+        }
+        in_vblank_ = true;
+
+        if(stopped_)
+        {
+            return false;
+        }
+    }
+    if(!run_until(end))
+    {
+        return false;
+    }
+
+    in_vblank_ = false;
+    finish_frame(end);
+    return true;
+}
+
+bool console::nmi_at_vblank() const
+{
+    // NMIs enabled part-way through vblank are not raised.
+    return cpu_.cycles < frame_start_cycle(frame_ + 1U) && (ppu_->shadow().ctrl & CTRL_NMI_ENABLE) != 0U;
+}
+
+void console::finish_frame(const uint64_t end)
+{
+    apu_.run_until(end);
+    ppu_->end_frame(end);
+    ++frame_;
+
+    if(battery_ && !speculative_)
+    {
+        flush_battery();
+    }
+}
+
+bool console::run_until(const uint64_t cycle)
+{
+    limit_ = cycle;
+
+    // Branch on the accuracy, breakpoints and profiling once, not on every access.
+    if(accuracy_ == accuracy::EXACT)
+    {
+        run_loop<cpu::accuracy::exact>();
+    }
+    else
+    {
+        run_loop<cpu::accuracy::fast>();
+    }
+    return !stopped_;
+}
+
+template<typename Accuracy>
+void console::run_loop()
+{
+    const bool profile = opcode_counts_ != nullptr;
+    if(debugger_ != nullptr && debugger_->breaks_execution())
+    {
+        profile ? run_instructions<Accuracy, true, true>() : run_instructions<Accuracy, true, false>();
+    }
+    else
+    {
+        profile ? run_instructions<Accuracy, false, true>() : run_instructions<Accuracy, false, false>();
+    }
+}
+
+void console::interrupt(const uint16_t vector)
+{
+    if(accuracy_ == accuracy::EXACT)
+    {
+        cpu::interrupt<cpu::accuracy::exact>(*this, cpu_, vector);
+    }
+    else
+    {
+        cpu::interrupt<cpu::accuracy::fast>(*this, cpu_, vector);
+    }
+}
+
+template<typename Accuracy, bool BREAKS, bool PROFILE>
+void console::run_instructions()
+{
+    while(cpu_.cycles < limit_)
+    {
+        // The APU is only run on register access and at frame end, so IRQs it raises
+        // are seen at the next of those rather than on the exact cycle.
+        if(apu_.irq_pending() && !cpu_.status.at(cpu::flags::INTERRUPT))
+        {
+            cpu::interrupt<Accuracy>(*this, cpu_, cpu::IRQ_VECTOR);
+        }
+
+        if constexpr(BREAKS)
+        {
+            if(breaks_before(cpu_.pc))
+            {
+                break;
+            }
+        }
+
+        if(predecode_ != nullptr)
+        {
+            if(const uint16_t iteration = predecode_->idle_loop_cycles(cpu_.pc))
+            {
+                skip_idle_loop(iteration, limit_);
+                if(cpu_.cycles >= limit_)
+                {
+                    break;
+                }
+            }
+        }
+
+        if constexpr(PROFILE)
+        {
+            ++(*opcode_counts_)[peek(cpu_.pc)];
+        }
+        ++instructions_;
+        cpu::step<Accuracy>(*this, cpu_);
+        if(oam_dma_)
+        {
+            stall_for_oam_dma();
+        }
+    }
+}
+
+bool console::breaks_before(const uint16_t pc)
+{
+    if(debugger_->watched(debugger::EXECUTE, pc) && pc != resume_pc_)
+    {
+        if(debugger_->check(debugger::EXECUTE, pc, peek(pc), cpu_))
+        {
+            stopped_   = true;
+            resume_pc_ = pc;
+            return true;
+        }
+    }
+    resume_pc_ = -1;
+    return false;
+}
+
+uint8_t console::peek(const uint16_t address) const
+{
+    const uint8_t *page = map_.mapped_read_page(address);
+    return page != nullptr ? page[address & (memory_map::PAGE_SIZE - 1U)] : 0U;
+}
+
+void console::set_profiling(const bool enabled)
+{
+    if(!enabled)
+    {
+        opcode_counts_.reset();
+    }
+    else if(opcode_counts_ == nullptr)
+    {
+        opcode_counts_ = std::make_unique<std::array<uint64_t, 256U>>();
+    }
+}
+
+void console::skip_idle_loop(const uint16_t iteration, const uint64_t cycle)
+{
+    // Skipped iterations would not be seen by the debugger.
+    if(debugger_ != nullptr && debugger_->armed())
+    {
+        return;
+    }
+
+    // Exactly one iteration since the last arrival, with nothing else in between, and
+    // the registers came back unchanged: as the loop writes nothing, every further
+    // iteration will do the same until an interrupt.
+    const bool steady = idle_.pc == cpu_.pc && cpu_.cycles - idle_.cycles == iteration &&
+                        idle_.reg_a == cpu_.reg_a && idle_.reg_x == cpu_.reg_x &&
+                        idle_.reg_y == cpu_.reg_y && idle_.sp == cpu_.sp && idle_.status == cpu_.status;
+    if(steady)
+    {
+        const uint64_t skipped = (cycle - cpu_.cycles) / iteration * iteration;
+        cpu_.cycles += skipped;
+        idle_cycles_skipped_ += skipped;
+    }
+    idle_ = cpu_;
+}
+
+void console::set_predecode(const predecode *analysis)
+{
+    if(analysis != nullptr && analysis->rom_hash() != rom_hash_)
+    {
+        throw std::invalid_argument("Predecode analysis is for a different ROM!");
+    }
+    predecode_ = analysis;
+    idle_      = cpu::state();
+}
+
+void console::save(snapshot &out)
+{
+    ++snapshots_saved_;
+    out.cpu         = cpu_;
+    out.ram         = ram_;
+    std::copy_n(prg_ram_, PRG_RAM_SIZE, out.prg_ram.begin());
+    out.controllers = controllers_;
+    out.audio       = apu_.get_state();
+    out.frame       = frame_;
+    ppu_->save(out.video);
+    hasher_.save(out.hashes);
+}
+
+void console::restore(const snapshot &in)
+{
+    ++snapshots_restored_;
+    cpu_         = in.cpu;
+    ram_         = in.ram;
+    controllers_ = in.controllers;
+    frame_       = in.frame;
+    idle_        = cpu::state();
+    stopped_     = false;
+    resume_pc_   = -1;
+    in_vblank_   = false;
+    apu_.restore(in.audio);
+    ppu_->restore(in.video);
+    hasher_.restore(in.hashes);
+
+    // Rewriting identical contents would still cost the save file a flush.
+    if(!std::equal(in.prg_ram.begin(), in.prg_ram.end(), prg_ram_))
+    {
+        std::copy(in.prg_ram.begin(), in.prg_ram.end(), prg_ram_);
+        battery_dirty_ = battery_ != nullptr;
+    }
+}
+
+void console::detach_battery()
+{
+    if(battery_)
+    {
+        battery_->make_private();
+    }
+}
+
+void console::collect_prg_ram_writes()
+{
+    for(std::size_t page = 0U; page < prg_ram_dirty_.size(); ++page)
+    {
+        if(prg_ram_dirty_[page] != 0U)
+        {
+            prg_ram_dirty_[page] = 0U;
+            hasher_.mark_dirty(prg_ram_page_ + page);
+            battery_dirty_ = true;
+        }
+    }
+}
+
+void console::flush_battery()
+{
+    collect_prg_ram_writes();
+    if(battery_dirty_)
+    {
+        battery_->flush();
+        battery_dirty_ = false;
+    }
+}
+
+const ppu::frame &console::latest_frame()
+{
+    ppu_->flush();
+    ppu_->output().acquire();
+    return ppu_->output().front();
+}
+
+uint64_t console::state_hash()
+{
+    const ppu::state &video = ppu_->shadow();
+
+    // Registers are a few bytes, so they are simply hashed every time.
+    const std::array<uint8_t, 18U> registers = {
+        static_cast<uint8_t>(cpu_.pc), static_cast<uint8_t>(cpu_.pc >> 8U),
+        static_cast<uint8_t>(cpu_.sp), cpu_.status.to_byte(),
+        cpu_.reg_a, cpu_.reg_x, cpu_.reg_y,
+        video.ctrl, video.mask, video.oam_addr,
+        static_cast<uint8_t>(video.v), static_cast<uint8_t>(video.v >> 8U),
+        static_cast<uint8_t>(video.t), static_cast<uint8_t>(video.t >> 8U),
+        video.x, static_cast<uint8_t>(video.w), video.read_buffer, 0x00U};
+
+    if(battery_)
+    {
+        collect_prg_ram_writes();
+    }
+    return utils::hash64(registers.data(), registers.size(), hasher_.root() ^ cpu_.cycles);
+}
+
+void console::mark_ppu_write(const ppu::registers reg)
+{
+    const ppu::state &video = ppu_->shadow();
+
+    switch(reg)
+    {
+        case ppu::registers::OAM_DATA:
+            hasher_.mark_dirty(oam_page_);
+            break;
+
+        case ppu::registers::DATA:
+        {
+            const uint16_t address = video.v & 0x3FFFU;
+            if(address < 0x2000U)
+            {
+                hasher_.mark_dirty(chr_page_ + (address >> 8U));
+            }
+            else if(address < 0x3F00U)
+            {
+                hasher_.mark_dirty(vram_page_ + (ppu::nametable_index(video.mode, address) >> 8U));
+            }
+            else
+            {
+                hasher_.mark_dirty(palette_page_);
+            }
+            break;
+        }
+
+        default:
+            break;
+    }
+}
+
+uint8_t console::read_io(const uint16_t address)
+{
+    if(const uint8_t *page = map_.mapped_read_page(address))
+    {
+        const uint8_t value = page[address & (memory_map::PAGE_SIZE - 1U)];
+        check_watch(debugger::READ, address, value);
+        return value;
+    }
+
+    const uint8_t value = read_register(address);
+    if(debugger_ != nullptr)
+    {
+        check_watch(debugger::READ, address, value);
+    }
+    return value;
+}
+
+void console::write_io(const uint16_t address, const uint8_t value)
+{
+    if(uint8_t *page = map_.mapped_write_page(address))
+    {
+        page[address & (memory_map::PAGE_SIZE - 1U)] = value;
+        map_.mark_dirty(address);
+        check_watch(debugger::WRITE, address, value);
+        return;
+    }
+
+    write_register(address, value);
+    if(debugger_ != nullptr)
+    {
+        check_watch(debugger::WRITE, address, value);
+    }
+}
+
+void console::check_watch(const debugger::kind what, const uint16_t address, const uint8_t value)
+{
+    if(debugger_->check(what, address, value, cpu_))
+    {
+        stopped_ = true;
+        limit_   = 0U;
+    }
+}
+
+uint8_t console::read_register(const uint16_t address)
+{
+    if(address < IO_START)
+    {
+        return ppu_->read(static_cast<ppu::registers>(address & 0x07U), cpu_.cycles);
+    }
+
+    // Unmapped bits float at the high byte of the address, the last value on the bus.
+    const uint8_t open_bus = static_cast<uint8_t>(address >> 8U);
+
+    switch(address)
+    {
+        case APU_STATUS:
+            return apu_.read_status(cpu_.cycles);
+
+        case JOYPAD_1:
+        case JOYPAD_2:
+            return (open_bus & 0xE0U) | controllers_[address - JOYPAD_1].read();
+
+        default:
+            return open_bus;
+    }
+}
+
+void console::write_register(const uint16_t address, const uint8_t value)
+{
+    if(address < IO_START)
+    {
+        const auto reg = static_cast<ppu::registers>(address & 0x07U);
+        mark_ppu_write(reg);
+        ppu_->write(reg, value, cpu_.cycles);
+        return;
+    }
+
+    switch(address)
+    {
+        case OAM_DMA_REGISTER:
+            oam_dma(value);
+            break;
+
+        case JOYPAD_1:
+            for(controller &c : controllers_)
+            {
+                c.write(value);
+            }
+            break;
+
+        default:
+            if(address <= JOYPAD_2)
+            {
+                apu_.write(address, value, cpu_.cycles);
+            }
+            break;
+    }
+}
+
+void console::oam_dma(const uint8_t page)
+{
+    const uint16_t address = static_cast<uint16_t>(page << memory_map::PAGE_BITS);
+
+    // Plain memory is copied straight from its page; I/O and watched pages are read a
+    // byte at a time, for their side effects.
+    const uint8_t                              *source = map_.read_page(address);
+    std::array<uint8_t, memory_map::PAGE_SIZE> bytes;
+    if(source == nullptr)
+    {
+        for(std::size_t i = 0U; i < bytes.size(); ++i)
+        {
+            bytes[i] = read(static_cast<uint16_t>(address | i));
+        }
+        source = bytes.data();
+    }
+
+    ppu_->oam_dma(source, cpu_.cycles);
+    hasher_.mark_dirty(oam_page_);
+    oam_dma_ = true;
+}
+
+void console::stall_for_oam_dma()
+{
+    // The CPU is halted for the whole transfer, so the stall is charged at once. It
+    // runs a cycle longer after a write on an odd cycle; the write is the instruction's
+    // last cycle, which the fast policy only knows once the instruction is done.
+    oam_dma_ = false;
+    cpu_.cycles += OAM_DMA_CYCLES + ((cpu_.cycles - 1U) & 0x01U);
+}
+
+} // namespace nes
@@ -0,0 +1,282 @@
+#include "apu.hh"
+#include "battery.hh"
+#include "bus.hh"
+#include "cartridge.hh"
+#include "controller.hh"
+#include "cpu.hh"
+#include "debugger.hh"
+#include "ppu_pipeline.hh"
+#include "predecode.hh"
+#include "state_hash.hh"
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#pragma once
+
+//
+// Ties the CPU, PPU, APU, controllers and cartridge together.
+//
+// The console is the CPU's bus: RAM, PRG-ROM and PRG-RAM are reached through the page
+// table, everything else goes through the I/O handlers below. Emulation advances a
+// whole frame at a time, with the NMI raised at the start of vblank.
+//
+
+namespace nes
+{
+
+constexpr std::size_t RAM_SIZE       = 0x800U;
+constexpr std::size_t CONTROLLERS    = 2U;
+constexpr uint32_t    OAM_DMA_CYCLES = 513U;  // Plus one when started on an odd cycle.
+
+// First CPU cycle at or after PPU dot `dot` (counted from power-on).
+constexpr uint64_t cycle_of_dot(const uint64_t dot)
+{
+    return (dot + ppu::DOTS_PER_CPU_CYCLE - 1U) / ppu::DOTS_PER_CPU_CYCLE;
+}
+
+// First CPU cycle of frame `frame`.
+constexpr uint64_t frame_start_cycle(const uint64_t frame)
+{
+    return cycle_of_dot(frame * ppu::DOTS_PER_FRAME);
+}
+
+// First CPU cycle at or after the start of frame `frame`'s vblank, where the NMI is raised.
+constexpr uint64_t vblank_cycle(const uint64_t frame)
+{
+    return cycle_of_dot((frame * ppu::DOTS_PER_FRAME) + ppu::VBLANK_SET_DOT);
+}
+
+// How the CPU issues bus cycles; see `cpu::accuracy`.
+enum class accuracy : uint8_t
+{
+    FAST,   // Whole instructions, I/O sees the cycle the instruction started on.
+    EXACT,  // Every bus cycle, including dummy accesses, on the cycle it happens.
+};
+
+class console
+{
+public:
+    // Complete emulation state. Allocated once and reused, saving and restoring do not
+    // allocate.
+    struct snapshot
+    {
+        cpu::state                          cpu;
+        std::array<uint8_t, RAM_SIZE>       ram;
+        std::array<uint8_t, PRG_RAM_SIZE>   prg_ram;
+        std::array<controller, CONTROLLERS> controllers;
+        ppu::pipeline::snapshot             video;
+        apu::state                          audio;
+        page_hasher::snapshot               hashes;
+        uint64_t                            frame;
+    };
+
+    // If the cartridge has a battery and `save_path` is given, PRG-RAM lives in that
+    // file (see battery_file) and is flushed at the end of each committed frame that
+    // wrote it.
+    explicit console(const cartridge &cart, ppu::pipeline::mode m = ppu::pipeline::mode::INLINE,
+                     const std::string &save_path = std::string());
+
+    console(const console &)            = delete;
+    console &operator=(const console &) = delete;
+
+    // Runs the CPU up to the first cycle of the next frame. Returns false if a
+    // debugger break stopped it part-way; calling it again carries on.
+    bool run_frame();
+
+    // Buttons held on `port` (0 or 1) from now on. See `buttons::`.
+    void set_input(std::size_t port, uint8_t held);
+
+    // Turn off drawing and/or audio synthesis for frames whose output will not be used.
+    // Emulation is unaffected.
+    void set_rendering(bool enabled) { ppu_->set_drawing(enabled); }
+    void set_audio(bool enabled) { apu_.set_output_enabled(enabled); }
+
+    // Marks frames that will be restored over or run again, whose PRG-RAM is not
+    // flushed to the save file. The next committed frame flushes what is left.
+    void set_speculative(const bool speculative) { speculative_ = speculative; }
+
+    // Skip idle loops found by `analysis` (null turns this off). Emulation is
+    // unaffected. `analysis` must be of this console's cartridge and outlive its use.
+    void set_predecode(const predecode *analysis);
+
+    // FAST suits bulk runs; EXACT is for titles that depend on dummy reads, double
+    // writes or the cycle a PPU register is accessed on. Chosen per call to
+    // `run_frame()`, not per access.
+    void     set_accuracy(const accuracy a) { accuracy_ = a; }
+    accuracy get_accuracy() const { return accuracy_; }
+
+    // Counts executed opcodes into `opcode_counts()` while enabled. Disabling drops
+    // the counts.
+    void set_profiling(bool enabled);
+
+    // Stops PRG-RAM writes reaching the save file, e.g. in a forked worker.
+    void detach_battery();
+
+    // Between frames only.
+    void save(snapshot &out);
+    void restore(const snapshot &in);
+
+    //
+    // CPU bus.
+    //
+    uint8_t read(const uint16_t address)
+    {
+        if(const uint8_t *page = map_.read_page(address))
+        {
+            return page[address & (memory_map::PAGE_SIZE - 1U)];
+        }
+        return read_io(address);
+    }
+
+    void write(const uint16_t address, const uint8_t value)
+    {
+        if(uint8_t *page = map_.write_page(address))
+        {
+            page[address & (memory_map::PAGE_SIZE - 1U)] = value;
+            map_.mark_dirty(address);
+            return;
+        }
+        write_io(address, value);
+    }
+
+    // Last finished frame. Waits for the renderer in threaded mode.
+    const ppu::frame &latest_frame();
+
+    // Hash of the CPU and PPU registers and of all memory (RAM, PRG-RAM and the PPU's
+    // CHR, nametables, palette and OAM). Only pages written since the last call are
+    // rehashed.
+    uint64_t state_hash();
+
+    // Number of frames run so far.
+    uint64_t frame_number() const { return frame_; }
+    uint64_t idle_cycles_skipped() const { return idle_cycles_skipped_; }
+    uint64_t instructions() const { return instructions_; }
+    uint64_t snapshots_saved() const { return snapshots_saved_; }
+    uint64_t snapshots_restored() const { return snapshots_restored_; }
+
+    // Null unless profiling.
+    const std::array<uint64_t, 256U> *opcode_counts() const { return opcode_counts_.get(); }
+    uint64_t rom_hash() const { return rom_hash_; }
+
+    const cpu::state                    &cpu_state() const { return cpu_; }
+    const std::array<uint8_t, RAM_SIZE> &ram() const { return ram_; }
+    const uint8_t                       *prg_ram() const { return prg_ram_; }
+    const battery_file                  *battery() const { return battery_.get(); }
+    ppu::pipeline                       &video() { return *ppu_; }
+    apu::processor                      &audio() { return apu_; }
+
+private:
+    // Drives the components as coroutines instead of `run_until()`.
+    friend class cooperative_runner;
+
+    // Watches pages in `map_` and is called back on their accesses.
+    friend class debugger;
+
+    // Accesses to watched pages and I/O registers.
+    uint8_t read_io(uint16_t address);
+    void    write_io(uint16_t address, uint8_t value);
+
+    uint8_t read_register(uint16_t address);
+    void    write_register(uint16_t address, uint8_t value);
+    void    oam_dma(uint8_t page);
+
+    // After the instruction that wrote $4014: halts the CPU for the transfer.
+    void stall_for_oam_dma();
+
+    // Ends the current run after this instruction if the debugger breaks on the access.
+    void check_watch(debugger::kind what, uint16_t address, uint8_t value);
+
+    // Flags the PPU memory a register write is about to change.
+    void mark_ppu_write(ppu::registers reg);
+
+    // Executes instructions until the cycle counter reaches `cycle`. Returns false if
+    // the debugger stopped it first.
+    bool run_until(uint64_t cycle);
+
+    // Up to `limit_`. With `BREAKS`, checks execution breakpoints before each
+    // instruction; with `PROFILE`, counts opcodes. `run_loop()` picks the one needed.
+    template<typename Accuracy>
+    void run_loop();
+
+    template<typename Accuracy, bool BREAKS, bool PROFILE>
+    void run_instructions();
+
+    // With a debugger attached: true, and stopped, if an execution breakpoint is hit
+    // before the instruction at `pc`. Resuming steps over it.
+    bool breaks_before(uint16_t pc);
+
+    // Byte at `address` if it is memory, without side effects; 0 for I/O.
+    uint8_t peek(uint16_t address) const;
+
+    void interrupt(uint16_t vector);
+
+    // True if an NMI is due at the start of vblank, the CPU being at its first
+    // instruction boundary since.
+    bool nmi_at_vblank() const;
+
+    // Brings the APU and PPU up to `end`, the first cycle of the next frame, and
+    // moves on to it.
+    void finish_frame(uint64_t end);
+
+    // Called at an idle loop head: jumps whole iterations ahead, up to `cycle`, once
+    // the loop has stopped changing the registers.
+    void skip_idle_loop(uint16_t iteration, uint64_t cycle);
+
+    // With a battery, PRG-RAM writes are flagged here first and handed on to the
+    // hasher and the save file from these.
+    void collect_prg_ram_writes();
+    void flush_battery();
+
+    memory_map map_;
+    cpu::state cpu_;
+
+    std::array<uint8_t, RAM_SIZE>     ram_{};
+    std::vector<uint8_t>              prg_rom_;
+    std::array<uint8_t, PRG_RAM_SIZE> prg_ram_storage_{};
+    uint8_t                          *prg_ram_ = prg_ram_storage_.data();
+
+    std::unique_ptr<battery_file>                             battery_;
+    std::array<uint8_t, PRG_RAM_SIZE / memory_map::PAGE_SIZE> prg_ram_dirty_{};
+    bool                                                      battery_dirty_ = false;
+    bool                                                      speculative_   = false;
+
+    std::array<controller, CONTROLLERS> controllers_{};
+
+    std::unique_ptr<ppu::pipeline> ppu_;
+    apu::processor                 apu_;
+
+    page_hasher hasher_;
+    std::size_t prg_ram_page_ = 0U;
+    std::size_t chr_page_     = 0U;
+    std::size_t vram_page_    = 0U;
+    std::size_t palette_page_ = 0U;
+    std::size_t oam_page_     = 0U;
+
+    const predecode *predecode_ = nullptr;
+    cpu::state       idle_;  // CPU at the last arrival at an idle loop head.
+    uint64_t         idle_cycles_skipped_ = 0U;
+
+    accuracy accuracy_ = accuracy::FAST;
+
+    debugger *debugger_  = nullptr;
+    uint64_t  limit_     = 0U;     // Cycle the run loop stops at; zeroed to break.
+    bool      stopped_   = false;  // A break ended the current `run_frame()`.
+    int32_t   resume_pc_ = -1;     // Execution breakpoint to step over when resuming.
+    bool      in_vblank_ = false;  // `run_frame()` is past this frame's NMI.
+    bool      oam_dma_   = false;  // The current instruction started an OAM DMA.
+
+    // Counters for metrics, not emulation state.
+    uint64_t                                    instructions_       = 0U;
+    uint64_t                                    snapshots_saved_    = 0U;
+    uint64_t                                    snapshots_restored_ = 0U;
+    std::unique_ptr<std::array<uint64_t, 256U>> opcode_counts_;
+
+    uint64_t frame_    = 0U;
+    uint64_t rom_hash_ = 0U;
+};
+
+} // namespace nes
@@ -0,0 +1,55 @@
+#include <cstdint>
+
+#pragma once
+
+//
+// Standard NES controller, read serially through $4016/$4017.
+//
+
+namespace nes
+{
+
+// Button bits, in the order the shift register reports them.
+namespace buttons
+{
+    constexpr uint8_t A      = 1U << 0U;
+    constexpr uint8_t B      = 1U << 1U;
+    constexpr uint8_t SELECT = 1U << 2U;
+    constexpr uint8_t START  = 1U << 3U;
+    constexpr uint8_t UP     = 1U << 4U;
+    constexpr uint8_t DOWN   = 1U << 5U;
+    constexpr uint8_t LEFT   = 1U << 6U;
+    constexpr uint8_t RIGHT  = 1U << 7U;
+} // namespace buttons
+
+// Plain data so that it can be copied for snapshots.
+struct controller
+{
+    uint8_t buttons = 0x00U;  // Currently held.
+    uint8_t shift   = 0x00U;  // Latched copy being shifted out.
+    bool    strobe  = false;
+
+    void write(const uint8_t value)
+    {
+        strobe = (value & 0x01U) != 0U;
+        if(strobe)
+        {
+            shift = buttons;
+        }
+    }
+
+    // Bit 0 is the next button. Official controllers return 1s once all 8 are read.
+    uint8_t read()
+    {
+        if(strobe)
+        {
+            return buttons & 0x01U;
+        }
+
+        const uint8_t bit = shift & 0x01U;
+        shift = static_cast<uint8_t>((shift >> 1U) | 0x80U);
+        return bit;
+    }
+};
+
+} // namespace nes
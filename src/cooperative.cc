@@ -0,0 +1,141 @@
+#include "cooperative.hh"
+
+#include "interpreter.hh"
+
+#include <stdexcept>
+
+namespace nes
+{
+
+void cooperative_scheduler::add(task t, const uint64_t time)
+{
+    components_.push_back({std::move(t), time});
+}
+
+void cooperative_scheduler::run_until(const uint64_t limit)
+{
+    for(;;)
+    {
+        // A handful of components, so a linear scan beats keeping a heap.
+        std::size_t behind = 0U;
+        for(std::size_t i = 1U; i < components_.size(); ++i)
+        {
+            if(components_[i].time < components_[behind].time)
+            {
+                behind = i;
+            }
+        }
+
+        if(components_.empty() || components_[behind].time >= limit)
+        {
+            return;
+        }
+
+        current_ = behind;
+        ++switches_;
+        components_[behind].work.handle_.resume();
+
+        if(components_[behind].work.handle_.done())
+        {
+            throw std::logic_error("Component coroutine finished!");
+        }
+        if(std::exchange(stopping_, false))
+        {
+            return;
+        }
+    }
+}
+
+cooperative_runner::cooperative_runner(console &c)
+    : console_(c)
+{
+    // The video component goes first so that at the vblank cycle it raises the NMI
+    // before the CPU starts another instruction, as `console::run_frame()` does.
+    const uint64_t now = console_.cpu_.cycles;
+    scheduler_.add(video(), now);
+    if(console_.get_accuracy() == accuracy::EXACT)
+    {
+        scheduler_.add(processor<cpu::accuracy::exact>(), now);
+    }
+    else
+    {
+        scheduler_.add(processor<cpu::accuracy::fast>(), now);
+    }
+}
+
+bool cooperative_runner::run_frame()
+{
+    const uint64_t end = frame_start_cycle(console_.frame_ + 1U);
+    console_.stopped_  = false;
+
+    scheduler_.run_until(end);
+    if(console_.stopped_)
+    {
+        return false;
+    }
+
+    console_.finish_frame(end);
+    return true;
+}
+
+cooperative_runner::task cooperative_runner::video()
+{
+    for(;;)
+    {
+        const uint64_t frame = console_.frame_;
+
+        co_await scheduler_.until(vblank_cycle(frame));
+        nmi_pending_ = console_.nmi_at_vblank();
+
+        // Resumed once the frame has been finished and the next one begun.
+        co_await scheduler_.until(frame_start_cycle(frame + 1U));
+    }
+}
+
+template<typename Accuracy>
+cooperative_runner::task cooperative_runner::processor()
+{
+    cpu::state &s = console_.cpu_;
+    for(;;)
+    {
+        if(nmi_pending_)
+        {
+            nmi_pending_ = false;
+            cpu::interrupt<Accuracy>(console_, s, cpu::NMI_VECTOR);
+        }
+        else
+        {
+            if(console_.apu_.irq_pending() && !s.status.at(cpu::flags::INTERRUPT))
+            {
+                cpu::interrupt<Accuracy>(console_, s, cpu::IRQ_VECTOR);
+            }
+
+            if(console_.debugger_ != nullptr && console_.breaks_before(s.pc))
+            {
+                scheduler_.stop();
+                co_await scheduler_.until(s.cycles);
+                continue;
+            }
+
+            if(console_.opcode_counts_ != nullptr)
+            {
+                ++(*console_.opcode_counts_)[console_.peek(s.pc)];
+            }
+            ++console_.instructions_;
+            cpu::step<Accuracy>(console_, s);
+            if(console_.oam_dma_)
+            {
+                console_.stall_for_oam_dma();
+            }
+        }
+
+        // A watchpoint hit during the instruction.
+        if(console_.stopped_)
+        {
+            scheduler_.stop();
+        }
+        co_await scheduler_.until(s.cycles);
+    }
+}
+
+} // namespace nes
@@ -0,0 +1,139 @@
+#include "console.hh"
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#pragma once
+
+//
+// Cooperative execution model, built with -DNES_COROUTINES=ON (C++20).
+//
+// Each component is a coroutine that does some work and then `co_await`s the CPU cycle
+// it next needs to run at. A single-threaded scheduler always resumes the component
+// furthest behind, so components interleave in time order without keeping explicit
+// state machines. The catch-up model in `console::run_frame()` remains the default; the
+// two produce the same emulation for the same input.
+//
+
+namespace nes
+{
+
+class cooperative_scheduler
+{
+public:
+    // A component coroutine. It starts suspended and must never finish.
+    class task
+    {
+    public:
+        struct promise_type
+        {
+            task                get_return_object() { return task(handle::from_promise(*this)); }
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void                return_void() {}
+
+            // Exceptions leave through the scheduler's `run_until()`.
+            void unhandled_exception() { throw; }
+        };
+
+        using handle = std::coroutine_handle<promise_type>;
+
+        explicit task(const handle h) : handle_(h) {}
+        task(task &&other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+        ~task()
+        {
+            if(handle_)
+            {
+                handle_.destroy();
+            }
+        }
+
+        task(const task &)            = delete;
+        task &operator=(const task &) = delete;
+
+    private:
+        friend class cooperative_scheduler;
+        handle handle_;
+    };
+
+    class awaiter
+    {
+    public:
+        awaiter(cooperative_scheduler &s, const uint64_t time) : scheduler_(s), time_(time) {}
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<>) noexcept { scheduler_.components_[scheduler_.current_].time = time_; }
+        void await_resume() const noexcept {}
+
+    private:
+        cooperative_scheduler &scheduler_;
+        uint64_t               time_;
+    };
+
+    // Adds a component first resumed at `time`. Components due at the same cycle run in
+    // the order they were added.
+    void add(task t, uint64_t time = 0U);
+
+    // From inside a component: suspends it until `time`.
+    awaiter until(const uint64_t time) { return awaiter(*this, time); }
+
+    // Resumes the component furthest behind until every one is due at `limit` or later,
+    // or one has called `stop()`.
+    void run_until(uint64_t limit);
+
+    // From inside a component: `run_until()` returns once it next suspends.
+    void stop() { stopping_ = true; }
+
+    uint64_t switches() const { return switches_; }
+
+private:
+    struct component
+    {
+        task     work;
+        uint64_t time;
+    };
+
+    std::vector<component> components_;
+    std::size_t            current_  = 0U;
+    uint64_t               switches_ = 0U;
+    bool                   stopping_ = false;
+};
+
+//
+// Runs a console with the PPU's vblank and the CPU as coroutines. Rendering stays with
+// the PPU pipeline, and the APU with its register accesses and the frame's end, both
+// catching up as before: run any more often, the APU would raise IRQs earlier than
+// the catch-up model sees them. NROM has no mapper hardware to schedule.
+//
+class cooperative_runner
+{
+public:
+    // Runs at the console's accuracy as of now.
+    explicit cooperative_runner(console &c);
+
+    // The coroutines refer back to the runner.
+    cooperative_runner(const cooperative_runner &)            = delete;
+    cooperative_runner &operator=(const cooperative_runner &) = delete;
+
+    // Same contract as `console::run_frame()`, breaks and profiling included. Idle
+    // loops are not skipped (see `console::set_predecode()`).
+    bool run_frame();
+
+    const cooperative_scheduler &scheduler() const { return scheduler_; }
+
+private:
+    using task = cooperative_scheduler::task;
+
+    task video();
+    template<typename Accuracy>
+    task processor();
+
+    console              &console_;
+    cooperative_scheduler scheduler_;
+    bool                  nmi_pending_ = false;
+};
+
+} // namespace nes
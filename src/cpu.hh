@@ -16,7 +16,7 @@ namespace cpu
 {
 
 // Naive memory implementation
-using memory = std::array<uint8_t, 0xFFFF>;
+using memory = std::array<uint8_t, 0x10000>;
 
 // CPU status flags
 class flags
@@ -31,10 +31,34 @@ public:
     static constexpr size_t OVERFLOW   = 6U;
     static constexpr size_t NEGATIVE   = 7U;
 
+    // Bit 5 is not a flag, it always reads back as set.
+    static constexpr uint8_t UNUSED_BIT = 1U << 5U;
+
     void reset() { std::fill(std::begin(flags_), std::end(flags_), false); }
     bool &at(const size_t i) { return flags_.at(i); }
     const bool &at(const size_t i) const { return flags_.at(i); }; 
 
+    // Packs/unpacks the flags in P-register layout, for the stack.
+    uint8_t to_byte() const
+    {
+        uint8_t value = UNUSED_BIT;
+        for(size_t i = 0U; i < flags_.size(); ++i)
+        {
+            value |= flags_[i] ? static_cast<uint8_t>(1U << i) : 0U;
+        }
+        return value;
+    }
+
+    void from_byte(const uint8_t value)
+    {
+        for(size_t i = 0U; i < flags_.size(); ++i)
+        {
+            flags_[i] = (value & (1U << i)) != 0U;
+        }
+    }
+
+    bool operator==(const flags &other) const { return flags_ == other.flags_; }
+
 private:
     std::array<bool, 8U> flags_{false};
 };
@@ -50,9 +74,14 @@ struct state
     uint8_t reg_a = 0x00;   // Accumulator
     uint8_t reg_x = 0x00;   // X-index
     uint8_t reg_y = 0x00;   // Y-index
+
+    uint64_t cycles = 0U;   // CPU cycles elapsed since power-on. Used to timestamp I/O.
 };
 
-namespace address
+// Superseded by the interpreter in interpreter.hh, which addresses through a bus and
+// counts page-crossing cycles. Kept for the addressing tests only: new code, and fixes
+// to addressing or timing, belong in the interpreter.
+namespace [[deprecated("Use cpu::step() from interpreter.hh")]] address
 {
     //
     // This namespace contains functions which carry out all of the addressing modes
@@ -379,8 +408,8 @@ namespace op
         // LDX (Load X-register)
         //
         LDX_IMMEDIATE   = 0xA2,
-        LDX_ZERO_PAGE   = 0xA4,
-        LDX_ZERO_PAGE_Y = 0xB4,
+        LDX_ZERO_PAGE   = 0xA6,
+        LDX_ZERO_PAGE_Y = 0xB6,
         LDX_ABSOLUTE    = 0xAE,
         LDX_ABSOLUTE_Y  = 0xBE,
 
@@ -436,7 +465,7 @@ namespace op
         //
         ROL_ACCUMULATOR = 0x2A,
         ROL_ZERO_PAGE   = 0x26,
-        ROL_ZERO_PAGE_x = 0x36,
+        ROL_ZERO_PAGE_X = 0x36,
         ROL_ABSOLUTE    = 0x2E,
         ROL_ABSOLUTE_X  = 0x3E,
 
@@ -507,72 +536,170 @@ namespace op
         STY_ABSOLUTE    = 0x8C
     };
 
-    // Overflow flag computation.
-    constexpr bool compute_overflow_flag(const uint8_t a, const uint8_t b)
-    {
-        // Reference: http://www.6502.org/tutorials/vflag.html
-        return (65280 + a) - b < 65152 || (65280 + a) - b > 65407;
-    }
-
     //
     // Operations
     //
+    // Reads take the operand and update the registers/flags. Read-modify-writes take
+    // the operand and return the value to write back. Stores return the value to write.
+    //
+
+    // Sets ZERO and NEGATIVE from `result`, which nearly every operation ends with.
+    const auto set_zero_negative = [](state &state, const uint8_t result)
+    {
+        state.status.at(flags::ZERO)     = (result == 0U);
+        state.status.at(flags::NEGATIVE) = (result & (1U << 7U)) != 0U;
+    };
 
     // ADC
-    auto adc_op = [](state &state, const uint8_t value)
+    //    Decimal mode does not exist on the 2A03.
+    const auto adc_op = [](state &state, const uint8_t value)
     {
-        // NOTE: What happens if there's overflow w/ the carry addition?
-        const auto carry_value     = state.status.at(flags::CARRY) ? 1U : 0U;
-        const auto [result, carry] = helpers::sum_with_carry(state.reg_a, value + carry_value);
+        const uint16_t sum    = state.reg_a + value + (state.status.at(flags::CARRY) ? 1U : 0U);
+        const uint8_t  result = static_cast<uint8_t>(sum);
 
-        // Set CPU flags.
-        state.status.reset();
-        state.status.at(flags::CARRY)    = carry;
-        state.status.at(flags::ZERO)     = (result == 0);
-        state.status.at(flags::OVERFLOW) = op::compute_overflow_flag(state.reg_a, value + carry_value);
-        state.status.at(flags::NEGATIVE) = (result & (1 << 7U));
+        // Reference: http://www.6502.org/tutorials/vflag.html
+        state.status.at(flags::CARRY)    = (sum > 0xFFU);
+        state.status.at(flags::OVERFLOW) = ((~(state.reg_a ^ value) & (state.reg_a ^ result)) & 0x80U) != 0U;
+        set_zero_negative(state, result);
 
-        // Set value in accumulator.
         state.reg_a = result;
     };
 
+    // SBC
+    //    A - M - !C is A + ~M + C.
+    const auto sbc_op = [](state &state, const uint8_t value)
+    {
+        adc_op(state, static_cast<uint8_t>(~value));
+    };
+
     // AND
     const auto and_op = [](state &state, const uint8_t value)
     {
-        const uint8_t result = state.reg_a & value;
+        state.reg_a &= value;
+        set_zero_negative(state, state.reg_a);
+    };
+
+    // EOR
+    const auto eor_op = [](state &state, const uint8_t value)
+    {
+        state.reg_a ^= value;
+        set_zero_negative(state, state.reg_a);
+    };
 
-        state.status.reset();
-        state.status.at(flags::ZERO)     = (result == 0);
-        state.status.at(flags::NEGATIVE) = (result & (1 << 7U));
+    // ORA
+    const auto ora_op = [](state &state, const uint8_t value)
+    {
+        state.reg_a |= value;
+        set_zero_negative(state, state.reg_a);
+    };
 
-        // Save value in accumulator.
-        state.reg_a = result;
+    // BIT
+    //    N and V come from the operand, Z from the masked result.
+    const auto bit_op = [](state &state, const uint8_t value)
+    {
+        state.status.at(flags::NEGATIVE) = (value & (1U << 7U)) != 0U;
+        state.status.at(flags::OVERFLOW) = (value & (1U << 6U)) != 0U;
+        state.status.at(flags::ZERO)     = ((state.reg_a & value) == 0x00U);
+    };
+
+    // CMP/CPX/CPY
+    const auto compare = [](state &state, const uint8_t reg, const uint8_t value)
+    {
+        state.status.at(flags::CARRY) = (reg >= value);
+        set_zero_negative(state, static_cast<uint8_t>(reg - value));
     };
 
+    const auto cmp_op = [](state &state, const uint8_t value) { compare(state, state.reg_a, value); };
+    const auto cpx_op = [](state &state, const uint8_t value) { compare(state, state.reg_x, value); };
+    const auto cpy_op = [](state &state, const uint8_t value) { compare(state, state.reg_y, value); };
+
+    // LDA/LDX/LDY
+    const auto lda_op = [](state &state, const uint8_t value)
+    {
+        state.reg_a = value;
+        set_zero_negative(state, value);
+    };
+
+    const auto ldx_op = [](state &state, const uint8_t value)
+    {
+        state.reg_x = value;
+        set_zero_negative(state, value);
+    };
+
+    const auto ldy_op = [](state &state, const uint8_t value)
+    {
+        state.reg_y = value;
+        set_zero_negative(state, value);
+    };
+
+    // STA/STX/STY
+    const auto sta_op = [](const state &state) { return state.reg_a; };
+    const auto stx_op = [](const state &state) { return state.reg_x; };
+    const auto sty_op = [](const state &state) { return state.reg_y; };
+
     // ASL
-    const auto asl_op = [](state &state)
+    const auto asl_op = [](state &state, const uint8_t value)
     {
-        // Is there a way where we can ensure we never attempt to call this with
-        // an unsupported addressing mode?
-        const bool    carry_result = (state.reg_a >= 128U);
-        const uint8_t result       = (1U << state.reg_a);
+        const uint8_t result = static_cast<uint8_t>(value << 1U);
 
-        // Set flags.
-        state.status.reset();
-        state.status.at(flags::CARRY)    = carry_result;
-        state.status.at(flags::ZERO)     = (result == 0);
-        state.status.at(flags::NEGATIVE) = (result & (1 << 7U));
+        state.status.at(flags::CARRY) = (value & 0x80U) != 0U;
+        set_zero_negative(state, result);
 
-        // Save value in accumulator.
-        state.reg_a = result;
+        return result;
+    };
+
+    // LSR
+    const auto lsr_op = [](state &state, const uint8_t value)
+    {
+        const uint8_t result = static_cast<uint8_t>(value >> 1U);
+
+        state.status.at(flags::CARRY) = (value & 0x01U) != 0U;
+        set_zero_negative(state, result);
+
+        return result;
+    };
+
+    // ROL
+    const auto rol_op = [](state &state, const uint8_t value)
+    {
+        const uint8_t result = static_cast<uint8_t>((value << 1U) | (state.status.at(flags::CARRY) ? 0x01U : 0x00U));
+
+        state.status.at(flags::CARRY) = (value & 0x80U) != 0U;
+        set_zero_negative(state, result);
+
+        return result;
+    };
+
+    // ROR
+    const auto ror_op = [](state &state, const uint8_t value)
+    {
+        const uint8_t result = static_cast<uint8_t>((value >> 1U) | (state.status.at(flags::CARRY) ? 0x80U : 0x00U));
+
+        state.status.at(flags::CARRY) = (value & 0x01U) != 0U;
+        set_zero_negative(state, result);
+
+        return result;
+    };
+
+    // INC/DEC
+    const auto inc_op = [](state &state, const uint8_t value)
+    {
+        const uint8_t result = static_cast<uint8_t>(value + 1U);
+        set_zero_negative(state, result);
+        return result;
+    };
+
+    const auto dec_op = [](state &state, const uint8_t value)
+    {
+        const uint8_t result = static_cast<uint8_t>(value - 1U);
+        set_zero_negative(state, result);
+        return result;
     };
 
     // BCC (branch on carry clear)
     const auto bcc_op = [](state &state, const int8_t relative_offset)
     {
         !state.status.at(flags::CARRY) ? state.pc += relative_offset : state.pc += 1U;
-        
-        // NOTE: Do these instructions require us to reset the status reg?
     };
 
     // BCS (branch on carry set)
@@ -587,22 +714,68 @@ namespace op
         state.status.at(flags::ZERO) ? state.pc += relative_offset : state.pc += 1U;
     };
 
-    // BCS (branch on carry set)
-    const auto bit_op = [](state &state, const uint8_t value)
+    //
+    // Unofficial combinations, used by a handful of games and by nestest.
+    //
+    const auto lax_op = [](state &state, const uint8_t value)
     {
-        const bool masking_result = state.reg_a & value;
-        
-        state.status.reset();
-        state.status.at(flags::NEGATIVE) = (masking_result & (1 << 7)); // Set to value of bit 7
-        state.status.at(flags::OVERFLOW) = (masking_result & (1 << 6)); // Set to value of bit 6
-        state.status.at(flags::ZERO)     = (masking_result == 0x00);
+        lda_op(state, value);
+        state.reg_x = value;
+    };
+
+    const auto sax_op = [](const state &state) { return static_cast<uint8_t>(state.reg_a & state.reg_x); };
+
+    const auto slo_op = [](state &state, const uint8_t value)
+    {
+        const uint8_t result = asl_op(state, value);
+        ora_op(state, result);
+        return result;
+    };
+
+    const auto rla_op = [](state &state, const uint8_t value)
+    {
+        const uint8_t result = rol_op(state, value);
+        and_op(state, result);
+        return result;
     };
 
+    const auto sre_op = [](state &state, const uint8_t value)
+    {
+        const uint8_t result = lsr_op(state, value);
+        eor_op(state, result);
+        return result;
+    };
+
+    const auto rra_op = [](state &state, const uint8_t value)
+    {
+        const uint8_t result = ror_op(state, value);
+        adc_op(state, result);
+        return result;
+    };
+
+    const auto dcp_op = [](state &state, const uint8_t value)
+    {
+        const uint8_t result = static_cast<uint8_t>(value - 1U);
+        cmp_op(state, result);
+        return result;
+    };
+
+    const auto isb_op = [](state &state, const uint8_t value)
+    {
+        const uint8_t result = static_cast<uint8_t>(value + 1U);
+        sbc_op(state, result);
+        return result;
+    };
+
+    // Reads that are thrown away (unofficial NOPs with operands).
+    const auto nop_op = [](state &, const uint8_t) {};
+
 } // namespace op
 
 // Struct containing everything needed to define a 6502 instruction. 
+//    Superseded, like `address`, by the interpreter in interpreter.hh.
 template<typename AddressingFunc, typename OperationFunc>
-class instruction
+class [[deprecated("Use cpu::step() from interpreter.hh")]] instruction
 {
 public:
     instruction(const std::string_view &name,
@@ -625,8 +798,8 @@ public:
     // 
     void operator()(const memory &mem, state &s) const
     {
-        // TODO: Handle num_clk_cycles here.
         addr_func_(op_func_, mem, s);
+        s.cycles += num_clk_cycles;
     }
 
     // TODO: Add << operator
@@ -0,0 +1,105 @@
+#include "debugger.hh"
+
+#include "console.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nes
+{
+
+debugger::debugger(console &c)
+    : console_(c)
+{
+    if(console_.debugger_ != nullptr)
+    {
+        throw std::logic_error("Console already has a debugger!");
+    }
+    console_.debugger_ = this;
+}
+
+debugger::~debugger()
+{
+    clear();
+    console_.debugger_ = nullptr;
+}
+
+std::size_t debugger::add_breakpoint(const uint16_t pc, condition when)
+{
+    return add_watchpoint(pc, pc, EXECUTE, std::move(when));
+}
+
+std::size_t debugger::add_watchpoint(const uint16_t first, const uint16_t last, const uint8_t kinds, condition when)
+{
+    if(first > last)
+    {
+        throw std::invalid_argument("Watchpoint range is empty!");
+    }
+    if(kinds == 0U || (kinds & ~(READ | WRITE | EXECUTE)) != 0U)
+    {
+        throw std::invalid_argument("Watchpoint needs access kinds!");
+    }
+
+    watches_.push_back({next_id_, first, last, kinds, std::move(when)});
+    update_pages();
+    return next_id_++;
+}
+
+void debugger::remove(const std::size_t id)
+{
+    const auto found = std::find_if(watches_.begin(), watches_.end(), [id](const watch &w) { return w.id == id; });
+    if(found == watches_.end())
+    {
+        throw std::invalid_argument("Unknown watchpoint!");
+    }
+
+    watches_.erase(found);
+    update_pages();
+}
+
+void debugger::clear()
+{
+    watches_.clear();
+    update_pages();
+}
+
+bool debugger::check(const kind what, const uint16_t address, const uint8_t value, const cpu::state &s)
+{
+    if(!watched(what, address))
+    {
+        return false;
+    }
+
+    for(const watch &w : watches_)
+    {
+        if((w.kinds & what) != 0U && address >= w.first && address <= w.last && (!w.when || w.when(s)))
+        {
+            last_ = {w.id, what, address, value, s};
+            ++hits_;
+            return true;
+        }
+    }
+    return false;
+}
+
+void debugger::update_pages()
+{
+    pages_.fill(0U);
+    for(const watch &w : watches_)
+    {
+        for(std::size_t page = w.first >> memory_map::PAGE_BITS; page <= (w.last >> memory_map::PAGE_BITS); ++page)
+        {
+            pages_[page] |= w.kinds;
+        }
+    }
+
+    execute_pages_ = 0U;
+    for(std::size_t page = 0U; page < pages_.size(); ++page)
+    {
+        const uint16_t address = static_cast<uint16_t>(page << memory_map::PAGE_BITS);
+        console_.map_.watch(address, (pages_[page] & READ) != 0U, (pages_[page] & WRITE) != 0U);
+        execute_pages_ += (pages_[page] & EXECUTE) != 0U ? 1U : 0U;
+    }
+}
+
+} // namespace nes
@@ -0,0 +1,116 @@
+#include "bus.hh"
+#include "cpu.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#pragma once
+
+//
+// Breakpoints and watchpoints for a running console.
+//
+// Watches are kept as per-page flags. Pages watched for reads or writes are taken off
+// the page table's fast path, so their accesses reach the console's I/O handlers,
+// which check them here; every other page is accessed exactly as without a debugger.
+// Execution breakpoints switch the console to a run loop that checks the page of each
+// instruction, and only while one is armed. With nothing armed, or no debugger
+// attached, emulation runs the plain loops.
+//
+// A break stops `console::run_frame()` after the instruction that hit a read or write
+// watch, or before the instruction at an execution breakpoint; calling it again
+// resumes. Stopping does not change the emulation.
+//
+
+namespace nes
+{
+
+class console;
+
+class debugger
+{
+public:
+    // Access kinds, combined as flags.
+    enum kind : uint8_t
+    {
+        READ    = 0x01U,
+        WRITE   = 0x02U,
+        EXECUTE = 0x04U
+    };
+
+    // Extra test for a break, on the CPU registers. For reads and writes they are the
+    // ones at the start of the accessing instruction (the PC excepted).
+    using condition = std::function<bool(const cpu::state &s)>;
+
+    struct hit
+    {
+        std::size_t id;
+        kind        what;
+        uint16_t    address;
+        uint8_t     value;  // Read or written; the opcode for execution.
+        cpu::state  cpu;
+    };
+
+    // Attaches to `c`, which must outlive the debugger. Throws std::logic_error if `c`
+    // already has one.
+    explicit debugger(console &c);
+
+    // Removes every watch and detaches.
+    ~debugger();
+
+    debugger(const debugger &)            = delete;
+    debugger &operator=(const debugger &) = delete;
+
+    // Each returns an id for `remove()`. Throw std::invalid_argument on an empty range
+    // or no access kinds.
+    std::size_t add_breakpoint(uint16_t pc, condition when = condition());
+    std::size_t add_watchpoint(uint16_t first, uint16_t last, uint8_t kinds, condition when = condition());
+
+    // Throws std::invalid_argument for an unknown id.
+    void remove(std::size_t id);
+    void clear();
+
+    // Most recent break; valid once `hits()` is non-zero.
+    const hit &last_hit() const { return last_; }
+    uint64_t   hits() const { return hits_; }
+
+private:
+    friend class console;
+
+    struct watch
+    {
+        std::size_t id;
+        uint16_t    first;
+        uint16_t    last;
+        uint8_t     kinds;
+        condition   when;
+    };
+
+    // True if `address` is on a page watched for `what`.
+    bool watched(const kind what, const uint16_t address) const
+    {
+        return (pages_[address >> memory_map::PAGE_BITS] & what) != 0U;
+    }
+
+    bool armed() const { return !watches_.empty(); }
+    bool breaks_execution() const { return execute_pages_ != 0U; }
+
+    // Records and returns true if a watch breaks on this access.
+    bool check(kind what, uint16_t address, uint8_t value, const cpu::state &s);
+
+    // Rebuilds the page flags and the console's watched pages.
+    void update_pages();
+
+    console                                    &console_;
+    std::vector<watch>                          watches_;
+    std::array<uint8_t, memory_map::PAGE_COUNT> pages_{};
+    std::size_t                                 execute_pages_ = 0U;
+    std::size_t                                 next_id_       = 0U;
+
+    hit      last_{};
+    uint64_t hits_ = 0U;
+};
+
+} // namespace nes
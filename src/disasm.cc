@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+#include "cartridge.hh"
+#include "disassembler.hh"
+#include "utils.hh"
+
+//
+// nes-emu-disasm: lists a ROM's PRG banks, or scans a ROM library for reachable code
+// and how often each opcode is used in it.
+//
+
+namespace
+{
+    constexpr std::size_t TOP_OPCODES = 16U;
+
+    void print_usage()
+    {
+        std::cerr << "usage: nes-emu-disasm <rom.nes>\n"
+                  << "       nes-emu-disasm --scan [--jobs <count>] <rom.nes|dir>...\n";
+    }
+
+    // Tenths of a percent of `part` in `whole`, as "12.3%".
+    void write_percent(utils::buffered_writer &out, const uint64_t part, const uint64_t whole)
+    {
+        const uint64_t tenths = whole > 0U ? (1000U * part) / whole : 0U;
+        out.decimal(tenths / 10U);
+        out.put('.');
+        out.decimal(tenths % 10U);
+        out.put('%');
+    }
+
+    int scan(const std::vector<std::string> &paths, const unsigned jobs)
+    {
+        const std::vector<cpu::disassembler::rom_statistics> results = cpu::disassembler::scan_corpus(paths, jobs);
+
+        utils::buffered_writer     out(std::cout);
+        std::array<uint64_t, 256U> totals{};
+        std::size_t                failed = 0U;
+        for(const cpu::disassembler::rom_statistics &rom : results)
+        {
+            if(!rom.error.empty())
+            {
+                ++failed;
+                out.put("ERROR  ");
+                out.put(rom.rom);
+                out.put(": ");
+                out.put(rom.error);
+                out.put('\n');
+                continue;
+            }
+
+            write_percent(out, rom.reachable_bytes, rom.prg_bytes);
+            out.put(" reachable, ");
+            out.decimal(rom.reachable_instructions);
+            out.put(" instructions  ");
+            out.put(rom.rom);
+            out.put('\n');
+
+            for(std::size_t op = 0U; op < totals.size(); ++op)
+            {
+                totals[op] += rom.reachable_opcodes[op];
+            }
+        }
+
+        // Most used opcodes in reachable code across the library.
+        const uint64_t           total = std::accumulate(totals.begin(), totals.end(), uint64_t{0U});
+        std::vector<std::size_t> order(totals.size());
+        std::iota(order.begin(), order.end(), 0U);
+        std::partial_sort(order.begin(), order.begin() + TOP_OPCODES, order.end(),
+                          [&totals](const std::size_t a, const std::size_t b) { return totals[a] > totals[b]; });
+
+        out.put("\nTop opcodes in reachable code (");
+        out.decimal(total);
+        out.put(" instructions):\n");
+        for(std::size_t i = 0U; i < TOP_OPCODES && totals[order[i]] > 0U; ++i)
+        {
+            const uint8_t bytes[3] = {static_cast<uint8_t>(order[i]), 0x00U, 0x00U};
+            out.put("  ");
+            out.hex8(bytes[0]);
+            out.put("  ");
+            write_percent(out, totals[order[i]], total);
+            out.put("  ");
+            cpu::disassembler::write_instruction(out, bytes, sizeof(bytes), 0x0000U);
+            out.put('\n');
+        }
+
+        out.flush();
+        return failed == 0U ? 0 : 1;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    bool                     scanning = false;
+    unsigned                 jobs     = 0U;  // One per core.
+    std::vector<std::string> paths;
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "--scan") == 0)
+        {
+            scanning = true;
+        }
+        else if(std::strcmp(argv[i], "--jobs") == 0 && i + 1 < argc)
+        {
+            jobs = static_cast<unsigned>(std::stoul(argv[++i]));
+        }
+        else if(argv[i][0] == '-')
+        {
+            print_usage();
+            return 2;
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if(scanning && !paths.empty())
+    {
+        return scan(paths, jobs);
+    }
+    if(scanning || paths.size() != 1U)
+    {
+        print_usage();
+        return 2;
+    }
+
+    try
+    {
+        const std::vector<uint8_t> prg = nes::ines_prg(utils::read_file(paths[0]));
+        utils::buffered_writer     out(std::cout);
+        cpu::disassembler::write_prg_listing(out, prg);
+    }
+    catch(const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,233 @@
+#include "disassembler.hh"
+
+#include "cartridge.hh"
+#include "code_trace.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace cpu
+{
+
+namespace disassembler
+{
+
+namespace
+{
+    constexpr uint16_t    PRG_START       = 0x8000U;
+    constexpr uint16_t    FIXED_BANK      = 0xC000U;
+    constexpr std::size_t BANK_SIZE       = 0x4000U;
+    constexpr std::size_t PRG_WINDOW_SIZE = 0x8000U;
+
+    // Marks of the reachability trace, per byte of the PRG window.
+    constexpr uint8_t UNVISITED   = 0U;
+    constexpr uint8_t INSTRUCTION = 1U;
+    constexpr uint8_t OPERAND     = 2U;
+
+    // $8000 - $FFFF as the CPU sees `prg` at power-on.
+    class prg_window
+    {
+    public:
+        explicit prg_window(const std::vector<uint8_t> &prg) : prg_(prg) {}
+
+        uint8_t read(const uint16_t address) const
+        {
+            const std::size_t offset = address - PRG_START;
+            if(prg_.size() <= PRG_WINDOW_SIZE)
+            {
+                return prg_[offset % prg_.size()];
+            }
+            return address < FIXED_BANK ? prg_[offset] : prg_[prg_.size() - BANK_SIZE + (offset - BANK_SIZE)];
+        }
+
+    private:
+        const std::vector<uint8_t> &prg_;
+    };
+
+    void write_data(utils::buffered_writer &out, const uint8_t *bytes, const std::size_t count)
+    {
+        out.put(".byte ");
+        for(std::size_t i = 0U; i < count; ++i)
+        {
+            out.put(i > 0U ? ", $" : "$");
+            out.hex8(bytes[i]);
+        }
+    }
+
+    // Where bank `bank` of `banks` is listed.
+    uint16_t bank_address(const std::size_t bank, const std::size_t banks)
+    {
+        return bank + 1U == banks ? FIXED_BANK : PRG_START;
+    }
+} // namespace
+
+std::size_t write_instruction(utils::buffered_writer &out, const uint8_t *bytes, const std::size_t available,
+                              const uint16_t address)
+{
+    const opcode_info &info   = OPCODES[bytes[0]];
+    const std::size_t  length = info.length();
+    if(!info.official() || available < length)
+    {
+        const std::size_t count = std::min(length, available);
+        write_data(out, bytes, count);
+        return count;
+    }
+
+    out.put(info.mnemonic[0]);
+    out.put(info.mnemonic[1]);
+    out.put(info.mnemonic[2]);
+
+    using assembler::mode;
+    const mode m = info.addressing();
+    switch(m)
+    {
+        case mode::IMPLIED: return length;
+        case mode::ACCUMULATOR: out.put(" A"); return length;
+        case mode::IMMEDIATE: out.put(" #$"); break;
+        case mode::INDIRECT:
+        case mode::INDIRECT_X:
+        case mode::INDIRECT_Y: out.put(" ($"); break;
+        default: out.put(" $"); break;
+    }
+
+    if(m == mode::RELATIVE)
+    {
+        out.hex16(static_cast<uint16_t>(address + 2U + static_cast<int8_t>(bytes[1])));
+    }
+    else if(length == 3U)
+    {
+        out.hex16(static_cast<uint16_t>(bytes[1] | (bytes[2] << 8U)));
+    }
+    else
+    {
+        out.hex8(bytes[1]);
+    }
+
+    switch(m)
+    {
+        case mode::ZERO_PAGE_X:
+        case mode::ABSOLUTE_X: out.put(",X"); break;
+        case mode::ZERO_PAGE_Y:
+        case mode::ABSOLUTE_Y: out.put(",Y"); break;
+        case mode::INDIRECT: out.put(')'); break;
+        case mode::INDIRECT_X: out.put(",X)"); break;
+        case mode::INDIRECT_Y: out.put("),Y"); break;
+        default: break;
+    }
+    return length;
+}
+
+void write_listing(utils::buffered_writer &out, const uint8_t *bytes, const std::size_t size, uint16_t address)
+{
+    for(std::size_t pos = 0U; pos < size;)
+    {
+        const std::size_t shown = std::min<std::size_t>(OPCODES[bytes[pos]].length(), size - pos);
+
+        out.hex16(address);
+        out.put("  ");
+        for(std::size_t i = 0U; i < 3U; ++i)
+        {
+            if(i > 0U)
+            {
+                out.put(' ');
+            }
+            if(i < shown)
+            {
+                out.hex8(bytes[pos + i]);
+            }
+            else
+            {
+                out.put("  ");
+            }
+        }
+        out.put("  ");
+
+        const std::size_t length = write_instruction(out, bytes + pos, size - pos, address);
+        out.put('\n');
+
+        pos     += length;
+        address = static_cast<uint16_t>(address + length);
+    }
+}
+
+void write_prg_listing(utils::buffered_writer &out, const std::vector<uint8_t> &prg)
+{
+    const std::size_t banks = prg.size() / BANK_SIZE;
+    for(std::size_t bank = 0U; bank < banks; ++bank)
+    {
+        out.put("; bank ");
+        out.decimal(bank);
+        out.put('\n');
+        write_listing(out, prg.data() + bank * BANK_SIZE, BANK_SIZE, bank_address(bank, banks));
+    }
+}
+
+rom_statistics scan_prg(const std::vector<uint8_t> &prg)
+{
+    if(prg.empty() || (prg.size() % BANK_SIZE) != 0U)
+    {
+        throw std::runtime_error("PRG-ROM must be whole 16 KiB banks!");
+    }
+
+    rom_statistics stats;
+    stats.prg_bytes = prg.size();
+
+    for(std::size_t pos = 0U; pos < prg.size();)
+    {
+        const uint8_t op = prg[pos];
+        ++stats.swept_opcodes[op];
+        pos += OPCODES[op].length();
+    }
+
+    const prg_window     window(prg);
+    std::vector<uint8_t> marks(PRG_WINDOW_SIZE, UNVISITED);
+
+    cpu::trace_code([&window](const uint16_t address) { return window.read(address); },
+                    [](const uint16_t, const bool) {},
+                    [&marks, &stats](const uint16_t address, const uint8_t op)
+                    {
+                        if(marks[address - PRG_START] == INSTRUCTION)
+                        {
+                            return false;
+                        }
+
+                        marks[address - PRG_START] = INSTRUCTION;
+                        for(std::size_t i = 1U; i < OPCODES[op].length(); ++i)
+                        {
+                            uint8_t &mark = marks[address - PRG_START + i];
+                            mark          = mark == UNVISITED ? OPERAND : mark;
+                        }
+                        ++stats.reachable_instructions;
+                        ++stats.reachable_opcodes[op];
+                        return true;
+                    });
+
+    stats.reachable_bytes =
+        static_cast<std::size_t>(std::count_if(marks.begin(), marks.end(), [](const uint8_t m) { return m != UNVISITED; }));
+    return stats;
+}
+
+std::vector<rom_statistics> scan_corpus(const std::vector<std::string> &paths, const unsigned jobs)
+{
+    const std::vector<std::string> roms = nes::find_roms(paths);
+
+    std::vector<rom_statistics> results(roms.size());
+    utils::parallel_for_each(roms, jobs,
+                             [&results](const std::string &rom, const std::size_t i)
+                             {
+                                 try
+                                 {
+                                     results[i] = scan_prg(nes::ines_prg(utils::read_file(rom)));
+                                 }
+                                 catch(const std::exception &e)
+                                 {
+                                     results[i].error = e.what();
+                                 }
+                                 results[i].rom = rom;
+                             });
+    return results;
+}
+
+} // namespace disassembler
+
+} // namespace cpu
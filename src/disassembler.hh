@@ -0,0 +1,112 @@
+#include "assembler.hh"
+#include "interpreter.hh"
+#include "utils.hh"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma once
+
+//
+// Table-driven 6502 disassembler, for single instructions, whole-bank listings, and
+// reachability and opcode statistics over ROM libraries.
+//
+// Output is the assembler's syntax (`LDA $12,X`, `BNE $C002`, `.byte $A7, $12` for
+// opcodes without an official encoding), so any instruction reassembles to the
+// bytes it came from. Text goes through `utils::buffered_writer`, with no stream
+// formatting per line.
+//
+
+namespace cpu
+{
+
+namespace disassembler
+{
+
+// One opcode, packed into four bytes.
+struct opcode_info
+{
+    char    mnemonic[3];  // Zero for opcodes without an official encoding.
+    uint8_t packed;       // assembler::mode in the low nibble, length in the high.
+
+    constexpr assembler::mode addressing() const { return static_cast<assembler::mode>(packed & 0x0FU); }
+    constexpr uint8_t         length() const { return static_cast<uint8_t>(packed >> 4U); }
+    constexpr bool            official() const { return mnemonic[0] != '\0'; }
+};
+
+static_assert(sizeof(opcode_info) == 4U, "Opcode table entries must stay packed!");
+
+namespace detail
+{
+    constexpr std::array<opcode_info, 256U> make_opcodes()
+    {
+        std::array<opcode_info, 256U> table{};
+        for(std::size_t op = 0U; op < table.size(); ++op)
+        {
+            table[op].packed = static_cast<uint8_t>(LENGTHS[op] << 4U);
+        }
+
+        for(const assembler::encoding &e : assembler::ENCODINGS)
+        {
+            const std::size_t op = static_cast<uint8_t>(e.code);
+            if(assembler::detail::operand_bytes(e.addressing) + 1U != LENGTHS[op])
+            {
+                throw std::logic_error("Encoding and interpreter disagree on a length!");
+            }
+
+            for(std::size_t i = 0U; i < 3U; ++i)
+            {
+                table[op].mnemonic[i] = e.mnemonic[i];
+            }
+            table[op].packed = static_cast<uint8_t>((LENGTHS[op] << 4U) | static_cast<uint8_t>(e.addressing));
+        }
+        return table;
+    }
+} // namespace detail
+
+constexpr std::array<opcode_info, 256U> OPCODES = detail::make_opcodes();
+
+// Writes the instruction at `bytes`, for `address`, as source text and returns its
+// length. If fewer than that many bytes are `available`, they are written as data.
+std::size_t write_instruction(utils::buffered_writer &out, const uint8_t *bytes, std::size_t available,
+                              uint16_t address);
+
+// One line per instruction, sweeping `[bytes, bytes + size)` loaded at `address`:
+//     C000  A2 05     LDX #$05
+void write_listing(utils::buffered_writer &out, const uint8_t *bytes, std::size_t size, uint16_t address);
+
+// The listing of every bank of `prg`, headed `; bank <n>`. Banks are placed as in
+// `scan_prg()`.
+void write_prg_listing(utils::buffered_writer &out, const std::vector<uint8_t> &prg);
+
+struct rom_statistics
+{
+    std::string rom;
+    std::string error;  // Why the ROM could not be scanned, if it could not.
+
+    std::size_t prg_bytes = 0U;
+
+    // Code found by following control flow from the vectors.
+    std::size_t               reachable_bytes        = 0U;
+    std::size_t               reachable_instructions = 0U;
+    std::array<uint64_t, 256U> reachable_opcodes{};
+
+    // Every opcode a linear sweep of each bank decodes, data included.
+    std::array<uint64_t, 256U> swept_opcodes{};
+};
+
+// Statistics for one PRG-ROM. Control flow is followed from the NMI, reset and IRQ
+// vectors through $8000 - $FFFF as the CPU sees the cartridge at power-on: mirrored
+// up to 32 KiB, otherwise the first bank at $8000 and the last at $C000, as with
+// fixed-bank mappers. Indirect jumps, returns and code in other banks end a path.
+rom_statistics scan_prg(const std::vector<uint8_t> &prg);
+
+// Scans the ROMs at `paths` (files, or directories searched for *.nes) on `jobs`
+// threads (0 for one per core). Results are in path order.
+std::vector<rom_statistics> scan_corpus(const std::vector<std::string> &paths, unsigned jobs);
+
+} // namespace disassembler
+
+} // namespace cpu
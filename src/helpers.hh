@@ -1,6 +1,8 @@
 #include <stdint.h>
 #include <utility>
 
+#pragma once
+
 namespace helpers
 {
     // Types 
@@ -45,7 +47,7 @@ namespace helpers
     }
 
     // Helper function that will 
-    carry_result sum_with_carry(const uint8_t val_a, const uint8_t val_b)
+    inline carry_result sum_with_carry(const uint8_t val_a, const uint8_t val_b)
     {
         uint16_t sum = val_a + val_b;
         return {std::move(static_cast<uint8_t>(sum)), sum > 0xFF};
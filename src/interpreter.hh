@@ -0,0 +1,832 @@
+#include "cpu.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <type_traits>
+
+#pragma once
+
+//
+// Executes 6502 code against a bus.
+//
+// `Bus` is any type with
+//     uint8_t read(uint16_t address);
+//     void    write(uint16_t address, uint8_t value);
+//
+// How bus cycles are issued is picked at compile time by an accuracy policy:
+//
+//  - `accuracy::fast` executes instructions whole: only the accesses that carry data
+//    are made, and the instruction's cycles are charged to `state::cycles` afterwards,
+//    so I/O sees the cycle count at the start of the instruction.
+//  - `accuracy::exact` issues every bus cycle in order, including the dummy reads of
+//    indexing fix-ups, implied operands and the stack, and the double write of
+//    read-modify-write instructions, and advances `state::cycles` with each one, so I/O
+//    sees the cycle it actually happens on.
+//
+// Both share the `op` namespace for the semantics; this file only decodes, addresses
+// and counts cycles. It replaces `cpu::address` and `cpu::instruction` in cpu.hh, which
+// are deprecated.
+//
+
+namespace cpu
+{
+
+// Interrupt/reset vectors.
+constexpr uint16_t NMI_VECTOR   = 0xFFFAU;
+constexpr uint16_t RESET_VECTOR = 0xFFFCU;
+constexpr uint16_t IRQ_VECTOR   = 0xFFFEU;
+
+constexpr uint16_t STACK_PAGE = 0x0100U;
+
+// Cycles taken by each opcode, excluding page-crossing and branch penalties.
+constexpr std::array<uint8_t, 256U> CYCLES = {
+//  0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+    7, 6, 2, 8, 3, 3, 5, 5, 3, 2, 2, 2, 4, 4, 6, 6,  // 0
+    2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,  // 1
+    6, 6, 2, 8, 3, 3, 5, 5, 4, 2, 2, 2, 4, 4, 6, 6,  // 2
+    2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,  // 3
+    6, 6, 2, 8, 3, 3, 5, 5, 3, 2, 2, 2, 3, 4, 6, 6,  // 4
+    2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,  // 5
+    6, 6, 2, 8, 3, 3, 5, 5, 4, 2, 2, 2, 5, 4, 6, 6,  // 6
+    2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,  // 7
+    2, 6, 2, 6, 3, 3, 3, 3, 2, 2, 2, 2, 4, 4, 4, 4,  // 8
+    2, 6, 2, 6, 4, 4, 4, 4, 2, 5, 2, 5, 5, 5, 5, 5,  // 9
+    2, 6, 2, 6, 3, 3, 3, 3, 2, 2, 2, 2, 4, 4, 4, 4,  // A
+    2, 5, 2, 5, 4, 4, 4, 4, 2, 4, 2, 4, 4, 4, 4, 4,  // B
+    2, 6, 2, 8, 3, 3, 5, 5, 2, 2, 2, 2, 4, 4, 6, 6,  // C
+    2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7,  // D
+    2, 6, 2, 8, 3, 3, 5, 5, 2, 2, 2, 2, 4, 4, 6, 6,  // E
+    2, 5, 2, 8, 4, 4, 6, 6, 2, 4, 2, 7, 4, 4, 7, 7}; // F
+
+// Bytes taken by each opcode, including the opcode itself. The stack byte after BRK and
+// the opcodes that halt the CPU count as one.
+constexpr std::array<uint8_t, 256U> LENGTHS = {
+//  0  1  2  3  4  5  6  7  8  9  A  B  C  D  E  F
+    1, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // 0
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // 1
+    3, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // 2
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // 3
+    1, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // 4
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // 5
+    1, 2, 1, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // 6
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // 7
+    2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // 8
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // 9
+    2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // A
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // B
+    2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // C
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3,  // D
+    2, 2, 2, 2, 2, 2, 2, 2, 1, 2, 1, 2, 3, 3, 3, 3,  // E
+    2, 2, 1, 2, 2, 2, 2, 2, 1, 3, 1, 3, 3, 3, 3, 3}; // F
+
+// Addressing modes of instructions with a memory operand.
+enum class mode : uint8_t
+{
+    IMMEDIATE,
+    ZERO_PAGE,
+    ZERO_PAGE_X,
+    ZERO_PAGE_Y,
+    ABSOLUTE,
+    ABSOLUTE_X,
+    ABSOLUTE_Y,
+    INDIRECT_X,
+    INDIRECT_Y
+};
+
+namespace detail
+{
+    // Wraps a bus for `accuracy::exact`: each access takes one cycle.
+    template<typename Bus>
+    class cycle_bus
+    {
+    public:
+        cycle_bus(Bus &bus, state &s) : bus_(bus), s_(s) {}
+
+        uint8_t read(const uint16_t address)
+        {
+            const uint8_t value = bus_.read(address);
+            tick();
+            return value;
+        }
+
+        void write(const uint16_t address, const uint8_t value)
+        {
+            bus_.write(address, value);
+            tick();
+        }
+
+        uint32_t accesses() const { return accesses_; }
+
+    private:
+        void tick()
+        {
+            ++s_.cycles;
+            ++accesses_;
+        }
+
+        Bus     &bus_;
+        state   &s_;
+        uint32_t accesses_ = 0U;
+    };
+
+    template<typename Bus>
+    struct is_exact : std::false_type
+    {
+    };
+
+    template<typename Bus>
+    struct is_exact<cycle_bus<Bus>> : std::true_type
+    {
+    };
+
+    // True when every bus cycle has to be issued.
+    template<typename Bus>
+    constexpr bool EXACT = is_exact<Bus>::value;
+
+    template<typename Bus>
+    uint8_t fetch(Bus &bus, state &s)
+    {
+        return bus.read(s.pc++);
+    }
+
+    template<typename Bus>
+    uint16_t fetch_word(Bus &bus, state &s)
+    {
+        const uint8_t LSB = fetch(bus, s);
+        const uint8_t MSB = fetch(bus, s);
+        return static_cast<uint16_t>((MSB << 8U) | LSB);
+    }
+
+    // Reads a pointer from the zero page, wrapping within it.
+    template<typename Bus>
+    uint16_t read_zero_page_word(Bus &bus, const uint8_t address)
+    {
+        const uint8_t LSB = bus.read(address);
+        const uint8_t MSB = bus.read(static_cast<uint8_t>(address + 1U));
+        return static_cast<uint16_t>((MSB << 8U) | LSB);
+    }
+
+    template<typename Bus>
+    void push(Bus &bus, state &s, const uint8_t value)
+    {
+        bus.write(STACK_PAGE | (s.sp & 0xFFU), value);
+        s.sp = (s.sp - 1U) & 0xFFU;
+    }
+
+    template<typename Bus>
+    uint8_t pull(Bus &bus, state &s)
+    {
+        s.sp = (s.sp + 1U) & 0xFFU;
+        return bus.read(STACK_PAGE | s.sp);
+    }
+
+    template<typename Bus>
+    void push_word(Bus &bus, state &s, const uint16_t value)
+    {
+        push(bus, s, static_cast<uint8_t>(value >> 8U));
+        push(bus, s, static_cast<uint8_t>(value));
+    }
+
+    template<typename Bus>
+    uint16_t pull_word(Bus &bus, state &s)
+    {
+        const uint8_t LSB = pull(bus, s);
+        const uint8_t MSB = pull(bus, s);
+        return static_cast<uint16_t>((MSB << 8U) | LSB);
+    }
+
+    // The cycle spent on the stack before a pull, or on the stack pointer before JSR's
+    // pushes.
+    template<typename Bus>
+    void stack_dummy_read(Bus &bus, const state &s)
+    {
+        if constexpr(EXACT<Bus>)
+        {
+            bus.read(STACK_PAGE | (s.sp & 0xFFU));
+        }
+    }
+
+    // Effective address of the operand. `crossed` is set when indexing carried into
+    // the high byte, which costs read instructions an extra cycle. Instructions that
+    // `WRITE` always take that cycle, so they never act on the unfixed address.
+    template<mode M, bool WRITE, typename Bus>
+    uint16_t operand_address(Bus &bus, state &s, bool &crossed)
+    {
+        // The 6502 reads the unfixed address while it adds the carry.
+        const auto fix_up = [&](const uint16_t base, const uint16_t address)
+        {
+            crossed = ((base ^ address) & 0xFF00U) != 0U;
+            if constexpr(EXACT<Bus>)
+            {
+                if(WRITE || crossed)
+                {
+                    bus.read((base & 0xFF00U) | (address & 0x00FFU));
+                }
+            }
+        };
+
+
+        if constexpr(M == mode::IMMEDIATE)
+        {
+            return s.pc++;
+        }
+        else if constexpr(M == mode::ZERO_PAGE)
+        {
+            return fetch(bus, s);
+        }
+        else if constexpr(M == mode::ZERO_PAGE_X || M == mode::ZERO_PAGE_Y)
+        {
+            const uint8_t base = fetch(bus, s);
+            if constexpr(EXACT<Bus>)
+            {
+                bus.read(base);
+            }
+            return static_cast<uint8_t>(base + ((M == mode::ZERO_PAGE_X) ? s.reg_x : s.reg_y));
+        }
+        else if constexpr(M == mode::ABSOLUTE)
+        {
+            return fetch_word(bus, s);
+        }
+        else if constexpr(M == mode::ABSOLUTE_X || M == mode::ABSOLUTE_Y)
+        {
+            const uint16_t base    = fetch_word(bus, s);
+            const uint16_t address = base + ((M == mode::ABSOLUTE_X) ? s.reg_x : s.reg_y);
+            fix_up(base, address);
+            return address;
+        }
+        else if constexpr(M == mode::INDIRECT_X)
+        {
+            const uint8_t pointer = fetch(bus, s);
+            if constexpr(EXACT<Bus>)
+            {
+                bus.read(pointer);
+            }
+            return read_zero_page_word(bus, static_cast<uint8_t>(pointer + s.reg_x));
+        }
+        else
+        {
+            const uint16_t base    = read_zero_page_word(bus, fetch(bus, s));
+            const uint16_t address = base + s.reg_y;
+            fix_up(base, address);
+            return address;
+        }
+    }
+
+    // Instruction shapes. Each returns the penalty cycles on top of `CYCLES`.
+
+    template<mode M, typename Bus, typename Operation>
+    uint32_t read(Bus &bus, state &s, const Operation &op)
+    {
+        bool crossed = false;
+        const uint16_t address = operand_address<M, false>(bus, s, crossed);
+        op(s, bus.read(address));
+        return crossed ? 1U : 0U;
+    }
+
+    template<mode M, typename Bus, typename Operation>
+    uint32_t modify(Bus &bus, state &s, const Operation &op)
+    {
+        bool crossed = false;
+        const uint16_t address = operand_address<M, true>(bus, s, crossed);
+        const uint8_t  value   = bus.read(address);
+
+        // The unmodified value is written back while the operation runs.
+        if constexpr(EXACT<Bus>)
+        {
+            bus.write(address, value);
+        }
+        bus.write(address, op(s, value));
+        return 0U;
+    }
+
+    template<mode M, typename Bus, typename Operation>
+    uint32_t store(Bus &bus, state &s, const Operation &op)
+    {
+        bool crossed = false;
+        const uint16_t address = operand_address<M, true>(bus, s, crossed);
+        bus.write(address, op(s));
+        return 0U;
+    }
+
+    template<typename Operation>
+    uint32_t accumulator(state &s, const Operation &op)
+    {
+        s.reg_a = op(s, s.reg_a);
+        return 0U;
+    }
+
+    // Taken branches cost one cycle, two if they land on another page.
+    template<typename Bus>
+    uint32_t branch(Bus &bus, state &s, const bool condition)
+    {
+        const int8_t offset = static_cast<int8_t>(fetch(bus, s));
+        if(!condition)
+        {
+            return 0U;
+        }
+
+        const uint16_t target = s.pc + offset;
+        const uint32_t extra  = ((target ^ s.pc) & 0xFF00U) != 0U ? 2U : 1U;
+        if constexpr(EXACT<Bus>)
+        {
+            bus.read(s.pc);
+            if(extra == 2U)
+            {
+                bus.read((s.pc & 0xFF00U) | (target & 0x00FFU));
+            }
+        }
+        s.pc = target;
+        return extra;
+    }
+
+    // Opcodes outside the documented set. The stable ones are implemented, the rest
+    // (KIL, and the unstable store/AND combinations) execute as NOPs of the right size.
+    template<typename Bus>
+    uint32_t execute_unofficial(Bus &bus, state &s, const uint8_t opcode)
+    {
+        switch(opcode)
+        {
+            // LAX
+            case 0xA7: return read<mode::ZERO_PAGE>(bus, s, op::lax_op);
+            case 0xB7: return read<mode::ZERO_PAGE_Y>(bus, s, op::lax_op);
+            case 0xAF: return read<mode::ABSOLUTE>(bus, s, op::lax_op);
+            case 0xBF: return read<mode::ABSOLUTE_Y>(bus, s, op::lax_op);
+            case 0xA3: return read<mode::INDIRECT_X>(bus, s, op::lax_op);
+            case 0xB3: return read<mode::INDIRECT_Y>(bus, s, op::lax_op);
+
+            // SAX
+            case 0x87: return store<mode::ZERO_PAGE>(bus, s, op::sax_op);
+            case 0x97: return store<mode::ZERO_PAGE_Y>(bus, s, op::sax_op);
+            case 0x8F: return store<mode::ABSOLUTE>(bus, s, op::sax_op);
+            case 0x83: return store<mode::INDIRECT_X>(bus, s, op::sax_op);
+
+            // SBC (same as 0xE9)
+            case 0xEB: return read<mode::IMMEDIATE>(bus, s, op::sbc_op);
+
+            // Read-modify-write combinations share a layout: base + {03, 07, 0F, 13, 17, 1B, 1F}.
+            case 0x03: return modify<mode::INDIRECT_X>(bus, s, op::slo_op);
+            case 0x07: return modify<mode::ZERO_PAGE>(bus, s, op::slo_op);
+            case 0x0F: return modify<mode::ABSOLUTE>(bus, s, op::slo_op);
+            case 0x13: return modify<mode::INDIRECT_Y>(bus, s, op::slo_op);
+            case 0x17: return modify<mode::ZERO_PAGE_X>(bus, s, op::slo_op);
+            case 0x1B: return modify<mode::ABSOLUTE_Y>(bus, s, op::slo_op);
+            case 0x1F: return modify<mode::ABSOLUTE_X>(bus, s, op::slo_op);
+
+            case 0x23: return modify<mode::INDIRECT_X>(bus, s, op::rla_op);
+            case 0x27: return modify<mode::ZERO_PAGE>(bus, s, op::rla_op);
+            case 0x2F: return modify<mode::ABSOLUTE>(bus, s, op::rla_op);
+            case 0x33: return modify<mode::INDIRECT_Y>(bus, s, op::rla_op);
+            case 0x37: return modify<mode::ZERO_PAGE_X>(bus, s, op::rla_op);
+            case 0x3B: return modify<mode::ABSOLUTE_Y>(bus, s, op::rla_op);
+            case 0x3F: return modify<mode::ABSOLUTE_X>(bus, s, op::rla_op);
+
+            case 0x43: return modify<mode::INDIRECT_X>(bus, s, op::sre_op);
+            case 0x47: return modify<mode::ZERO_PAGE>(bus, s, op::sre_op);
+            case 0x4F: return modify<mode::ABSOLUTE>(bus, s, op::sre_op);
+            case 0x53: return modify<mode::INDIRECT_Y>(bus, s, op::sre_op);
+            case 0x57: return modify<mode::ZERO_PAGE_X>(bus, s, op::sre_op);
+            case 0x5B: return modify<mode::ABSOLUTE_Y>(bus, s, op::sre_op);
+            case 0x5F: return modify<mode::ABSOLUTE_X>(bus, s, op::sre_op);
+
+            case 0x63: return modify<mode::INDIRECT_X>(bus, s, op::rra_op);
+            case 0x67: return modify<mode::ZERO_PAGE>(bus, s, op::rra_op);
+            case 0x6F: return modify<mode::ABSOLUTE>(bus, s, op::rra_op);
+            case 0x73: return modify<mode::INDIRECT_Y>(bus, s, op::rra_op);
+            case 0x77: return modify<mode::ZERO_PAGE_X>(bus, s, op::rra_op);
+            case 0x7B: return modify<mode::ABSOLUTE_Y>(bus, s, op::rra_op);
+            case 0x7F: return modify<mode::ABSOLUTE_X>(bus, s, op::rra_op);
+
+            case 0xC3: return modify<mode::INDIRECT_X>(bus, s, op::dcp_op);
+            case 0xC7: return modify<mode::ZERO_PAGE>(bus, s, op::dcp_op);
+            case 0xCF: return modify<mode::ABSOLUTE>(bus, s, op::dcp_op);
+            case 0xD3: return modify<mode::INDIRECT_Y>(bus, s, op::dcp_op);
+            case 0xD7: return modify<mode::ZERO_PAGE_X>(bus, s, op::dcp_op);
+            case 0xDB: return modify<mode::ABSOLUTE_Y>(bus, s, op::dcp_op);
+            case 0xDF: return modify<mode::ABSOLUTE_X>(bus, s, op::dcp_op);
+
+            case 0xE3: return modify<mode::INDIRECT_X>(bus, s, op::isb_op);
+            case 0xE7: return modify<mode::ZERO_PAGE>(bus, s, op::isb_op);
+            case 0xEF: return modify<mode::ABSOLUTE>(bus, s, op::isb_op);
+            case 0xF3: return modify<mode::INDIRECT_Y>(bus, s, op::isb_op);
+            case 0xF7: return modify<mode::ZERO_PAGE_X>(bus, s, op::isb_op);
+            case 0xFB: return modify<mode::ABSOLUTE_Y>(bus, s, op::isb_op);
+            case 0xFF: return modify<mode::ABSOLUTE_X>(bus, s, op::isb_op);
+
+            // NOPs with operands.
+            case 0x80: case 0x82: case 0x89: case 0xC2: case 0xE2:
+                return read<mode::IMMEDIATE>(bus, s, op::nop_op);
+
+            case 0x04: case 0x44: case 0x64:
+                return read<mode::ZERO_PAGE>(bus, s, op::nop_op);
+
+            case 0x14: case 0x34: case 0x54: case 0x74: case 0xD4: case 0xF4:
+                return read<mode::ZERO_PAGE_X>(bus, s, op::nop_op);
+
+            case 0x0C:
+                return read<mode::ABSOLUTE>(bus, s, op::nop_op);
+
+            case 0x1C: case 0x3C: case 0x5C: case 0x7C: case 0xDC: case 0xFC:
+                return read<mode::ABSOLUTE_X>(bus, s, op::nop_op);
+
+            // Remaining opcodes with operands: skip them without touching memory.
+            case 0x0B: case 0x2B: case 0x4B: case 0x6B: case 0x8B: case 0xAB: case 0xCB:
+                ++s.pc;
+                return 0U;
+
+            case 0x93:
+                ++s.pc;
+                return 0U;
+
+            case 0x9B: case 0x9C: case 0x9E: case 0x9F: case 0xBB:
+                s.pc += 2U;
+                return 0U;
+
+            // Implied NOPs and KIL.
+            default:
+                return 0U;
+        }
+    }
+
+    // Executes one instruction and returns the cycles it takes, without charging them.
+    template<typename Bus>
+    uint32_t execute(Bus &bus, state &s);
+
+} // namespace detail
+
+// Accuracy policies for `step()` and `interrupt()`; see the top of this file.
+namespace accuracy
+{
+    struct fast
+    {
+    };
+
+    struct exact
+    {
+    };
+} // namespace accuracy
+
+// Puts the CPU in its power-up state and jumps through the reset vector.
+template<typename Bus>
+void reset(Bus &bus, state &s)
+{
+    s.reg_a = 0x00U;
+    s.reg_x = 0x00U;
+    s.reg_y = 0x00U;
+    s.sp    = 0xFDU;
+    s.status.reset();
+    s.status.at(flags::INTERRUPT) = true;
+
+    const uint8_t LSB = bus.read(RESET_VECTOR);
+    const uint8_t MSB = bus.read(RESET_VECTOR + 1U);
+    s.pc = static_cast<uint16_t>((MSB << 8U) | LSB);
+
+    s.cycles = 7U;
+}
+
+namespace detail
+{
+    template<typename Bus>
+    void interrupt(Bus &bus, state &s, const uint16_t vector)
+    {
+        // Two cycles on the opcode that is not executed.
+        if constexpr(EXACT<Bus>)
+        {
+            bus.read(s.pc);
+            bus.read(s.pc);
+        }
+
+        push_word(bus, s, s.pc);
+        push(bus, s, s.status.to_byte() & ~(1U << flags::BREAKPOINT));
+        s.status.at(flags::INTERRUPT) = true;
+
+        const uint8_t LSB = bus.read(vector);
+        const uint8_t MSB = bus.read(vector + 1U);
+        s.pc = static_cast<uint16_t>((MSB << 8U) | LSB);
+    }
+
+    // Runs `body` on `bus` under `Accuracy` and charges `cycles` (or what is left of
+    // them after the exact policy's accesses) to `s`.
+    template<typename Accuracy, typename Bus, typename Body>
+    uint32_t timed(Bus &bus, state &s, const Body &body)
+    {
+        if constexpr(std::is_same_v<Accuracy, accuracy::exact>)
+        {
+            cycle_bus<Bus> exact(bus, s);
+            const uint32_t cycles = body(exact);
+            s.cycles += cycles - std::min(cycles, exact.accesses());
+            return cycles;
+        }
+        else
+        {
+            static_assert(std::is_same_v<Accuracy, accuracy::fast>, "Unknown accuracy policy!");
+            const uint32_t cycles = body(bus);
+            s.cycles += cycles;
+            return cycles;
+        }
+    }
+} // namespace detail
+
+// Services an NMI or IRQ through `vector`. Masking IRQs is up to the caller.
+template<typename Accuracy = accuracy::fast, typename Bus>
+void interrupt(Bus &bus, state &s, const uint16_t vector)
+{
+    detail::timed<Accuracy>(bus, s, [&](auto &b)
+                            {
+                                detail::interrupt(b, s, vector);
+                                return 7U;
+                            });
+}
+
+// Executes one instruction and returns the cycles it took.
+template<typename Accuracy = accuracy::fast, typename Bus>
+uint32_t step(Bus &bus, state &s)
+{
+    return detail::timed<Accuracy>(bus, s, [&](auto &b) { return detail::execute(b, s); });
+}
+
+template<typename Bus>
+uint32_t detail::execute(Bus &bus, state &s)
+{
+    using codes = op::codes;
+
+    const uint8_t opcode = detail::fetch(bus, s);
+    uint32_t      extra  = 0U;
+
+    // Single-byte instructions read the byte after the opcode anyway.
+    if constexpr(detail::EXACT<Bus>)
+    {
+        if(LENGTHS[opcode] == 1U)
+        {
+            bus.read(s.pc);
+        }
+    }
+
+    switch(static_cast<codes>(opcode))
+    {
+        //
+        // Loads, stores and ALU reads.
+        //
+        case codes::ADC_IMMEDIATE:   extra = read<mode::IMMEDIATE>(bus, s, op::adc_op); break;
+        case codes::ADC_ZERO_PAGE:   extra = read<mode::ZERO_PAGE>(bus, s, op::adc_op); break;
+        case codes::ADC_ZERO_PAGE_X: extra = read<mode::ZERO_PAGE_X>(bus, s, op::adc_op); break;
+        case codes::ADC_ABSOLUTE:    extra = read<mode::ABSOLUTE>(bus, s, op::adc_op); break;
+        case codes::ADC_ABSOLUTE_X:  extra = read<mode::ABSOLUTE_X>(bus, s, op::adc_op); break;
+        case codes::ADC_ABSOLUTE_Y:  extra = read<mode::ABSOLUTE_Y>(bus, s, op::adc_op); break;
+        case codes::ADC_INDIRECT_X:  extra = read<mode::INDIRECT_X>(bus, s, op::adc_op); break;
+        case codes::ADC_INDIRECT_Y:  extra = read<mode::INDIRECT_Y>(bus, s, op::adc_op); break;
+
+        case codes::AND_IMMEDIATE:   extra = read<mode::IMMEDIATE>(bus, s, op::and_op); break;
+        case codes::AND_ZERO_PAGE:   extra = read<mode::ZERO_PAGE>(bus, s, op::and_op); break;
+        case codes::AND_ZERO_PAGE_X: extra = read<mode::ZERO_PAGE_X>(bus, s, op::and_op); break;
+        case codes::AND_ABSOLUTE:    extra = read<mode::ABSOLUTE>(bus, s, op::and_op); break;
+        case codes::AND_ABSOLUTE_X:  extra = read<mode::ABSOLUTE_X>(bus, s, op::and_op); break;
+        case codes::AND_ABSOLUTE_Y:  extra = read<mode::ABSOLUTE_Y>(bus, s, op::and_op); break;
+        case codes::AND_INDIRECT_X:  extra = read<mode::INDIRECT_X>(bus, s, op::and_op); break;
+        case codes::AND_INDIRECT_Y:  extra = read<mode::INDIRECT_Y>(bus, s, op::and_op); break;
+
+        case codes::BIT_ZERO_PAGE: extra = read<mode::ZERO_PAGE>(bus, s, op::bit_op); break;
+        case codes::BIT_ABSOLUTE:  extra = read<mode::ABSOLUTE>(bus, s, op::bit_op); break;
+
+        case codes::CMP_IMMEDIATE:   extra = read<mode::IMMEDIATE>(bus, s, op::cmp_op); break;
+        case codes::CMP_ZERO_PAGE:   extra = read<mode::ZERO_PAGE>(bus, s, op::cmp_op); break;
+        case codes::CMP_ZERO_PAGE_X: extra = read<mode::ZERO_PAGE_X>(bus, s, op::cmp_op); break;
+        case codes::CMP_ABSOLUTE:    extra = read<mode::ABSOLUTE>(bus, s, op::cmp_op); break;
+        case codes::CMP_ABSOLUTE_X:  extra = read<mode::ABSOLUTE_X>(bus, s, op::cmp_op); break;
+        case codes::CMP_ABSOLUTE_Y:  extra = read<mode::ABSOLUTE_Y>(bus, s, op::cmp_op); break;
+        case codes::CMP_INDIRECT_X:  extra = read<mode::INDIRECT_X>(bus, s, op::cmp_op); break;
+        case codes::CMP_INDIRECT_Y:  extra = read<mode::INDIRECT_Y>(bus, s, op::cmp_op); break;
+
+        case codes::CPX_IMMEDIATE: extra = read<mode::IMMEDIATE>(bus, s, op::cpx_op); break;
+        case codes::CPX_ZERO_PAGE: extra = read<mode::ZERO_PAGE>(bus, s, op::cpx_op); break;
+        case codes::CPX_ABSOLUTE:  extra = read<mode::ABSOLUTE>(bus, s, op::cpx_op); break;
+
+        case codes::CPY_IMMEDIATE: extra = read<mode::IMMEDIATE>(bus, s, op::cpy_op); break;
+        case codes::CPY_ZERO_PAGE: extra = read<mode::ZERO_PAGE>(bus, s, op::cpy_op); break;
+        case codes::CPY_ABSOLUTE:  extra = read<mode::ABSOLUTE>(bus, s, op::cpy_op); break;
+
+        case codes::EOR_IMMEDIATE:   extra = read<mode::IMMEDIATE>(bus, s, op::eor_op); break;
+        case codes::EOR_ZERO_PAGE:   extra = read<mode::ZERO_PAGE>(bus, s, op::eor_op); break;
+        case codes::EOR_ZERO_PAGE_X: extra = read<mode::ZERO_PAGE_X>(bus, s, op::eor_op); break;
+        case codes::EOR_ABSOLUTE:    extra = read<mode::ABSOLUTE>(bus, s, op::eor_op); break;
+        case codes::EOR_ABSOLUTE_X:  extra = read<mode::ABSOLUTE_X>(bus, s, op::eor_op); break;
+        case codes::EOR_ABSOLUTE_Y:  extra = read<mode::ABSOLUTE_Y>(bus, s, op::eor_op); break;
+        case codes::EOR_INDIRECT_X:  extra = read<mode::INDIRECT_X>(bus, s, op::eor_op); break;
+        case codes::EOR_INDIRECT_Y:  extra = read<mode::INDIRECT_Y>(bus, s, op::eor_op); break;
+
+        case codes::LDA_IMMEDIATE:   extra = read<mode::IMMEDIATE>(bus, s, op::lda_op); break;
+        case codes::LDA_ZERO_PAGE:   extra = read<mode::ZERO_PAGE>(bus, s, op::lda_op); break;
+        case codes::LDA_ZERO_PAGE_X: extra = read<mode::ZERO_PAGE_X>(bus, s, op::lda_op); break;
+        case codes::LDA_ABSOLUTE:    extra = read<mode::ABSOLUTE>(bus, s, op::lda_op); break;
+        case codes::LDA_ABSOLUTE_X:  extra = read<mode::ABSOLUTE_X>(bus, s, op::lda_op); break;
+        case codes::LDA_ABSOLUTE_Y:  extra = read<mode::ABSOLUTE_Y>(bus, s, op::lda_op); break;
+        case codes::LDA_INDIRECT_X:  extra = read<mode::INDIRECT_X>(bus, s, op::lda_op); break;
+        case codes::LDA_INDIRECT_Y:  extra = read<mode::INDIRECT_Y>(bus, s, op::lda_op); break;
+
+        case codes::LDX_IMMEDIATE:   extra = read<mode::IMMEDIATE>(bus, s, op::ldx_op); break;
+        case codes::LDX_ZERO_PAGE:   extra = read<mode::ZERO_PAGE>(bus, s, op::ldx_op); break;
+        case codes::LDX_ZERO_PAGE_Y: extra = read<mode::ZERO_PAGE_Y>(bus, s, op::ldx_op); break;
+        case codes::LDX_ABSOLUTE:    extra = read<mode::ABSOLUTE>(bus, s, op::ldx_op); break;
+        case codes::LDX_ABSOLUTE_Y:  extra = read<mode::ABSOLUTE_Y>(bus, s, op::ldx_op); break;
+
+        case codes::LDY_IMMEDIATE:   extra = read<mode::IMMEDIATE>(bus, s, op::ldy_op); break;
+        case codes::LDY_ZERO_PAGE:   extra = read<mode::ZERO_PAGE>(bus, s, op::ldy_op); break;
+        case codes::LDY_ZERO_PAGE_X: extra = read<mode::ZERO_PAGE_X>(bus, s, op::ldy_op); break;
+        case codes::LDY_ABSOLUTE:    extra = read<mode::ABSOLUTE>(bus, s, op::ldy_op); break;
+        case codes::LDY_ABSOLUTE_X:  extra = read<mode::ABSOLUTE_X>(bus, s, op::ldy_op); break;
+
+        case codes::ORA_IMMEDIATE:   extra = read<mode::IMMEDIATE>(bus, s, op::ora_op); break;
+        case codes::ORA_ZERO_PAGE:   extra = read<mode::ZERO_PAGE>(bus, s, op::ora_op); break;
+        case codes::ORA_ZERO_PAGE_X: extra = read<mode::ZERO_PAGE_X>(bus, s, op::ora_op); break;
+        case codes::ORA_ABSOLUTE:    extra = read<mode::ABSOLUTE>(bus, s, op::ora_op); break;
+        case codes::ORA_ABSOLUTE_X:  extra = read<mode::ABSOLUTE_X>(bus, s, op::ora_op); break;
+        case codes::ORA_ABSOLUTE_Y:  extra = read<mode::ABSOLUTE_Y>(bus, s, op::ora_op); break;
+        case codes::ORA_INDIRECT_X:  extra = read<mode::INDIRECT_X>(bus, s, op::ora_op); break;
+        case codes::ORA_INDIRECT_Y:  extra = read<mode::INDIRECT_Y>(bus, s, op::ora_op); break;
+
+        case codes::SBC_IMMEDIATE:   extra = read<mode::IMMEDIATE>(bus, s, op::sbc_op); break;
+        case codes::SBC_ZERO_PAGE:   extra = read<mode::ZERO_PAGE>(bus, s, op::sbc_op); break;
+        case codes::SBC_ZERO_PAGE_X: extra = read<mode::ZERO_PAGE_X>(bus, s, op::sbc_op); break;
+        case codes::SBC_ABSOLUTE:    extra = read<mode::ABSOLUTE>(bus, s, op::sbc_op); break;
+        case codes::SBC_ABSOLUTE_X:  extra = read<mode::ABSOLUTE_X>(bus, s, op::sbc_op); break;
+        case codes::SBC_ABSOLUTE_Y:  extra = read<mode::ABSOLUTE_Y>(bus, s, op::sbc_op); break;
+        case codes::SBC_INDIRECT_X:  extra = read<mode::INDIRECT_X>(bus, s, op::sbc_op); break;
+        case codes::SBC_INDIRECT_Y:  extra = read<mode::INDIRECT_Y>(bus, s, op::sbc_op); break;
+
+        case codes::STA_ZERO_PAGE:   store<mode::ZERO_PAGE>(bus, s, op::sta_op); break;
+        case codes::STA_ZERO_PAGE_X: store<mode::ZERO_PAGE_X>(bus, s, op::sta_op); break;
+        case codes::STA_ABSOLUTE:    store<mode::ABSOLUTE>(bus, s, op::sta_op); break;
+        case codes::STA_ABSOLUTE_X:  store<mode::ABSOLUTE_X>(bus, s, op::sta_op); break;
+        case codes::STA_ABSOLUTE_Y:  store<mode::ABSOLUTE_Y>(bus, s, op::sta_op); break;
+        case codes::STA_INDIRECT_X:  store<mode::INDIRECT_X>(bus, s, op::sta_op); break;
+        case codes::STA_INDIRECT_Y:  store<mode::INDIRECT_Y>(bus, s, op::sta_op); break;
+
+        case codes::STX_ZERO_PAGE:   store<mode::ZERO_PAGE>(bus, s, op::stx_op); break;
+        case codes::STX_ZERO_PAGE_Y: store<mode::ZERO_PAGE_Y>(bus, s, op::stx_op); break;
+        case codes::STX_ABSOLUTE:    store<mode::ABSOLUTE>(bus, s, op::stx_op); break;
+
+        case codes::STY_ZERO_PAGE:   store<mode::ZERO_PAGE>(bus, s, op::sty_op); break;
+        case codes::STY_ZERO_PAGE_X: store<mode::ZERO_PAGE_X>(bus, s, op::sty_op); break;
+        case codes::STY_ABSOLUTE:    store<mode::ABSOLUTE>(bus, s, op::sty_op); break;
+
+        //
+        // Read-modify-write.
+        //
+        case codes::ASL_ACCUMULATOR: accumulator(s, op::asl_op); break;
+        case codes::ASL_ZERO_PAGE:   modify<mode::ZERO_PAGE>(bus, s, op::asl_op); break;
+        case codes::ASL_ZERO_PAGE_X: modify<mode::ZERO_PAGE_X>(bus, s, op::asl_op); break;
+        case codes::ASL_ABSOLUTE:    modify<mode::ABSOLUTE>(bus, s, op::asl_op); break;
+        case codes::ASL_ABSOLUTE_X:  modify<mode::ABSOLUTE_X>(bus, s, op::asl_op); break;
+
+        case codes::LSR_ACCUMULATOR: accumulator(s, op::lsr_op); break;
+        case codes::LSR_ZERO_PAGE:   modify<mode::ZERO_PAGE>(bus, s, op::lsr_op); break;
+        case codes::LSR_ZERO_PAGE_X: modify<mode::ZERO_PAGE_X>(bus, s, op::lsr_op); break;
+        case codes::LSR_ABSOLUTE:    modify<mode::ABSOLUTE>(bus, s, op::lsr_op); break;
+        case codes::LSR_ABSOLUTE_X:  modify<mode::ABSOLUTE_X>(bus, s, op::lsr_op); break;
+
+        case codes::ROL_ACCUMULATOR: accumulator(s, op::rol_op); break;
+        case codes::ROL_ZERO_PAGE:   modify<mode::ZERO_PAGE>(bus, s, op::rol_op); break;
+        case codes::ROL_ZERO_PAGE_X: modify<mode::ZERO_PAGE_X>(bus, s, op::rol_op); break;
+        case codes::ROL_ABSOLUTE:    modify<mode::ABSOLUTE>(bus, s, op::rol_op); break;
+        case codes::ROL_ABSOLUTE_X:  modify<mode::ABSOLUTE_X>(bus, s, op::rol_op); break;
+
+        case codes::ROR_ACCUMULATOR: accumulator(s, op::ror_op); break;
+        case codes::ROR_ZERO_PAGE:   modify<mode::ZERO_PAGE>(bus, s, op::ror_op); break;
+        case codes::ROR_ZERO_PAGE_X: modify<mode::ZERO_PAGE_X>(bus, s, op::ror_op); break;
+        case codes::ROR_ABSOLUTE:    modify<mode::ABSOLUTE>(bus, s, op::ror_op); break;
+        case codes::ROR_ABSOLUTE_X:  modify<mode::ABSOLUTE_X>(bus, s, op::ror_op); break;
+
+        case codes::INC_ZERO_PAGE:   modify<mode::ZERO_PAGE>(bus, s, op::inc_op); break;
+        case codes::INC_ZERO_PAGE_X: modify<mode::ZERO_PAGE_X>(bus, s, op::inc_op); break;
+        case codes::INC_ABSOLUTE:    modify<mode::ABSOLUTE>(bus, s, op::inc_op); break;
+        case codes::INC_ABSOLUTE_X:  modify<mode::ABSOLUTE_X>(bus, s, op::inc_op); break;
+
+        case codes::DEC_ZERO_PAGE:   modify<mode::ZERO_PAGE>(bus, s, op::dec_op); break;
+        case codes::DEC_ZERO_PAGE_X: modify<mode::ZERO_PAGE_X>(bus, s, op::dec_op); break;
+        case codes::DEC_ABSOLUTE:    modify<mode::ABSOLUTE>(bus, s, op::dec_op); break;
+        case codes::DEC_ABSOLUTE_X:  modify<mode::ABSOLUTE_X>(bus, s, op::dec_op); break;
+
+        //
+        // Branches.
+        //
+        case codes::BPL: extra = branch(bus, s, !s.status.at(flags::NEGATIVE)); break;
+        case codes::BMI: extra = branch(bus, s, s.status.at(flags::NEGATIVE)); break;
+        case codes::BVC: extra = branch(bus, s, !s.status.at(flags::OVERFLOW)); break;
+        case codes::BVS: extra = branch(bus, s, s.status.at(flags::OVERFLOW)); break;
+        case codes::BCC: extra = branch(bus, s, !s.status.at(flags::CARRY)); break;
+        case codes::BCS: extra = branch(bus, s, s.status.at(flags::CARRY)); break;
+        case codes::BNE: extra = branch(bus, s, !s.status.at(flags::ZERO)); break;
+        case codes::BEQ: extra = branch(bus, s, s.status.at(flags::ZERO)); break;
+
+        //
+        // Jumps and subroutines.
+        //
+        case codes::JMP_ABSOLUTE:
+            s.pc = detail::fetch_word(bus, s);
+            break;
+
+        case codes::JMP_INDIRECT:
+        {
+            // The pointer's high byte is fetched without carrying into the next page.
+            const uint16_t pointer = detail::fetch_word(bus, s);
+            const uint8_t  LSB     = bus.read(pointer);
+            const uint8_t  MSB     = bus.read((pointer & 0xFF00U) | ((pointer + 1U) & 0x00FFU));
+            s.pc = static_cast<uint16_t>((MSB << 8U) | LSB);
+            break;
+        }
+
+        case codes::JSR_ABSOLUTE:
+        {
+            // The return address is pushed between fetching the target's two bytes.
+            const uint8_t LSB = detail::fetch(bus, s);
+            detail::stack_dummy_read(bus, s);
+            detail::push_word(bus, s, s.pc);
+            const uint8_t MSB = detail::fetch(bus, s);
+            s.pc = static_cast<uint16_t>((MSB << 8U) | LSB);
+            break;
+        }
+
+        case codes::RTS:
+            detail::stack_dummy_read(bus, s);
+            s.pc = detail::pull_word(bus, s);
+            if constexpr(detail::EXACT<Bus>)
+            {
+                bus.read(s.pc);
+            }
+            ++s.pc;
+            break;
+
+        case codes::RTI:
+            detail::stack_dummy_read(bus, s);
+            s.status.from_byte(detail::pull(bus, s));
+            s.status.at(flags::BREAKPOINT) = false;
+            s.pc = detail::pull_word(bus, s);
+            break;
+
+        case codes::BRK:
+            detail::push_word(bus, s, s.pc + 1U);
+            detail::push(bus, s, s.status.to_byte() | (1U << flags::BREAKPOINT));
+            s.status.at(flags::INTERRUPT) = true;
+            s.pc = static_cast<uint16_t>(bus.read(IRQ_VECTOR) | (bus.read(IRQ_VECTOR + 1U) << 8U));
+            break;
+
+        //
+        // Stack.
+        //
+        case codes::PHA: detail::push(bus, s, s.reg_a); break;
+        case codes::PHP: detail::push(bus, s, s.status.to_byte() | (1U << flags::BREAKPOINT)); break;
+
+        case codes::PLA:
+            detail::stack_dummy_read(bus, s);
+            s.reg_a = detail::pull(bus, s);
+            op::set_zero_negative(s, s.reg_a);
+            break;
+
+        case codes::PLP:
+            detail::stack_dummy_read(bus, s);
+            s.status.from_byte(detail::pull(bus, s));
+            s.status.at(flags::BREAKPOINT) = false;
+            break;
+
+        case codes::TXS: s.sp = s.reg_x; break;
+
+        case codes::TSX:
+            s.reg_x = static_cast<uint8_t>(s.sp);
+            op::set_zero_negative(s, s.reg_x);
+            break;
+
+        //
+        // Registers.
+        //
+        case codes::REG_TAX: s.reg_x = s.reg_a; op::set_zero_negative(s, s.reg_x); break;
+        case codes::REG_TXA: s.reg_a = s.reg_x; op::set_zero_negative(s, s.reg_a); break;
+        case codes::REG_TAY: s.reg_y = s.reg_a; op::set_zero_negative(s, s.reg_y); break;
+        case codes::REG_TYA: s.reg_a = s.reg_y; op::set_zero_negative(s, s.reg_a); break;
+        case codes::REG_INX: ++s.reg_x; op::set_zero_negative(s, s.reg_x); break;
+        case codes::REG_DEX: --s.reg_x; op::set_zero_negative(s, s.reg_x); break;
+        case codes::REG_INY: ++s.reg_y; op::set_zero_negative(s, s.reg_y); break;
+        case codes::REG_DEY: --s.reg_y; op::set_zero_negative(s, s.reg_y); break;
+
+        //
+        // Flags.
+        //
+        case codes::CLC: s.status.at(flags::CARRY)     = false; break;
+        case codes::SEC: s.status.at(flags::CARRY)     = true; break;
+        case codes::CLI: s.status.at(flags::INTERRUPT) = false; break;
+        case codes::SEI: s.status.at(flags::INTERRUPT) = true; break;
+        case codes::CLV: s.status.at(flags::OVERFLOW)  = false; break;
+        case codes::CLD: s.status.at(flags::DECIMAL)   = false; break;
+        case codes::SED: s.status.at(flags::DECIMAL)   = true; break;
+
+        case codes::NOP:
+            break;
+
+        default:
+            extra = detail::execute_unofficial(bus, s, opcode);
+            break;
+    }
+
+    return CYCLES[opcode] + extra;
+}
+
+} // namespace cpu
@@ -1,8 +1,209 @@
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <string>
 
+#include "cartridge.hh"
+#include "console.hh"
 #include "cpu.hh"
+#ifdef NES_COROUTINES
+#include "cooperative.hh"
+#endif
+#include "metrics.hh"
+#include "movie.hh"
+#include "predecode.hh"
+#include "replay.hh"
+#include "spawner.hh"
+
+namespace
+{
+    constexpr double NTSC_FRAME_RATE = 60.0988;
+
+    void print_usage()
+    {
+        std::cerr << "usage: nes-emu <rom.nes> [--movie <file.nesm>] [--frames <count>] [--threaded]\n"
+                  << "               [--cache-dir <dir>] [--exact] [--cooperative] [--metrics] [--profile]\n"
+                  << "       nes-emu <rom.nes> --workers <count> [--frames <count>]\n";
+    }
+
+    void print_throughput(const uint64_t frames, const double seconds)
+    {
+        const double fps = seconds > 0.0 ? frames / seconds : 0.0;
+        std::cout << frames << " frames in " << seconds << "s: " << fps << " fps ("
+                  << fps / NTSC_FRAME_RATE << "x realtime)" << std::endl;
+    }
+} // namespace
 
-int main()
+int main(int argc, char **argv)
 {
+    if(argc < 2)
+    {
+        print_usage();
+        return 2;
+    }
+
+    std::string rom_path = argv[1];
+    std::string movie_path;
+    std::string cache_dir;
+    uint64_t    frames      = 600U;
+    uint64_t    workers     = 0U;
+    bool        cooperative = false;
+    bool        exact       = false;
+    bool        metrics     = false;
+    bool        profile     = false;
+    auto        mode        = ppu::pipeline::mode::INLINE;
+
+    for(int i = 2; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "--movie") == 0 && i + 1 < argc)
+        {
+            movie_path = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frames = std::stoull(argv[++i]);
+        }
+        else if(std::strcmp(argv[i], "--cache-dir") == 0 && i + 1 < argc)
+        {
+            cache_dir = argv[++i];
+        }
+        else if(std::strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+        {
+            workers = std::stoull(argv[++i]);
+        }
+        else if(std::strcmp(argv[i], "--threaded") == 0)
+        {
+            mode = ppu::pipeline::mode::THREADED;
+        }
+        else if(std::strcmp(argv[i], "--exact") == 0)
+        {
+            exact = true;
+        }
+        else if(std::strcmp(argv[i], "--metrics") == 0)
+        {
+            metrics = true;
+        }
+        else if(std::strcmp(argv[i], "--profile") == 0)
+        {
+            profile = true;
+        }
+#ifdef NES_COROUTINES
+        else if(std::strcmp(argv[i], "--cooperative") == 0)
+        {
+            cooperative = true;
+        }
+#endif
+        else
+        {
+            print_usage();
+            return 2;
+        }
+    }
+
+    // Battery saves go next to the ROM, as <rom>.sav.
+    const nes::cartridge cart = nes::load_ines(rom_path);
+    nes::console         console(cart, mode, std::filesystem::path(rom_path).replace_extension(".sav").string());
+    if(exact)
+    {
+        console.set_accuracy(nes::accuracy::EXACT);
+    }
+    console.set_profiling(profile);
+
+    // Live counters for nes-emu-top.
+    std::unique_ptr<nes::metrics_publisher> publisher;
+    if(metrics)
+    {
+        publisher = std::make_unique<nes::metrics_publisher>(nes::metrics_name(getpid()));
+    }
+
+    // The analysis is only used for skipping idle loops, so it is optional.
+    std::unique_ptr<nes::predecode> analysis;
+    if(!cache_dir.empty())
+    {
+        analysis = std::make_unique<nes::predecode>(nes::predecode::load_or_build(cart, cache_dir));
+        console.set_predecode(analysis.get());
+    }
+
+    if(!movie_path.empty())
+    {
+        const nes::movie         m      = nes::movie::load(movie_path);
+        const nes::replay_report report = nes::replay(console, m);
+
+        std::cout << report.checkpoints_passed << "/" << m.checkpoints().size() << " checkpoints passed" << std::endl;
+        if(report.diverged)
+        {
+            std::cout << "Diverged at frame " << report.failure.frame << ": expected " << std::hex
+                      << report.failure.hash << ", got " << report.actual_hash << std::dec << std::endl;
+        }
+
+        // Every checkpoint must have been reached and matched.
+        print_throughput(report.frames, report.seconds);
+        return report.checkpoints_passed == m.checkpoints().size() ? 0 : 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    if(cooperative)
+    {
+#ifdef NES_COROUTINES
+        nes::cooperative_runner runner(console);
+        for(uint64_t i = 0U; i < frames; ++i)
+        {
+            runner.run_frame();
+            if(publisher)
+            {
+                publisher->publish(console);
+            }
+        }
+#endif
+    }
+    else
+    {
+        for(uint64_t i = 0U; i < frames; ++i)
+        {
+            console.run_frame();
+            if(publisher)
+            {
+                publisher->publish(console);
+            }
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    print_throughput(frames, elapsed.count());
+
+    if(workers > 0U)
+    {
+        // Each worker carries on from the warmed console for another `frames` frames.
+        nes::spawner spawner(console);
+        double       spawn_seconds = 0.0;
+        for(uint64_t i = 0U; i < workers; ++i)
+        {
+            spawner.spawn([frames](nes::console &c, std::size_t)
+                          {
+                              for(uint64_t f = 0U; f < frames; ++f)
+                              {
+                                  c.run_frame();
+                              }
+                              return c.frame_number();
+                          });
+            spawn_seconds += spawner.last_spawn_seconds();
+            spawner.sample_memory();
+        }
+
+        int failed = 0;
+        for(const auto &r : spawner.wait_all())
+        {
+            std::cout << "worker " << r.pid << ": " << (r.ok ? "ok" : "failed") << ", "
+                      << r.final_memory.rss_kib << " KiB resident, " << r.final_memory.private_kib
+                      << " KiB private" << std::endl;
+            failed += r.ok ? 0 : 1;
+        }
+        std::cout << "Average spawn time: " << spawn_seconds / workers * 1e6 << "us" << std::endl;
+        return failed > 0 ? 1 : 0;
+    }
     return 0;
 }
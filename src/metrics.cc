@@ -0,0 +1,226 @@
+#include "metrics.hh"
+
+#include "console.hh"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace nes
+{
+
+namespace
+{
+    constexpr std::size_t SAMPLE_WORDS = sizeof(metrics_sample) / sizeof(uint64_t);
+
+    // Reads attempted before a segment is taken to be abandoned mid-write. A live
+    // publisher holds the sequence odd for one copy of the sample, far fewer.
+    constexpr std::size_t READ_ATTEMPTS = 100000U;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared counters must be lock-free!");
+
+    uint64_t steady_ns()
+    {
+        return static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+    }
+} // namespace
+
+// What is in the segment.
+struct metrics_layout
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t pid;
+
+    std::atomic<uint64_t>                           sequence;
+    std::array<std::atomic<uint64_t>, SAMPLE_WORDS> words;
+};
+
+std::size_t frame_time_bucket(const double seconds)
+{
+    std::size_t bucket = 0U;
+    for(double limit = 0.001; bucket + 1U < FRAME_TIME_BUCKETS && seconds >= limit; limit *= 2.0)
+    {
+        ++bucket;
+    }
+    return bucket;
+}
+
+std::string metrics_name(const pid_t pid)
+{
+    return "/nes-emu-" + std::to_string(pid);
+}
+
+std::vector<std::string> list_metrics()
+{
+    // Linux keeps POSIX shared memory in /dev/shm.
+    std::vector<std::string> names;
+    if(DIR *dir = opendir("/dev/shm"))
+    {
+        while(const dirent *entry = readdir(dir))
+        {
+            if(std::strncmp(entry->d_name, "nes-emu-", 8U) == 0)
+            {
+                names.push_back(std::string("/") + entry->d_name);
+            }
+        }
+        closedir(dir);
+    }
+    return names;
+}
+
+metrics_publisher::metrics_publisher(const std::string &name)
+    : name_(name)
+{
+    shm_unlink(name_.c_str());
+    const int fd = shm_open(name_.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    if(fd < 0)
+    {
+        throw std::runtime_error("Failed to create metrics segment!");
+    }
+
+    void *mapping = MAP_FAILED;
+    if(ftruncate(fd, sizeof(metrics_layout)) == 0)
+    {
+        mapping = mmap(nullptr, sizeof(metrics_layout), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        shm_unlink(name_.c_str());
+        throw std::runtime_error("Failed to map metrics segment!");
+    }
+
+    sample_.started_ns = steady_ns();
+
+    // The pages come zeroed, which is a valid state for the atomics; the magic goes
+    // last so readers never see a half-written header.
+    shared_          = static_cast<metrics_layout *>(mapping);
+    shared_->version = METRICS_VERSION;
+    shared_->pid     = static_cast<uint64_t>(getpid());
+    std::atomic_thread_fence(std::memory_order_release);
+    shared_->magic = METRICS_MAGIC;
+}
+
+metrics_publisher::~metrics_publisher()
+{
+    munmap(shared_, sizeof(metrics_layout));
+    shm_unlink(name_.c_str());
+}
+
+void metrics_publisher::publish(const console &c)
+{
+    const auto now = std::chrono::steady_clock::now();
+    if(started_)
+    {
+        ++sample_.frame_times[frame_time_bucket(std::chrono::duration<double>(now - last_).count())];
+    }
+    last_    = now;
+    started_ = true;
+
+    sample_.updated_ns          = steady_ns();
+    sample_.frames              = c.frame_number();
+    sample_.cycles              = c.cpu_state().cycles;
+    sample_.instructions        = c.instructions();
+    sample_.idle_cycles_skipped = c.idle_cycles_skipped();
+    sample_.exact               = c.get_accuracy() == accuracy::EXACT ? 1U : 0U;
+    sample_.snapshots_saved     = c.snapshots_saved();
+    sample_.snapshots_restored  = c.snapshots_restored();
+    sample_.snapshot_bytes      = (c.snapshots_saved() + c.snapshots_restored()) * sizeof(console::snapshot);
+
+    const std::array<uint64_t, 256U> *opcodes = c.opcode_counts();
+    sample_.profiling                          = opcodes != nullptr ? 1U : 0U;
+    if(opcodes != nullptr)
+    {
+        sample_.opcodes = *opcodes;
+    }
+
+    std::array<uint64_t, SAMPLE_WORDS> words;
+    std::memcpy(words.data(), &sample_, sizeof(sample_));
+
+    // Seqlock write: odd while the words are changing.
+    const uint64_t sequence = shared_->sequence.load(std::memory_order_relaxed);
+    shared_->sequence.store(sequence + 1U, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    for(std::size_t i = 0U; i < SAMPLE_WORDS; ++i)
+    {
+        shared_->words[i].store(words[i], std::memory_order_relaxed);
+    }
+    shared_->sequence.store(sequence + 2U, std::memory_order_release);
+}
+
+metrics_sample read_metrics(const std::string &name, pid_t *pid)
+{
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if(fd < 0)
+    {
+        throw std::runtime_error("Failed to open metrics segment!");
+    }
+
+    // A publisher that has created the segment but not sized it yet leaves it empty;
+    // mapping past its end would fault on the first read.
+    struct stat info;
+    if(fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < sizeof(metrics_layout))
+    {
+        close(fd);
+        throw std::runtime_error("Metrics segment is not set up yet!");
+    }
+
+    void *mapping = mmap(nullptr, sizeof(metrics_layout), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map metrics segment!");
+    }
+
+    const auto *shared = static_cast<const metrics_layout *>(mapping);
+    if(shared->magic != METRICS_MAGIC || shared->version != METRICS_VERSION)
+    {
+        munmap(mapping, sizeof(metrics_layout));
+        throw std::runtime_error("Metrics segment has another layout version!");
+    }
+    if(pid != nullptr)
+    {
+        *pid = static_cast<pid_t>(shared->pid);
+    }
+
+    // Seqlock read: retry until the sequence is even and unchanged around the copy. A
+    // publisher that died between its two sequence stores leaves it odd for good, so
+    // the retries are bounded.
+    std::array<uint64_t, SAMPLE_WORDS> words;
+    bool                               consistent = false;
+    for(std::size_t attempt = 0U; attempt < READ_ATTEMPTS && !consistent; ++attempt)
+    {
+        const uint64_t before = shared->sequence.load(std::memory_order_acquire);
+        if((before & 1U) != 0U)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        for(std::size_t i = 0U; i < SAMPLE_WORDS; ++i)
+        {
+            words[i] = shared->words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        consistent = shared->sequence.load(std::memory_order_relaxed) == before;
+    }
+    munmap(mapping, sizeof(metrics_layout));
+    if(!consistent)
+    {
+        throw std::runtime_error("Metrics segment is stuck mid-update!");
+    }
+
+    metrics_sample sample;
+    std::memcpy(&sample, words.data(), sizeof(sample));
+    return sample;
+}
+
+} // namespace nes
@@ -0,0 +1,104 @@
+#include <sys/types.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma once
+
+//
+// Live counters published through POSIX shared memory.
+//
+// Each publishing process owns one segment, `/nes-emu-<pid>`, holding a fixed layout:
+// a header (magic, version, pid) followed by a seqlock sequence number and the words
+// of a `metrics_sample`. The writer bumps the sequence to odd, stores every word with
+// relaxed atomics and bumps it back to even; readers copy the words and retry if the
+// sequence was odd or moved meanwhile. The writer never waits for readers, and readers
+// give up rather than wait forever on a writer that died mid-update, so tools such as
+// nes-emu-top can watch a running emulator without slowing it down.
+//
+// Add fields to the end of `metrics_sample` and bump `METRICS_VERSION`.
+//
+
+namespace nes
+{
+
+class console;
+struct metrics_layout;
+
+constexpr uint32_t    METRICS_MAGIC      = 0x5453454EU;  // "NEST" little-endian.
+constexpr uint32_t    METRICS_VERSION    = 2U;
+constexpr std::size_t FRAME_TIME_BUCKETS = 8U;
+
+// One consistent set of counters. Only whole 64-bit words, so it can be copied word by
+// word.
+struct metrics_sample
+{
+    uint64_t updated_ns;           // Steady clock at publication.
+    uint64_t frames;
+    uint64_t cycles;               // Emulated CPU cycles.
+    uint64_t instructions;
+    uint64_t idle_cycles_skipped;  // Cycles not interpreted thanks to predecode.
+    uint64_t exact;                // 1 if running at `accuracy::EXACT`.
+    uint64_t snapshots_saved;
+    uint64_t snapshots_restored;
+    uint64_t snapshot_bytes;       // Saved and restored.
+
+    // Wall time per frame: bucket 0 is under 1 ms, bucket i under 2^i ms, the last
+    // everything longer.
+    std::array<uint64_t, FRAME_TIME_BUCKETS> frame_times;
+
+    uint64_t                    profiling;  // 1 if `opcodes` is being filled in.
+    std::array<uint64_t, 256U> opcodes;
+
+    uint64_t started_ns;  // Steady clock when the publisher was created.
+};
+
+static_assert(sizeof(metrics_sample) % sizeof(uint64_t) == 0U, "Samples must be whole words!");
+
+// Bucket in `metrics_sample::frame_times` for a frame that took `seconds`.
+std::size_t frame_time_bucket(double seconds);
+
+// Segment name for process `pid`.
+std::string metrics_name(pid_t pid);
+
+// Names of the segments currently present, whether or not their process is alive.
+std::vector<std::string> list_metrics();
+
+class metrics_publisher
+{
+public:
+    // Creates the segment `name`, replacing any left behind by a dead process. Throws
+    // std::runtime_error on failure.
+    explicit metrics_publisher(const std::string &name);
+
+    // Unmaps and removes the segment.
+    ~metrics_publisher();
+
+    metrics_publisher(const metrics_publisher &)            = delete;
+    metrics_publisher &operator=(const metrics_publisher &) = delete;
+
+    // Publishes `c`'s counters. Call once per frame: the time since the previous call
+    // goes into the frame-time histogram.
+    void publish(const console &c);
+
+    const std::string &name() const { return name_; }
+
+private:
+    std::string                           name_;
+    metrics_layout                       *shared_ = nullptr;
+    metrics_sample                        sample_{};
+    std::chrono::steady_clock::time_point last_;
+    bool                                  started_ = false;
+};
+
+// Reads a consistent sample from segment `name`, along with the publishing process.
+// Throws std::runtime_error if it is missing, not sized yet, has another layout
+// version, or was left mid-update by a publisher that died.
+metrics_sample read_metrics(const std::string &name, pid_t *pid = nullptr);
+
+} // namespace nes
@@ -0,0 +1,226 @@
+#include "movie.hh"
+#include "utils.hh"
+
+#include <fstream>
+#include <stdexcept>
+
+namespace nes
+{
+
+namespace
+{
+    constexpr std::array<uint8_t, 4U> MAGIC = {'N', 'E', 'S', 'M'};
+
+    template<typename T>
+    void put_le(std::vector<uint8_t> &out, const T value)
+    {
+        for(std::size_t i = 0U; i < sizeof(T); ++i)
+        {
+            out.push_back(static_cast<uint8_t>(value >> (8U * i)));
+        }
+    }
+
+    void put_varint(std::vector<uint8_t> &out, uint64_t value)
+    {
+        while(value >= 0x80U)
+        {
+            out.push_back(static_cast<uint8_t>(value | 0x80U));
+            value >>= 7U;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    // Bounds-checked reader over a serialized movie.
+    class reader
+    {
+    public:
+        explicit reader(const std::vector<uint8_t> &bytes) : bytes_(bytes) {}
+
+        uint8_t byte()
+        {
+            if(offset_ >= bytes_.size())
+            {
+                throw std::runtime_error("Movie is truncated!");
+            }
+            return bytes_[offset_++];
+        }
+
+        template<typename T>
+        T le()
+        {
+            T value = 0U;
+            for(std::size_t i = 0U; i < sizeof(T); ++i)
+            {
+                value |= static_cast<T>(byte()) << (8U * i);
+            }
+            return value;
+        }
+
+        uint64_t varint()
+        {
+            uint64_t value = 0U;
+            for(uint32_t shift = 0U; shift < 64U; shift += 7U)
+            {
+                const uint8_t b = byte();
+                value |= static_cast<uint64_t>(b & 0x7FU) << shift;
+                if((b & 0x80U) == 0U)
+                {
+                    return value;
+                }
+            }
+            throw std::runtime_error("Malformed varint in movie!");
+        }
+
+        std::size_t remaining() const { return bytes_.size() - offset_; }
+
+    private:
+        const std::vector<uint8_t> &bytes_;
+        std::size_t                 offset_ = 0U;
+    };
+} // namespace
+
+void movie::append(const input &held)
+{
+    if(!runs_.empty() && runs_.back().held == held && runs_.back().length != UINT32_MAX)
+    {
+        ++runs_.back().length;
+    }
+    else
+    {
+        runs_.push_back({held, 1U});
+    }
+
+    ++frames_;
+}
+
+bool movie::accepts(const checkpoint &c) const
+{
+    return c.frame < frames_ && (checkpoints_.empty() || c.frame >= checkpoints_.back().frame);
+}
+
+void movie::add_checkpoint(const checkpoint &c)
+{
+    if(!accepts(c))
+    {
+        throw std::invalid_argument("Checkpoints must be added in frame order, within the movie!");
+    }
+
+    checkpoints_.push_back(c);
+}
+
+std::vector<uint8_t> movie::serialize() const
+{
+    std::vector<uint8_t> out(MAGIC.begin(), MAGIC.end());
+    out.push_back(VERSION);
+    out.push_back(static_cast<uint8_t>(PORTS));
+    put_le(out, rom_hash_);
+
+    put_le(out, static_cast<uint32_t>(runs_.size()));
+    for(const run &r : runs_)
+    {
+        put_varint(out, r.length);
+        out.insert(out.end(), r.held.begin(), r.held.end());
+    }
+
+    put_le(out, static_cast<uint32_t>(checkpoints_.size()));
+    for(const checkpoint &c : checkpoints_)
+    {
+        put_varint(out, c.frame);
+        out.push_back(static_cast<uint8_t>(c.type));
+        put_le(out, c.hash);
+    }
+
+    return out;
+}
+
+movie movie::deserialize(const std::vector<uint8_t> &bytes)
+{
+    reader in(bytes);
+
+    for(const uint8_t expected : MAGIC)
+    {
+        if(in.byte() != expected)
+        {
+            throw std::runtime_error("Not a movie file!");
+        }
+    }
+
+    if(in.byte() != VERSION)
+    {
+        throw std::runtime_error("Unsupported movie version!");
+    }
+
+    if(in.byte() != PORTS)
+    {
+        throw std::runtime_error("Unsupported number of controller ports!");
+    }
+
+    movie m(in.le<uint64_t>());
+
+    // Each run takes at least a length byte and the ports, so a count the rest of the
+    // file cannot hold is corrupt; checking it first keeps the reserve bounded.
+    const uint32_t run_count = in.le<uint32_t>();
+    if(run_count > in.remaining() / (1U + PORTS))
+    {
+        throw std::runtime_error("Movie is truncated!");
+    }
+    m.runs_.reserve(run_count);
+    for(uint32_t i = 0U; i < run_count; ++i)
+    {
+        run            r;
+        const uint64_t length = in.varint();
+        if(length > UINT32_MAX)
+        {
+            throw std::runtime_error("Movie run is too long!");
+        }
+        r.length = static_cast<uint32_t>(length);
+        for(uint8_t &port : r.held)
+        {
+            port = in.byte();
+        }
+
+        m.runs_.push_back(r);
+        m.frames_ += r.length;
+    }
+
+    const uint32_t checkpoint_count = in.le<uint32_t>();
+    for(uint32_t i = 0U; i < checkpoint_count; ++i)
+    {
+        checkpoint c;
+        c.frame = in.varint();
+
+        const uint8_t type = in.byte();
+        if(type > static_cast<uint8_t>(checkpoint::kind::STATE))
+        {
+            throw std::runtime_error("Unknown movie checkpoint kind!");
+        }
+        c.type = static_cast<checkpoint::kind>(type);
+        c.hash = in.le<uint64_t>();
+        if(!m.accepts(c))
+        {
+            throw std::runtime_error("Movie checkpoint is out of order or past the last frame!");
+        }
+        m.checkpoints_.push_back(c);
+    }
+
+    return m;
+}
+
+void movie::save(const std::string &file_path) const
+{
+    std::ofstream stream(file_path, std::ios::binary | std::ios::trunc);
+    if(!stream.is_open())
+    {
+        throw std::runtime_error("Failed to open movie file for writing!");
+    }
+
+    const std::vector<uint8_t> bytes = serialize();
+    stream.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+movie movie::load(const std::string &file_path)
+{
+    return deserialize(utils::read_file(file_path));
+}
+
+} // namespace nes
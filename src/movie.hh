@@ -0,0 +1,82 @@
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma once
+
+//
+// Input movies.
+//
+// A movie is the controller state for every frame, stored as runs of identical input
+// (games see the same buttons held for dozens of frames at a time), plus checkpoints
+// that pin the expected frame or state hash at given frames.
+//
+// File layout, little-endian:
+//     "NESM", version (u8), ports (u8), ROM hash (u64)
+//     run count (u32), then per run: length (varint) and one byte per port
+//     checkpoint count (u32), then per checkpoint: frame (varint), kind (u8), hash (u64)
+//
+
+namespace nes
+{
+
+class movie
+{
+public:
+    static constexpr uint8_t     VERSION = 1U;
+    static constexpr std::size_t PORTS   = 2U;
+
+    using input = std::array<uint8_t, PORTS>;
+
+    struct run
+    {
+        input    held;
+        uint32_t length;
+    };
+
+    struct checkpoint
+    {
+        enum class kind : uint8_t
+        {
+            FRAME,  // Hash of the frame's pixels.
+            STATE   // console::state_hash() after the frame.
+        };
+
+        uint64_t frame;
+        kind     type;
+        uint64_t hash;
+    };
+
+    movie() = default;
+    explicit movie(const uint64_t rom_hash) : rom_hash_(rom_hash) {}
+
+    // Appends one frame of input.
+    void append(const input &held);
+
+    // Checkpoints must be added in frame order, for frames already appended: one past
+    // the end could never be checked. Throws std::invalid_argument otherwise.
+    void add_checkpoint(const checkpoint &c);
+
+    uint64_t                       frame_count() const { return frames_; }
+    uint64_t                       rom_hash() const { return rom_hash_; }
+    const std::vector<run>        &runs() const { return runs_; }
+    const std::vector<checkpoint> &checkpoints() const { return checkpoints_; }
+
+    std::vector<uint8_t> serialize() const;
+    static movie         deserialize(const std::vector<uint8_t> &bytes);
+
+    void         save(const std::string &file_path) const;
+    static movie load(const std::string &file_path);
+
+private:
+    // Whether `c` can follow the checkpoints so far.
+    bool accepts(const checkpoint &c) const;
+
+    uint64_t                rom_hash_ = 0U;
+    uint64_t                frames_   = 0U;
+    std::vector<run>        runs_;
+    std::vector<checkpoint> checkpoints_;
+};
+
+} // namespace nes
@@ -0,0 +1,62 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#pragma once
+
+//
+// C interface to libnes-emu, for driving batches of consoles from other languages.
+//
+// Functions that can fail return NULL or a negative value; `nes_last_error()` then
+// describes the failure on the calling thread. Pointers into an instance stay valid
+// until the next `nes_step_batch()` on its batch or until the batch is destroyed.
+//
+
+#define NES_SCREEN_WIDTH  256
+#define NES_SCREEN_HEIGHT 240
+#define NES_RAM_SIZE      2048
+
+// Controller buttons, for `actions`.
+#define NES_BUTTON_A      0x01
+#define NES_BUTTON_B      0x02
+#define NES_BUTTON_SELECT 0x04
+#define NES_BUTTON_START  0x08
+#define NES_BUTTON_UP     0x10
+#define NES_BUTTON_DOWN   0x20
+#define NES_BUTTON_LEFT   0x40
+#define NES_BUTTON_RIGHT  0x80
+
+#if defined(__GNUC__)
+#define NES_API __attribute__((visibility("default")))
+#else
+#define NES_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct nes_batch nes_batch;
+
+// `n` consoles booted from the iNES image `rom`. Stepping uses up to `threads` threads,
+// or one per hardware thread when zero.
+NES_API nes_batch *nes_create_batch(uint32_t n, const uint8_t *rom, size_t rom_size, uint32_t threads);
+NES_API void       nes_destroy_batch(nes_batch *batch);
+
+NES_API uint32_t nes_batch_size(const nes_batch *batch);
+
+// Runs `frames` frames on every instance, with `actions[i]` held on instance i's first
+// controller (no buttons if `actions` is NULL). If `observations` is not NULL it must
+// hold n * NES_SCREEN_HEIGHT * NES_SCREEN_WIDTH bytes and receives each instance's last
+// frame as palette indices, copied out of the instance's own frame buffer (60 KiB each;
+// pass NULL and use nes_framebuffer() to read them in place). Returns 0 on success.
+NES_API int nes_step_batch(nes_batch *batch, const uint8_t *actions, uint32_t frames, uint8_t *observations);
+
+// Instance i's NES_RAM_SIZE bytes of work RAM and its last frame, in place.
+NES_API const uint8_t *nes_ram(const nes_batch *batch, uint32_t i);
+NES_API const uint8_t *nes_framebuffer(nes_batch *batch, uint32_t i);
+
+NES_API const char *nes_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
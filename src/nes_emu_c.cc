@@ -0,0 +1,110 @@
+#include "nes_emu.h"
+
+#include "batch.hh"
+#include "cartridge.hh"
+
+#include <exception>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+//
+// Exceptions never cross the C boundary: every entry point catches and records them.
+//
+
+struct nes_batch
+{
+    nes::batch impl;
+};
+
+static_assert(NES_SCREEN_WIDTH == ppu::SCREEN_WIDTH && NES_SCREEN_HEIGHT == ppu::SCREEN_HEIGHT,
+              "C header and PPU disagree on the screen size");
+static_assert(NES_RAM_SIZE == nes::RAM_SIZE, "C header and console disagree on the RAM size");
+
+namespace
+{
+    thread_local std::string last_error;
+
+    template<typename F, typename R>
+    R guarded(const F &f, const R failed)
+    {
+        try
+        {
+            return f();
+        }
+        catch(const std::exception &e)
+        {
+            last_error = e.what();
+        }
+        catch(...)
+        {
+            last_error = "Unknown error!";
+        }
+        return failed;
+    }
+
+    bool in_range(const nes_batch *batch, const uint32_t i)
+    {
+        if(batch == nullptr || i >= batch->impl.size())
+        {
+            last_error = "Instance out of range!";
+            return false;
+        }
+        return true;
+    }
+} // namespace
+
+extern "C" {
+
+nes_batch *nes_create_batch(const uint32_t n, const uint8_t *rom, const size_t rom_size, const uint32_t threads)
+{
+    return guarded(
+        [&]
+        {
+            const nes::cartridge cart = nes::load_ines(std::vector<uint8_t>(rom, rom + rom_size));
+            return new nes_batch{nes::batch(cart, n, threads)};
+        },
+        static_cast<nes_batch *>(nullptr));
+}
+
+void nes_destroy_batch(nes_batch *batch)
+{
+    delete batch;
+}
+
+uint32_t nes_batch_size(const nes_batch *batch)
+{
+    return batch != nullptr ? static_cast<uint32_t>(batch->impl.size()) : 0U;
+}
+
+int nes_step_batch(nes_batch *batch, const uint8_t *actions, const uint32_t frames, uint8_t *observations)
+{
+    return guarded(
+        [&]
+        {
+            if(batch == nullptr)
+            {
+                throw std::invalid_argument("Batch is null!");
+            }
+            batch->impl.step(actions, frames, observations);
+            return 0;
+        },
+        -1);
+}
+
+const uint8_t *nes_ram(const nes_batch *batch, const uint32_t i)
+{
+    return in_range(batch, i) ? batch->impl.ram(i) : nullptr;
+}
+
+const uint8_t *nes_framebuffer(nes_batch *batch, const uint32_t i)
+{
+    return in_range(batch, i) ? batch->impl.framebuffer(i) : nullptr;
+}
+
+const char *nes_last_error(void)
+{
+    return last_error.c_str();
+}
+
+} // extern "C"
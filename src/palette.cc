@@ -0,0 +1,270 @@
+#include "palette.hh"
+
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define NES_EMU_X86 1
+#endif
+
+namespace palette
+{
+
+namespace
+{
+    using ppu::SCREEN_HEIGHT;
+    using ppu::SCREEN_WIDTH;
+
+    // 2C02 palette, as RGB triplets.
+    constexpr std::array<uint8_t, 64U * 3U> BASE_PALETTE = {
+         84,  84,  84,    0,  30, 116,    8,  16, 144,   48,   0, 136,
+         68,   0, 100,   92,   0,  48,   84,   4,   0,   60,  24,   0,
+         32,  42,   0,    8,  58,   0,    0,  64,   0,    0,  60,   0,
+          0,  50,  60,    0,   0,   0,    0,   0,   0,    0,   0,   0,
+        152, 150, 152,    8,  76, 196,   48,  50, 236,   92,  30, 228,
+        136,  20, 176,  160,  20, 100,  152,  34,  32,  120,  60,   0,
+         84,  90,   0,   40, 114,   0,    8, 124,   0,    0, 118,  40,
+          0, 102, 120,    0,   0,   0,    0,   0,   0,    0,   0,   0,
+        236, 238, 236,   76, 154, 236,  120, 124, 236,  176,  98, 236,
+        228,  84, 236,  236,  88, 180,  236, 106, 100,  212, 136,  32,
+        160, 170,   0,  116, 196,   0,   76, 208,  32,   56, 204, 108,
+         56, 180, 204,   60,  60,  60,    0,   0,   0,    0,   0,   0,
+        236, 238, 236,  168, 204, 236,  188, 188, 236,  212, 178, 236,
+        236, 174, 236,  236, 174, 212,  236, 180, 176,  228, 196, 144,
+        204, 210, 120,  180, 222, 120,  168, 226, 144,  152, 226, 180,
+        160, 214, 228,  160, 162, 160,    0,   0,   0,    0,   0,   0};
+
+    // Each emphasis bit darkens the two channels it does not emphasise.
+    constexpr float EMPHASIS_ATTENUATION = 0.75F;
+
+    // Copies the first row of a scaled scanline into the remaining `scale - 1` rows.
+    void replicate_rows(rgba *row, const std::size_t pitch, const uint32_t scale)
+    {
+        for(uint32_t r = 1U; r < scale; ++r)
+        {
+            std::memcpy(row + (r * pitch), row, SCREEN_WIDTH * scale * sizeof(rgba));
+        }
+    }
+
+    const rgba *row_palette(const ppu::frame &f, const table &t, const std::size_t y)
+    {
+        return &t.entries[(f.emphasis[y] & 0x07U) * 64U];
+    }
+
+    void convert_scalar(const ppu::frame &f, const table &t, rgba *out, const std::size_t pitch, const uint32_t scale)
+    {
+        for(std::size_t y = 0U; y < SCREEN_HEIGHT; ++y)
+        {
+            const uint8_t *src     = &f.pixels[y * SCREEN_WIDTH];
+            const rgba    *colours = row_palette(f, t, y);
+            rgba          *dst     = out + (y * scale * pitch);
+
+            for(std::size_t x = 0U; x < SCREEN_WIDTH; ++x)
+            {
+                const rgba colour = colours[src[x] & 0x3FU];
+                for(uint32_t s = 0U; s < scale; ++s)
+                {
+                    dst[(x * scale) + s] = colour;
+                }
+            }
+
+            replicate_rows(dst, pitch, scale);
+        }
+    }
+
+#if defined(NES_EMU_X86)
+    // 32-bit x86 builds may not enable SSE2 by default; `supported()` checks for it.
+    __attribute__((target("sse2")))
+    void convert_sse2(const ppu::frame &f, const table &t, rgba *out, const std::size_t pitch, const uint32_t scale)
+    {
+        for(std::size_t y = 0U; y < SCREEN_HEIGHT; ++y)
+        {
+            const uint8_t *src     = &f.pixels[y * SCREEN_WIDTH];
+            const rgba    *colours = row_palette(f, t, y);
+            rgba          *dst     = out + (y * scale * pitch);
+
+            for(std::size_t x = 0U; x < SCREEN_WIDTH; x += 4U)
+            {
+                // No gather in SSE2, the lookups are scalar and the stores are not.
+                const __m128i c = _mm_set_epi32(static_cast<int>(colours[src[x + 3U] & 0x3FU]),
+                                                static_cast<int>(colours[src[x + 2U] & 0x3FU]),
+                                                static_cast<int>(colours[src[x + 1U] & 0x3FU]),
+                                                static_cast<int>(colours[src[x] & 0x3FU]));
+                __m128i *d = reinterpret_cast<__m128i *>(dst + (x * scale));
+
+                switch(scale)
+                {
+                    case 1U:
+                        _mm_storeu_si128(d, c);
+                        break;
+
+                    case 2U:
+                        _mm_storeu_si128(d, _mm_unpacklo_epi32(c, c));
+                        _mm_storeu_si128(d + 1, _mm_unpackhi_epi32(c, c));
+                        break;
+
+                    default:
+                        _mm_storeu_si128(d, _mm_shuffle_epi32(c, _MM_SHUFFLE(1, 0, 0, 0)));
+                        _mm_storeu_si128(d + 1, _mm_shuffle_epi32(c, _MM_SHUFFLE(2, 2, 1, 1)));
+                        _mm_storeu_si128(d + 2, _mm_shuffle_epi32(c, _MM_SHUFFLE(3, 3, 3, 2)));
+                        break;
+                }
+            }
+
+            replicate_rows(dst, pitch, scale);
+        }
+    }
+
+    __attribute__((target("avx2")))
+    void convert_avx2(const ppu::frame &f, const table &t, rgba *out, const std::size_t pitch, const uint32_t scale)
+    {
+        const __m256i index_mask = _mm256_set1_epi32(0x3F);
+
+        // Lane permutations that widen 8 pixels to 16 or 24.
+        const __m256i x2_lo = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+        const __m256i x2_hi = _mm256_setr_epi32(4, 4, 5, 5, 6, 6, 7, 7);
+        const __m256i x3_0  = _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2);
+        const __m256i x3_1  = _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5);
+        const __m256i x3_2  = _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7);
+
+        for(std::size_t y = 0U; y < SCREEN_HEIGHT; ++y)
+        {
+            const uint8_t *src     = &f.pixels[y * SCREEN_WIDTH];
+            const int     *colours = reinterpret_cast<const int *>(row_palette(f, t, y));
+            rgba          *dst     = out + (y * scale * pitch);
+
+            for(std::size_t x = 0U; x < SCREEN_WIDTH; x += 8U)
+            {
+                const __m128i bytes = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + x));
+                const __m256i index = _mm256_and_si256(_mm256_cvtepu8_epi32(bytes), index_mask);
+                const __m256i c     = _mm256_i32gather_epi32(colours, index, 4);
+                __m256i      *d     = reinterpret_cast<__m256i *>(dst + (x * scale));
+
+                switch(scale)
+                {
+                    case 1U:
+                        _mm256_storeu_si256(d, c);
+                        break;
+
+                    case 2U:
+                        _mm256_storeu_si256(d, _mm256_permutevar8x32_epi32(c, x2_lo));
+                        _mm256_storeu_si256(d + 1, _mm256_permutevar8x32_epi32(c, x2_hi));
+                        break;
+
+                    default:
+                        _mm256_storeu_si256(d, _mm256_permutevar8x32_epi32(c, x3_0));
+                        _mm256_storeu_si256(d + 1, _mm256_permutevar8x32_epi32(c, x3_1));
+                        _mm256_storeu_si256(d + 2, _mm256_permutevar8x32_epi32(c, x3_2));
+                        break;
+                }
+            }
+
+            replicate_rows(dst, pitch, scale);
+        }
+    }
+#endif
+
+} // namespace
+
+table make_table()
+{
+    table t;
+
+    for(uint32_t emphasis = 0U; emphasis < 8U; ++emphasis)
+    {
+        // Bit 0 emphasises red, bit 1 green, bit 2 blue.
+        std::array<float, 3U> gain = {1.0F, 1.0F, 1.0F};
+        for(uint32_t bit = 0U; bit < 3U; ++bit)
+        {
+            if(emphasis & (1U << bit))
+            {
+                for(uint32_t channel = 0U; channel < 3U; ++channel)
+                {
+                    gain[channel] *= (channel == bit) ? 1.0F : EMPHASIS_ATTENUATION;
+                }
+            }
+        }
+
+        for(uint32_t index = 0U; index < 64U; ++index)
+        {
+            const uint8_t *rgb = &BASE_PALETTE[index * 3U];
+            t.entries[(emphasis * 64U) + index] = make_rgba(static_cast<uint8_t>(rgb[0] * gain[0]),
+                                                            static_cast<uint8_t>(rgb[1] * gain[1]),
+                                                            static_cast<uint8_t>(rgb[2] * gain[2]));
+        }
+    }
+
+    return t;
+}
+
+bool supported(const kernel k)
+{
+    switch(k)
+    {
+        case kernel::SCALAR:
+            return true;
+
+#if defined(NES_EMU_X86)
+        case kernel::SSE2:
+            return __builtin_cpu_supports("sse2");
+
+        case kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+
+        default:
+            return false;
+    }
+}
+
+kernel best_kernel()
+{
+    static const kernel best = supported(kernel::AVX2) ? kernel::AVX2
+                             : supported(kernel::SSE2) ? kernel::SSE2
+                                                       : kernel::SCALAR;
+    return best;
+}
+
+void convert(const ppu::frame &f, const table &t, rgba *out, const std::size_t pitch, const uint32_t scale)
+{
+    convert(f, t, out, pitch, scale, best_kernel());
+}
+
+void convert(const ppu::frame &f, const table &t, rgba *out, const std::size_t pitch, const uint32_t scale,
+             const kernel k)
+{
+    if(scale < 1U || scale > 3U)
+    {
+        throw std::invalid_argument("Scale must be 1, 2 or 3!");
+    }
+
+    if(pitch < SCREEN_WIDTH * scale)
+    {
+        throw std::invalid_argument("Pitch is too small for the scaled frame!");
+    }
+
+    if(!supported(k))
+    {
+        throw std::invalid_argument("Kernel is not supported on this host!");
+    }
+
+    switch(k)
+    {
+#if defined(NES_EMU_X86)
+        case kernel::SSE2:
+            convert_sse2(f, t, out, pitch, scale);
+            break;
+
+        case kernel::AVX2:
+            convert_avx2(f, t, out, pitch, scale);
+            break;
+#endif
+
+        default:
+            convert_scalar(f, t, out, pitch, scale);
+            break;
+    }
+}
+
+} // namespace palette
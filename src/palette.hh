@@ -0,0 +1,54 @@
+#include "ppu.hh"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#pragma once
+
+//
+// Converts rendered frames (6-bit palette indices plus per-scanline emphasis bits)
+// into RGBA8888, optionally scaled up 2x or 3x with nearest-neighbour.
+//
+// There are three kernels producing identical output: a scalar reference, an SSE2
+// version (baseline on x86-64) and an AVX2 version that looks up 8 pixels at a time
+// with a gather. The best one the host supports is picked at runtime.
+//
+
+namespace palette
+{
+
+// R, G, B, A in memory order.
+using rgba = uint32_t;
+
+constexpr rgba make_rgba(const uint8_t r, const uint8_t g, const uint8_t b)
+{
+    return 0xFF000000U | (static_cast<rgba>(b) << 16U) | (static_cast<rgba>(g) << 8U) | r;
+}
+
+// 64 colours for each of the 8 emphasis combinations, indexed by
+// `(emphasis << 6) | index`.
+struct table
+{
+    alignas(64) std::array<rgba, 512U> entries;
+};
+
+// Builds the lookup table from the standard 2C02 palette.
+table make_table();
+
+enum class kernel : uint8_t
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+bool   supported(kernel k);
+kernel best_kernel();
+
+// Writes `f` to `out`, which must hold `SCREEN_HEIGHT * scale` rows of `pitch` pixels.
+// `pitch` must be at least `SCREEN_WIDTH * scale`. `scale` must be 1, 2 or 3.
+void convert(const ppu::frame &f, const table &t, rgba *out, std::size_t pitch, uint32_t scale);
+void convert(const ppu::frame &f, const table &t, rgba *out, std::size_t pitch, uint32_t scale, kernel k);
+
+} // namespace palette
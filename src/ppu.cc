@@ -0,0 +1,519 @@
+#include "ppu.hh"
+
+#include <algorithm>
+
+namespace ppu
+{
+
+namespace
+{
+    // $3F10/$3F14/$3F18/$3F1C mirror the backdrop entries of the background palettes.
+    uint8_t palette_index(const uint16_t address)
+    {
+        uint8_t index = address & 0x1FU;
+        if((index & 0x13U) == 0x10U)
+        {
+            index &= ~0x10U;
+        }
+
+        return index;
+    }
+
+    // Returns the 2-bit pattern value of pixel `column` in row `row` of `tile`.
+    uint8_t pattern_pixel(const state &s, const uint16_t table, const uint8_t tile,
+                          const uint8_t row, const uint8_t column)
+    {
+        const uint16_t address = table + (tile * 16U) + row;
+        const uint8_t  shift   = 7U - column;
+
+        return ((s.chr[address] >> shift) & 1U) | (((s.chr[address + 8U] >> shift) & 1U) << 1U);
+    }
+
+    // Increment coarse-X, switching horizontal nametable on wrap.
+    void increment_coarse_x(uint16_t &v)
+    {
+        if((v & 0x001FU) == 31U)
+        {
+            v &= ~0x001FU;
+            v ^= 0x0400U;
+        }
+        else
+        {
+            ++v;
+        }
+    }
+
+    // Increment fine/coarse-Y, switching vertical nametable on wrap.
+    void increment_y(uint16_t &v)
+    {
+        if((v & 0x7000U) != 0x7000U)
+        {
+            v += 0x1000U;
+            return;
+        }
+
+        v &= ~0x7000U;
+        uint16_t coarse_y = (v & 0x03E0U) >> 5U;
+        if(coarse_y == 29U)
+        {
+            coarse_y = 0U;
+            v ^= 0x0800U;
+        }
+        else if(coarse_y == 31U)
+        {
+            coarse_y = 0U;
+        }
+        else
+        {
+            ++coarse_y;
+        }
+
+        v = (v & ~0x03E0U) | (coarse_y << 5U);
+    }
+
+    // Sprite pixel for OAM entry `index` at sprite-relative (`column`, `row`).
+    uint8_t sprite_pixel(const state &s, const uint8_t index, uint8_t row, uint8_t column)
+    {
+        const uint8_t *entry  = &s.oam[index * 4U];
+        const uint8_t  tile   = entry[1];
+        const uint8_t  attr   = entry[2];
+        const bool     tall   = (s.ctrl & 0x20U) != 0U;
+        const uint8_t  height = tall ? 16U : 8U;
+
+        if(attr & 0x80U) { row = height - 1U - row; }
+        if(attr & 0x40U) { column = 7U - column; }
+
+        if(tall)
+        {
+            const uint16_t table = (tile & 1U) ? 0x1000U : 0x0000U;
+            return pattern_pixel(s, table, (tile & 0xFEU) + (row >> 3U), row & 7U, column);
+        }
+
+        const uint16_t table = (s.ctrl & 0x08U) ? 0x1000U : 0x0000U;
+        return pattern_pixel(s, table, tile, row, column);
+    }
+
+} // namespace
+
+uint16_t nametable_index(const mirroring mode, const uint16_t address)
+{
+    const uint16_t offset = (address - 0x2000U) & 0x0FFFU;
+    const uint16_t table  = offset / 0x400U;
+    const uint16_t index  = offset & 0x3FFU;
+
+    switch(mode)
+    {
+        case mirroring::HORIZONTAL:   return ((table >> 1U) * 0x400U) + index;
+        case mirroring::VERTICAL:     return ((table & 1U) * 0x400U) + index;
+        case mirroring::SINGLE_LOWER: return index;
+        case mirroring::SINGLE_UPPER: return 0x400U + index;
+        case mirroring::FOUR_SCREEN:  return offset;
+    }
+
+    return index;
+}
+
+uint8_t read_vram(const state &s, uint16_t address)
+{
+    address &= 0x3FFFU;
+
+    if(address < 0x2000U)
+    {
+        return s.chr[address];
+    }
+    else if(address < 0x3F00U)
+    {
+        return s.vram[nametable_index(s.mode, address)];
+    }
+    else
+    {
+        return s.palette[palette_index(address)];
+    }
+}
+
+void write_vram(state &s, uint16_t address, const uint8_t value)
+{
+    address &= 0x3FFFU;
+
+    if(address < 0x2000U)
+    {
+        s.chr[address] = value;
+    }
+    else if(address < 0x3F00U)
+    {
+        s.vram[nametable_index(s.mode, address)] = value;
+    }
+    else
+    {
+        s.palette[palette_index(address)] = value & 0x3FU;
+    }
+}
+
+void write_register(state &s, const registers reg, const uint8_t value)
+{
+    switch(reg)
+    {
+        case registers::CTRL:
+            s.ctrl = value;
+            s.t    = (s.t & 0xF3FFU) | ((value & 0x03U) << 10U);
+            break;
+
+        case registers::MASK:
+            s.mask = value;
+            break;
+
+        case registers::STATUS:
+            // Read-only.
+            break;
+
+        case registers::OAM_ADDR:
+            s.oam_addr = value;
+            break;
+
+        case registers::OAM_DATA:
+            s.oam[s.oam_addr++] = value;
+            break;
+
+        case registers::SCROLL:
+            if(!s.w)
+            {
+                s.t = (s.t & 0xFFE0U) | (value >> 3U);
+                s.x = value & 0x07U;
+            }
+            else
+            {
+                s.t = (s.t & 0x8C1FU) | ((value & 0x07U) << 12U) | ((value & 0xF8U) << 2U);
+            }
+            s.w = !s.w;
+            break;
+
+        case registers::ADDR:
+            if(!s.w)
+            {
+                s.t = (s.t & 0x80FFU) | ((value & 0x3FU) << 8U);
+            }
+            else
+            {
+                s.t = (s.t & 0xFF00U) | value;
+                s.v = s.t;
+            }
+            s.w = !s.w;
+            break;
+
+        case registers::DATA:
+            write_vram(s, s.v, value);
+            s.v += (s.ctrl & 0x04U) ? 32U : 1U;
+            break;
+    }
+}
+
+void oam_dma(state &s, const uint8_t *page)
+{
+    // OAMADDR wraps, so the page lands rotated by it.
+    const std::size_t head = s.oam.size() - s.oam_addr;
+    std::copy(page, page + head, s.oam.begin() + s.oam_addr);
+    std::copy(page + head, page + s.oam.size(), s.oam.begin());
+}
+
+uint8_t read_register(state &s, const registers reg)
+{
+    switch(reg)
+    {
+        case registers::STATUS:
+            s.w = false;
+            return 0x00U;
+
+        case registers::OAM_DATA:
+            return s.oam[s.oam_addr];
+
+        case registers::DATA:
+        {
+            const uint16_t address = s.v & 0x3FFFU;
+            uint8_t        result  = s.read_buffer;
+
+            if(address >= 0x3F00U)
+            {
+                // Palette reads are not buffered, the buffer gets the nametable "underneath".
+                result        = read_vram(s, address);
+                s.read_buffer = read_vram(s, address - 0x1000U);
+            }
+            else
+            {
+                s.read_buffer = read_vram(s, address);
+            }
+
+            s.v += (s.ctrl & 0x04U) ? 32U : 1U;
+            return result;
+        }
+
+        default:
+            return 0x00U;
+    }
+}
+
+uint8_t background_pixel(const state &s, const uint16_t scroll, const uint8_t fine_x,
+                         const uint32_t x, const uint32_t y)
+{
+    // Position of the top-left pixel within the 512x480 nametable plane.
+    const uint32_t origin_x = ((scroll & 0x001FU) << 3U) + fine_x + ((scroll & 0x0400U) ? 256U : 0U);
+    const uint32_t origin_y = (((scroll >> 5U) & 0x1FU) << 3U) + ((scroll >> 12U) & 0x07U)
+                              + ((scroll & 0x0800U) ? 240U : 0U);
+
+    const uint32_t px = (origin_x + x) % 512U;
+    const uint32_t py = (origin_y + y) % 480U;
+
+    const uint16_t table    = ((px / 256U) | ((py / 240U) << 1U)) * 0x400U;
+    const uint16_t nt_entry = 0x2000U + table + (((py % 240U) / 8U) * 32U) + ((px % 256U) / 8U);
+    const uint8_t  tile     = read_vram(s, nt_entry);
+    const uint16_t pattern  = (s.ctrl & 0x10U) ? 0x1000U : 0x0000U;
+
+    return pattern_pixel(s, pattern, tile, py % 8U, px % 8U);
+}
+
+//
+// Timing model
+//
+
+void timing::begin_frame(const state &s, const uint64_t frame_number)
+{
+    frame_        = frame_number;
+    frame_scroll_ = s.t;
+    frame_fine_x_ = s.x;
+
+    // OAM, CHR and nametables are normally only touched during vblank, so the state
+    // at the start of the frame is what the frame will be rendered from.
+    sprite_zero_hit_dot_ = predict_sprite_zero_hit(s);
+}
+
+uint8_t timing::read_status(const state &s, const uint64_t cpu_cycle)
+{
+    const uint64_t frame  = frame_of(cpu_cycle);
+    const uint32_t dot    = dot_of(cpu_cycle);
+    uint8_t        status = 0x00U;
+
+    if(frame != frame_)
+    {
+        begin_frame(s, frame);
+    }
+
+    if(dot >= VBLANK_SET_DOT && dot < VBLANK_CLEAR_DOT && vblank_read_frame_ != frame)
+    {
+        status |= STATUS_VBLANK;
+        vblank_read_frame_ = frame;
+    }
+
+    if(dot >= sprite_zero_hit_dot_ && dot < VBLANK_CLEAR_DOT)
+    {
+        status |= STATUS_SPRITE_ZERO_HIT;
+    }
+
+    return status;
+}
+
+uint32_t timing::predict_sprite_zero_hit(const state &s) const
+{
+    // Both layers must be on for a hit to register.
+    if((s.mask & 0x18U) != 0x18U)
+    {
+        return DOTS_PER_FRAME;
+    }
+
+    const uint32_t top        = s.oam[0] + 1U;
+    const uint32_t left       = s.oam[3];
+    const uint32_t height     = (s.ctrl & 0x20U) ? 16U : 8U;
+    const bool     clip_left  = (s.mask & 0x06U) != 0x06U;
+
+    for(uint32_t row = 0U; row < height && (top + row) < SCREEN_HEIGHT; ++row)
+    {
+        for(uint32_t column = 0U; column < 8U && (left + column) < 255U; ++column)
+        {
+            const uint32_t x = left + column;
+            const uint32_t y = top + row;
+
+            if(clip_left && x < 8U)
+            {
+                continue;
+            }
+
+            if(sprite_pixel(s, 0U, row, column) != 0U
+               && background_pixel(s, frame_scroll_, frame_fine_x_, x, y) != 0U)
+            {
+                return (y * DOTS_PER_SCANLINE) + x + 1U;
+            }
+        }
+    }
+
+    return DOTS_PER_FRAME;
+}
+
+//
+// Renderer
+//
+
+void renderer::begin_frame(frame &out, const uint64_t number)
+{
+    out.number       = number;
+    next_scanline_   = 0U;
+    sprite_zero_hit_ = false;
+}
+
+void renderer::catch_up(state &s, const uint32_t dot, frame &out)
+{
+    while(next_scanline_ < SCANLINES_PER_FRAME && (next_scanline_ * DOTS_PER_SCANLINE) < dot)
+    {
+        if(next_scanline_ < SCREEN_HEIGHT)
+        {
+            if(drawing_)
+            {
+                render_scanline(s, next_scanline_, out);
+            }
+            else
+            {
+                skip_scanline(s, next_scanline_);
+            }
+        }
+        else if(next_scanline_ == PRE_RENDER_SCANLINE && rendering_enabled(s))
+        {
+            // Dots 280-304 of the pre-render line reload the whole of v from t.
+            s.v = s.t;
+        }
+
+        ++next_scanline_;
+    }
+}
+
+void renderer::skip_scanline(state &s, const uint32_t line)
+{
+    if(!rendering_enabled(s))
+    {
+        return;
+    }
+
+    // Same updates to v as render_scanline().
+    if(line != 0U)
+    {
+        s.v = (s.v & ~0x041FU) | (s.t & 0x041FU);
+    }
+
+    increment_y(s.v);
+}
+
+void renderer::render_scanline(state &s, const uint32_t line, frame &out)
+{
+    uint8_t *pixels = &out.pixels[line * SCREEN_WIDTH];
+    out.emphasis[line] = s.mask >> 5U;
+
+    if(!rendering_enabled(s))
+    {
+        std::fill(pixels, pixels + SCREEN_WIDTH, s.palette[0] & 0x3FU);
+        return;
+    }
+
+    // Dot 257 of the previous line copied the horizontal bits of t into v.
+    if(line != 0U)
+    {
+        s.v = (s.v & ~0x041FU) | (s.t & 0x041FU);
+    }
+
+    // Background: fetch 33 tiles so fine-X can shift the row by up to 7 pixels.
+    std::array<uint8_t, SCREEN_WIDTH + 8U> background{};
+    if(s.mask & 0x08U)
+    {
+        uint16_t       v       = s.v;
+        const uint16_t pattern = (s.ctrl & 0x10U) ? 0x1000U : 0x0000U;
+        const uint8_t  fine_y  = (v >> 12U) & 0x07U;
+
+        for(uint32_t column = 0U; column < 33U; ++column)
+        {
+            const uint8_t  tile      = read_vram(s, 0x2000U | (v & 0x0FFFU));
+            const uint16_t attr_addr = 0x23C0U | (v & 0x0C00U) | ((v >> 4U) & 0x38U) | ((v >> 2U) & 0x07U);
+            const uint8_t  shift     = ((v >> 4U) & 0x04U) | (v & 0x02U);
+            const uint8_t  palette   = ((read_vram(s, attr_addr) >> shift) & 0x03U) << 2U;
+
+            const uint16_t address = pattern + (tile * 16U) + fine_y;
+            const uint8_t  lo      = s.chr[address];
+            const uint8_t  hi      = s.chr[address + 8U];
+
+            for(uint32_t bit = 0U; bit < 8U && (column * 8U + bit) < background.size(); ++bit)
+            {
+                const uint8_t shift_bit = 7U - bit;
+                const uint8_t value     = ((lo >> shift_bit) & 1U) | (((hi >> shift_bit) & 1U) << 1U);
+                background[column * 8U + bit] = value ? (palette | value) : 0U;
+            }
+
+            increment_coarse_x(v);
+        }
+    }
+
+    // Sprites: evaluate the first eight on this line, lowest OAM index wins.
+    std::array<uint8_t, SCREEN_WIDTH> sprite{};
+    std::array<bool, SCREEN_WIDTH>    behind{};
+    std::array<bool, SCREEN_WIDTH>    sprite_zero{};
+    if(s.mask & 0x10U)
+    {
+        const uint32_t height = (s.ctrl & 0x20U) ? 16U : 8U;
+        uint32_t       found  = 0U;
+
+        for(uint32_t index = 0U; index < 64U && found < 8U; ++index)
+        {
+            const uint8_t *entry = &s.oam[index * 4U];
+            const uint32_t top   = entry[0] + 1U;
+
+            if(line < top || line >= top + height)
+            {
+                continue;
+            }
+
+            ++found;
+            for(uint32_t column = 0U; column < 8U; ++column)
+            {
+                const uint32_t x = entry[3] + column;
+                if(x >= SCREEN_WIDTH || sprite[x] != 0U)
+                {
+                    continue;
+                }
+
+                const uint8_t value = sprite_pixel(s, index, line - top, column);
+                if(value != 0U)
+                {
+                    sprite[x]      = 0x10U | ((entry[2] & 0x03U) << 2U) | value;
+                    behind[x]      = (entry[2] & 0x20U) != 0U;
+                    sprite_zero[x] = (index == 0U);
+                }
+            }
+        }
+    }
+
+    // Composite.
+    const bool    show_bg_left  = (s.mask & 0x02U) != 0U;
+    const bool    show_spr_left = (s.mask & 0x04U) != 0U;
+    const uint8_t grey_mask     = (s.mask & 0x01U) ? 0x30U : 0x3FU;
+
+    for(uint32_t x = 0U; x < SCREEN_WIDTH; ++x)
+    {
+        const uint8_t bg = (x >= 8U || show_bg_left) ? background[x + s.x] : 0U;
+        const uint8_t sp = (x >= 8U || show_spr_left) ? sprite[x] : 0U;
+
+        if(sprite_zero[x] && bg != 0U && sp != 0U && x != 255U)
+        {
+            sprite_zero_hit_ = true;
+        }
+
+        uint8_t colour = 0U;
+        if(sp != 0U && (bg == 0U || !behind[x]))
+        {
+            colour = sp;
+        }
+        else if(bg != 0U)
+        {
+            colour = bg;
+        }
+
+        pixels[x] = s.palette[palette_index(colour)] & grey_mask;
+    }
+
+    // Dot 256 increments the vertical position.
+    increment_y(s.v);
+}
+
+} // namespace ppu
@@ -0,0 +1,194 @@
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#pragma once
+
+//
+// Implements the 2C02 PPU.
+//
+// The PPU is split in two so that rendering can run on a thread of its own:
+//     - `state` and the register functions. These are cheap, and are applied both
+//       to the CPU-side shadow copy and to the copy owned by the renderer.
+//     - `renderer`, which replays a frame's worth of register accesses and turns
+//       them into pixels one scanline at a time.
+//
+
+namespace ppu
+{
+
+// Frame geometry (NTSC).
+constexpr std::size_t SCREEN_WIDTH        = 256U;
+constexpr std::size_t SCREEN_HEIGHT       = 240U;
+constexpr uint32_t    DOTS_PER_SCANLINE   = 341U;
+constexpr uint32_t    SCANLINES_PER_FRAME = 262U;
+constexpr uint32_t    DOTS_PER_FRAME      = DOTS_PER_SCANLINE * SCANLINES_PER_FRAME;
+constexpr uint32_t    DOTS_PER_CPU_CYCLE  = 3U;
+constexpr uint32_t    VBLANK_SCANLINE     = 241U;
+constexpr uint32_t    PRE_RENDER_SCANLINE = 261U;
+
+// Dots at which the vblank flag is raised and status flags are cleared.
+constexpr uint32_t VBLANK_SET_DOT   = VBLANK_SCANLINE * DOTS_PER_SCANLINE + 1U;
+constexpr uint32_t VBLANK_CLEAR_DOT = PRE_RENDER_SCANLINE * DOTS_PER_SCANLINE + 1U;
+
+// CPU-visible registers ($2000 - $2007, mirrored up to $3FFF).
+enum class registers : uint8_t
+{
+    CTRL     = 0x00,
+    MASK     = 0x01,
+    STATUS   = 0x02,
+    OAM_ADDR = 0x03,
+    OAM_DATA = 0x04,
+    SCROLL   = 0x05,
+    ADDR     = 0x06,
+    DATA     = 0x07
+};
+
+// Status register bits.
+constexpr uint8_t STATUS_SPRITE_OVERFLOW = 1U << 5U;
+constexpr uint8_t STATUS_SPRITE_ZERO_HIT = 1U << 6U;
+constexpr uint8_t STATUS_VBLANK          = 1U << 7U;
+
+// Nametable mirroring, set by the cartridge.
+enum class mirroring : uint8_t
+{
+    HORIZONTAL,
+    VERTICAL,
+    SINGLE_LOWER,
+    SINGLE_UPPER,
+    FOUR_SCREEN
+};
+
+// Rendered frame.
+//    Pixels are 6-bit palette indices. Emphasis bits (PPUMASK 5-7) are kept per
+//    scanline since games only change them between lines.
+struct frame
+{
+    std::array<uint8_t, SCREEN_WIDTH * SCREEN_HEIGHT> pixels{};
+    std::array<uint8_t, SCREEN_HEIGHT>                emphasis{};
+    uint64_t                                          number = 0U;
+};
+
+// PPU state
+struct state
+{
+    // Registers
+    uint8_t ctrl     = 0x00;
+    uint8_t mask     = 0x00;
+    uint8_t oam_addr = 0x00;
+
+    // Internal "loopy" scroll registers.
+    uint16_t v = 0x0000;  // Current VRAM address.
+    uint16_t t = 0x0000;  // Temporary VRAM address / top-left onscreen tile.
+    uint8_t  x = 0x00;    // Fine X-scroll.
+    bool     w = false;   // First/second write toggle.
+
+    uint8_t read_buffer = 0x00;  // $2007 read buffer.
+
+    mirroring mode = mirroring::HORIZONTAL;
+
+    // Memory
+    std::array<uint8_t, 0x2000> chr{};      // Pattern tables (CHR-ROM/RAM).
+    std::array<uint8_t, 0x1000> vram{};     // Nametables.
+    std::array<uint8_t, 0x20>   palette{};  // Palette RAM.
+    std::array<uint8_t, 0x100>  oam{};      // Object attribute memory.
+};
+
+// True if either background or sprite rendering is enabled.
+constexpr bool rendering_enabled(const state &s) { return (s.mask & 0x18U) != 0U; }
+
+// Maps a $2000 - $3EFF address onto an index into `state::vram`.
+uint16_t nametable_index(mirroring mode, uint16_t address);
+
+// PPU address space.
+uint8_t read_vram(const state &s, uint16_t address);
+void    write_vram(state &s, uint16_t address, uint8_t value);
+
+// CPU-facing register accesses. Reads of $2002 only apply their side-effects here,
+// the status value itself comes from whoever owns the timing.
+void    write_register(state &s, registers reg, uint8_t value);
+uint8_t read_register(state &s, registers reg);
+
+// OAM DMA: the same as 256 $2004 writes of `page`, starting at and leaving `oam_addr`.
+void oam_dma(state &s, const uint8_t *page);
+
+// Returns the 2-bit background pixel at screen position (`x`, `y`) assuming `scroll`
+// (a value of `t`) and `fine_x` were in effect for the whole frame. Used to predict
+// sprite-0 hits without rendering.
+uint8_t background_pixel(const state &s, uint16_t scroll, uint8_t fine_x, uint32_t x, uint32_t y);
+
+//
+// Timing model.
+//    Answers the questions the CPU needs synchronous answers to ($2002 reads) from
+//    the CPU cycle counter and the shadow state, without rendering anything.
+//
+class timing
+{
+public:
+    // Must be called on the first access of every new frame, before the access itself
+    // is applied, so that the frame's starting scroll is captured.
+    void begin_frame(const state &s, uint64_t frame_number);
+
+    // Value of $2002 as seen at `cpu_cycle`. Reading clears the vblank flag.
+    uint8_t read_status(const state &s, uint64_t cpu_cycle);
+
+    // Frame number/dot within the frame for a CPU cycle.
+    static uint64_t frame_of(const uint64_t cpu_cycle)
+    {
+        return (cpu_cycle * DOTS_PER_CPU_CYCLE) / DOTS_PER_FRAME;
+    }
+
+    static uint32_t dot_of(const uint64_t cpu_cycle)
+    {
+        return static_cast<uint32_t>((cpu_cycle * DOTS_PER_CPU_CYCLE) % DOTS_PER_FRAME);
+    }
+
+    uint64_t frame_number() const { return frame_; }
+
+private:
+    // Dot of the predicted sprite-0 hit for this frame, or DOTS_PER_FRAME if none.
+    uint32_t predict_sprite_zero_hit(const state &s) const;
+
+    uint64_t frame_               = 0U;
+    uint64_t vblank_read_frame_   = UINT64_MAX;  // Frame whose vblank flag was cleared by a read.
+    uint16_t frame_scroll_        = 0x0000;      // `t` at the start of the frame.
+    uint8_t  frame_fine_x_        = 0x00;
+    bool     hit_predicted_       = false;
+    uint32_t sprite_zero_hit_dot_ = DOTS_PER_FRAME;
+};
+
+//
+// Scanline renderer.
+//    Renders a frame by catching up to the timestamp of each register access before
+//    it is applied, so mid-frame scroll/palette changes land on the right scanline.
+//
+class renderer
+{
+public:
+    // Start rendering frame `number` into `out`.
+    void begin_frame(frame &out, uint64_t number);
+
+    // Render every scanline that starts before `dot` (relative to the frame start).
+    void catch_up(state &s, uint32_t dot, frame &out);
+
+    // Render whatever is left of the frame.
+    void finish_frame(state &s, frame &out) { catch_up(s, DOTS_PER_FRAME, out); }
+
+    // Sprite-0 hit as observed while rendering the last frame.
+    bool sprite_zero_hit() const { return sprite_zero_hit_; }
+
+    // With drawing off, scanlines only update the scroll registers and no pixels are
+    // produced. Used for frames nobody will look at.
+    void set_drawing(const bool enabled) { drawing_ = enabled; }
+    bool drawing() const { return drawing_; }
+
+private:
+    void render_scanline(state &s, uint32_t line, frame &out);
+    void skip_scanline(state &s, uint32_t line);
+
+    uint32_t next_scanline_   = 0U;
+    bool     sprite_zero_hit_ = false;
+    bool     drawing_         = true;
+};
+
+} // namespace ppu
@@ -0,0 +1,255 @@
+#include "ppu_pipeline.hh"
+
+#include <algorithm>
+
+namespace ppu
+{
+
+pipeline::pipeline(const state &initial, const mode m)
+    : mode_(m),
+      shadow_(initial),
+      render_state_(initial)
+{
+    renderer_.begin_frame(frames_.back(), render_frame_);
+
+    if(mode_ == mode::THREADED)
+    {
+        thread_ = std::thread([this] { render_loop(); });
+    }
+}
+
+pipeline::~pipeline()
+{
+    if(thread_.joinable())
+    {
+        stop_.store(true, std::memory_order_release);
+        thread_.join();
+    }
+}
+
+void pipeline::write(const registers reg, const uint8_t value, const uint64_t cpu_cycle)
+{
+    sync_frame(cpu_cycle);
+
+    latch_ = value;
+    write_register(shadow_, reg, value);
+    log({cpu_cycle, access::kind::WRITE, reg, value});
+}
+
+uint8_t pipeline::read(const registers reg, const uint64_t cpu_cycle)
+{
+    sync_frame(cpu_cycle);
+
+    switch(reg)
+    {
+        case registers::STATUS:
+        {
+            const uint8_t status = timing_.read_status(shadow_, cpu_cycle);
+            read_register(shadow_, reg);
+            log({cpu_cycle, access::kind::READ, reg, 0x00U});
+
+            // Low bits are open bus.
+            return status | (latch_ & 0x1FU);
+        }
+
+        case registers::OAM_DATA:
+            return read_register(shadow_, reg);
+
+        case registers::DATA:
+        {
+            const uint8_t value = read_register(shadow_, reg);
+            log({cpu_cycle, access::kind::READ, reg, 0x00U});
+            return value;
+        }
+
+        default:
+            return latch_;
+    }
+}
+
+void pipeline::oam_dma(const uint8_t *page, const uint64_t cpu_cycle)
+{
+    sync_frame(cpu_cycle);
+    ppu::oam_dma(shadow_, page);
+
+    if(mode_ == mode::INLINE)
+    {
+        consume({cpu_cycle, access::kind::OAM_DMA, registers::OAM_DATA, 0x00U}, page);
+        return;
+    }
+
+    // The render thread gets its own copy; the payload goes first so the renderer
+    // always finds it when it sees the access.
+    dma_page payload;
+    std::copy(page, page + payload.size(), payload.begin());
+    while(!dma_.try_push(payload))
+    {
+        std::this_thread::yield();
+    }
+    log({cpu_cycle, access::kind::OAM_DMA, registers::OAM_DATA, 0x00U});
+}
+
+void pipeline::end_frame(const uint64_t cpu_cycle)
+{
+    log({cpu_cycle, access::kind::END_OF_FRAME, registers::STATUS, 0x00U});
+    ++frames_submitted_;
+
+    // Keep at most one frame in flight.
+    while(frames_submitted_ - frames_rendered() > 1U)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void pipeline::flush()
+{
+    while(frames_rendered() != frames_submitted_)
+    {
+        std::this_thread::yield();
+    }
+}
+
+void pipeline::set_drawing(const bool enabled)
+{
+    // Cycle 0 never triggers a catch-up, so scanlines already due are not affected.
+    log({0U, access::kind::SET_DRAWING, registers::MASK, static_cast<uint8_t>(enabled ? 1U : 0U)});
+}
+
+void pipeline::save(snapshot &out)
+{
+    flush();
+
+    out.shadow           = shadow_;
+    out.timer            = timing_;
+    out.latch            = latch_;
+    out.frames_submitted = frames_submitted_;
+    out.render_state     = render_state_;
+    out.render           = renderer_;
+    out.render_frame     = render_frame_;
+}
+
+void pipeline::restore(const snapshot &in)
+{
+    flush();
+
+    shadow_           = in.shadow;
+    timing_           = in.timer;
+    latch_            = in.latch;
+    frames_submitted_ = in.frames_submitted;
+    render_state_     = in.render_state;
+    render_frame_     = in.render_frame;
+
+    // Whether frames are drawn is a setting, not part of the state.
+    const bool drawing = renderer_.drawing();
+    renderer_ = in.render;
+    renderer_.set_drawing(drawing);
+
+    // The renderer is idle, so the render side can be written from here. The next log
+    // push publishes these writes to it.
+    renderer_.begin_frame(frames_.back(), render_frame_);
+    frames_rendered_.store(frames_submitted_, std::memory_order_release);
+}
+
+void pipeline::log(const access &a)
+{
+    if(mode_ == mode::INLINE)
+    {
+        consume(a, nullptr);
+        return;
+    }
+
+    while(!log_.try_push(a))
+    {
+        std::this_thread::yield();
+    }
+}
+
+void pipeline::sync_frame(const uint64_t cpu_cycle)
+{
+    const uint64_t frame_number = timing::frame_of(cpu_cycle);
+    if(frame_number != timing_.frame_number())
+    {
+        timing_.begin_frame(shadow_, frame_number);
+    }
+}
+
+//
+// Render side
+//
+
+uint32_t pipeline::relative_dot(const uint64_t cpu_cycle) const
+{
+    const uint64_t dot   = cpu_cycle * DOTS_PER_CPU_CYCLE;
+    const uint64_t start = render_frame_ * DOTS_PER_FRAME;
+
+    if(dot < start)
+    {
+        return 0U;
+    }
+
+    return static_cast<uint32_t>(std::min<uint64_t>(dot - start, DOTS_PER_FRAME));
+}
+
+void pipeline::consume(const access &a, const uint8_t *page)
+{
+    renderer_.catch_up(render_state_, relative_dot(a.cycle), frames_.back());
+
+    switch(a.type)
+    {
+        case access::kind::WRITE:
+            write_register(render_state_, a.reg, a.value);
+            break;
+
+        case access::kind::READ:
+            read_register(render_state_, a.reg);
+            break;
+
+        case access::kind::OAM_DMA:
+            if(page != nullptr)
+            {
+                ppu::oam_dma(render_state_, page);
+            }
+            break;
+
+        case access::kind::SET_DRAWING:
+            renderer_.set_drawing(a.value != 0U);
+            break;
+
+        case access::kind::END_OF_FRAME:
+            renderer_.finish_frame(render_state_, frames_.back());
+            if(renderer_.drawing())
+            {
+                frames_.publish();
+            }
+
+            render_frame_ = std::max(render_frame_ + 1U, timing::frame_of(a.cycle));
+            renderer_.begin_frame(frames_.back(), render_frame_);
+            frames_rendered_.fetch_add(1U, std::memory_order_release);
+            break;
+    }
+}
+
+void pipeline::render_loop()
+{
+    access   a;
+    dma_page page;
+
+    while(true)
+    {
+        if(log_.try_pop(a))
+        {
+            const bool has_payload = (a.type == access::kind::OAM_DMA) && dma_.try_pop(page);
+            consume(a, has_payload ? page.data() : nullptr);
+            continue;
+        }
+
+        if(stop_.load(std::memory_order_acquire) && log_.empty())
+        {
+            break;
+        }
+
+        std::this_thread::yield();
+    }
+}
+
+} // namespace ppu
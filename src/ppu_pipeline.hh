@@ -0,0 +1,143 @@
+#include "ppu.hh"
+#include "ring_buffer.hh"
+#include "triple_buffer.hh"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+#pragma once
+
+//
+// Runs the PPU one frame behind the CPU.
+//
+// The CPU side applies every register access to a cheap shadow `state` (so $2004/$2007
+// reads can be answered immediately), answers $2002 from the `timing` model, and logs
+// the access with its CPU cycle into a lock-free queue. The render side replays the
+// log against its own copy of the state and renders the frame a scanline at a time.
+//
+// Both sides run the exact same register code, so the shadow never drifts from the
+// rendered state except for rendering's own updates to `v`. Games do not touch $2007
+// while rendering, so those are not mirrored back.
+//
+// Frames are rendered straight into the back slot of a triple buffer and published
+// with an index swap, so consumers read the latest finished frame in place.
+//
+
+namespace ppu
+{
+
+// A register access made by the CPU, timestamped with the CPU cycle counter.
+struct access
+{
+    enum class kind : uint8_t
+    {
+        WRITE,
+        READ,         // Reads with side-effects ($2002, $2007).
+        OAM_DMA,      // Payload is in the DMA queue.
+        END_OF_FRAME,
+        SET_DRAWING   // Value is 1 to draw frames, 0 to only track scroll.
+    };
+
+    uint64_t  cycle;
+    kind      type;
+    registers reg;
+    uint8_t   value;
+};
+
+class pipeline
+{
+public:
+    using frame_buffer = utils::triple_buffer<frame>;
+
+    enum class mode
+    {
+        INLINE,    // Render on the calling thread as accesses come in.
+        THREADED   // Render on a dedicated thread, one frame behind.
+    };
+
+    // Everything needed to rewind the PPU to a frame boundary.
+    struct snapshot
+    {
+        state    shadow;
+        timing   timer;
+        uint8_t  latch;
+        uint64_t frames_submitted;
+        state    render_state;
+        renderer render;
+        uint64_t render_frame;
+    };
+
+    pipeline(const state &initial, mode m);
+    ~pipeline();
+
+    pipeline(const pipeline &)            = delete;
+    pipeline &operator=(const pipeline &) = delete;
+
+    //
+    // CPU side.
+    //
+    void    write(registers reg, uint8_t value, uint64_t cpu_cycle);
+    uint8_t read(registers reg, uint64_t cpu_cycle);
+    void    oam_dma(const uint8_t *page, uint64_t cpu_cycle);
+
+    // Marks `cpu_cycle` as the first cycle of the next frame. In threaded mode this
+    // blocks while the renderer is more than a frame behind, which bounds latency.
+    void end_frame(uint64_t cpu_cycle);
+
+    // Blocks until every submitted frame has been rendered.
+    void flush();
+
+    // Frames submitted from now on are drawn (the default) or only have their scroll
+    // tracked. Undrawn frames are not published to `output()`.
+    void set_drawing(bool enabled);
+
+    // Between frames only. Both wait for the renderer to catch up first.
+    void save(snapshot &out);
+    void restore(const snapshot &in);
+
+    mode         threading() const { return mode_; }
+    const state &shadow() const { return shadow_; }
+    uint64_t     frames_rendered() const { return frames_rendered_.load(std::memory_order_acquire); }
+
+    // Consumer end of the finished frames. Only one thread may acquire from it.
+    frame_buffer &output() { return frames_; }
+
+private:
+    using dma_page = std::array<uint8_t, 0x100>;
+
+    // Enough for a full frame of $2007 uploads without stalling the CPU.
+    static constexpr std::size_t LOG_CAPACITY = 8192U;
+    static constexpr std::size_t DMA_CAPACITY = 4U;
+
+    void log(const access &a);
+    void sync_frame(uint64_t cpu_cycle);
+
+    // Render side.
+    void     consume(const access &a, const uint8_t *page);
+    void     render_loop();
+    uint32_t relative_dot(uint64_t cpu_cycle) const;
+
+    mode mode_;
+
+    // CPU side.
+    state    shadow_;
+    timing   timing_;
+    uint8_t  latch_            = 0x00;  // Last value written, returned by write-only registers.
+    uint64_t frames_submitted_ = 0U;
+
+    // Render side.
+    state        render_state_;
+    renderer     renderer_;
+    frame_buffer frames_;
+    uint64_t     render_frame_ = 0U;
+
+    utils::spsc_ring<access, LOG_CAPACITY>   log_;
+    utils::spsc_ring<dma_page, DMA_CAPACITY> dma_;
+    std::atomic<uint64_t>                    frames_rendered_{0U};
+    std::atomic<bool>                        stop_{false};
+    std::thread                              thread_;
+};
+
+} // namespace ppu
@@ -0,0 +1,460 @@
+#include "predecode.hh"
+
+#include "code_trace.hh"
+#include "interpreter.hh"
+#include "utils.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace nes
+{
+
+namespace
+{
+    using codes = cpu::op::codes;
+    using cpu::ends_block;
+    using cpu::is_branch;
+
+    constexpr char MAGIC[4] = {'N', 'E', 'S', 'D'};
+
+    struct file_header
+    {
+        char     magic[4];
+        uint32_t version;
+        uint64_t rom_hash;
+        uint64_t checksum;  // Of everything after the header.
+        uint32_t prg_size;
+        uint32_t block_count;
+        uint32_t idle_loop_count;
+        uint32_t reserved;
+    };
+
+    constexpr uint8_t code(const codes c)
+    {
+        return static_cast<uint8_t>(c);
+    }
+
+    // Memory that only the CPU itself changes and that has no side effects on read.
+    bool plain_memory(const uint16_t address)
+    {
+        return address < 0x2000U || address >= 0x6000U;
+    }
+
+    // Instructions whose only effects are on registers and flags, given the operand.
+    bool idle_safe(const uint8_t opcode, const uint16_t operand)
+    {
+        switch(static_cast<codes>(opcode))
+        {
+            case codes::LDA_IMMEDIATE:
+            case codes::LDX_IMMEDIATE:
+            case codes::LDY_IMMEDIATE:
+            case codes::CMP_IMMEDIATE:
+            case codes::CPX_IMMEDIATE:
+            case codes::CPY_IMMEDIATE:
+            case codes::AND_IMMEDIATE:
+            case codes::ORA_IMMEDIATE:
+            case codes::NOP:
+            case codes::CLC:
+            case codes::SEC:
+            case codes::CLV:
+            case codes::REG_TAX:
+            case codes::REG_TAY:
+            case codes::REG_TXA:
+            case codes::REG_TYA:
+            case codes::LDA_ZERO_PAGE:
+            case codes::LDX_ZERO_PAGE:
+            case codes::LDY_ZERO_PAGE:
+            case codes::CMP_ZERO_PAGE:
+            case codes::CPX_ZERO_PAGE:
+            case codes::CPY_ZERO_PAGE:
+            case codes::AND_ZERO_PAGE:
+            case codes::ORA_ZERO_PAGE:
+            case codes::BIT_ZERO_PAGE:
+                return true;
+
+            case codes::LDA_ABSOLUTE:
+            case codes::LDX_ABSOLUTE:
+            case codes::LDY_ABSOLUTE:
+            case codes::CMP_ABSOLUTE:
+            case codes::CPX_ABSOLUTE:
+            case codes::CPY_ABSOLUTE:
+            case codes::AND_ABSOLUTE:
+            case codes::ORA_ABSOLUTE:
+            case codes::BIT_ABSOLUTE:
+                return plain_memory(operand);
+
+            default:
+                return false;
+        }
+    }
+
+    // Instructions usually followed by a branch on the flags they set.
+    bool sets_branch_flags(const uint8_t opcode)
+    {
+        switch(static_cast<codes>(opcode))
+        {
+            case codes::CMP_IMMEDIATE:
+            case codes::CMP_ZERO_PAGE:
+            case codes::CMP_ZERO_PAGE_X:
+            case codes::CMP_ABSOLUTE:
+            case codes::CMP_ABSOLUTE_X:
+            case codes::CMP_ABSOLUTE_Y:
+            case codes::CMP_INDIRECT_X:
+            case codes::CMP_INDIRECT_Y:
+            case codes::CPX_IMMEDIATE:
+            case codes::CPX_ZERO_PAGE:
+            case codes::CPX_ABSOLUTE:
+            case codes::CPY_IMMEDIATE:
+            case codes::CPY_ZERO_PAGE:
+            case codes::CPY_ABSOLUTE:
+            case codes::BIT_ZERO_PAGE:
+            case codes::BIT_ABSOLUTE:
+            case codes::REG_DEX:
+            case codes::REG_DEY:
+            case codes::REG_INX:
+            case codes::REG_INY:
+                return true;
+
+            default:
+                return false;
+        }
+    }
+
+    template<typename T>
+    void append(std::vector<uint8_t> &out, const T *items, const std::size_t count)
+    {
+        const auto *bytes = reinterpret_cast<const uint8_t *>(items);
+        out.insert(out.end(), bytes, bytes + count * sizeof(T));
+    }
+} // namespace
+
+predecode predecode::analyze(const cartridge &cart)
+{
+    const std::vector<uint8_t> &prg  = cart.prg_rom;
+    const std::size_t           size = prg.size();
+    if(size == 0U || size > 0x8000U || (size & (size - 1U)) != 0U)
+    {
+        throw std::invalid_argument("PRG-ROM must be a power of two up to 32 KiB!");
+    }
+
+    const uint16_t mask = static_cast<uint16_t>(size - 1U);
+
+    const auto byte = [&prg, mask](const uint32_t address) { return prg[address & mask]; };
+    const auto word = [&byte](const uint32_t address)
+    {
+        return static_cast<uint16_t>(byte(address) | (byte(address + 1U) << 8U));
+    };
+
+    // Smaller ROMs are mirrored; blocks are listed in the mirror the reset vector uses.
+    const uint16_t reset = word(cpu::RESET_VECTOR);
+    const uint32_t base  = reset >= PRG_ROM_START ? (reset & ~static_cast<uint32_t>(mask)) : 0x10000U - size;
+
+    std::vector<uint8_t> flags(size, 0U);
+
+    cpu::trace_code(
+        [&byte](const uint16_t address) { return byte(address); },
+        [&flags, mask](const uint16_t address, const bool jumped)
+        {
+            const uint8_t kind = jumped ? static_cast<uint8_t>(JUMP_TARGET) : uint8_t{0U};
+            flags[address & mask] |= BLOCK_START | kind;
+        },
+        [&flags, mask](const uint16_t address, const uint8_t opcode)
+        {
+            if((flags[address & mask] & INSTRUCTION) != 0U)
+            {
+                return false;
+            }
+            flags[address & mask] |= INSTRUCTION;
+
+            // The instruction after a branch or call starts a block.
+            const uint32_t next = address + cpu::LENGTHS[opcode];
+            if((is_branch(opcode) || opcode == code(codes::JSR_ABSOLUTE)) && next < 0x10000U)
+            {
+                flags[next & mask] |= BLOCK_START;
+            }
+            return true;
+        });
+
+    // Split into basic blocks, looking for idle loops and compare-and-branch pairs.
+    std::vector<block>     blocks;
+    std::vector<idle_loop> idle_loops;
+
+    for(std::size_t offset = 0U; offset < size; ++offset)
+    {
+        if((flags[offset] & (INSTRUCTION | BLOCK_START)) != (INSTRUCTION | BLOCK_START))
+        {
+            continue;
+        }
+
+        const uint32_t start = base + offset;
+        block          b     = {static_cast<uint16_t>(start), 0U, 0U, 0U};
+        bool           idle  = true;
+
+        for(uint32_t pc = start;;)
+        {
+            const uint8_t  opcode = byte(pc);
+            const uint32_t next   = pc + cpu::LENGTHS[opcode];
+            ++b.instructions;
+            b.cycles += cpu::CYCLES[opcode];
+
+            const bool last = ends_block(opcode) || next >= 0x10000U ||
+                              (flags[next & mask] & (INSTRUCTION | BLOCK_START)) != INSTRUCTION;
+
+            if(next < 0x10000U && sets_branch_flags(opcode) && is_branch(byte(next)) &&
+               (flags[next & mask] & JUMP_TARGET) == 0U)
+            {
+                flags[pc & mask] |= FUSIBLE;
+            }
+
+            if(!last)
+            {
+                const uint16_t operand = cpu::LENGTHS[opcode] == 3U ? word(pc + 1U) : byte(pc + 1U);
+                idle                   = idle && idle_safe(opcode, operand);
+                pc                     = next;
+                continue;
+            }
+
+            b.length = static_cast<uint16_t>(next - start);
+            blocks.push_back(b);
+
+            if(idle && is_branch(opcode) &&
+               static_cast<uint16_t>(next + static_cast<int8_t>(byte(pc + 1U))) == start)
+            {
+                // Taken branches cost one more cycle, two when they cross a page.
+                const bool crossed = ((start ^ next) & 0xFF00U) != 0U;
+                idle_loops.push_back({b.start, static_cast<uint16_t>(b.cycles + (crossed ? 2U : 1U))});
+                flags[offset] |= IDLE_LOOP;
+            }
+            else if(idle && opcode == code(codes::JMP_ABSOLUTE) && word(pc + 1U) == start)
+            {
+                idle_loops.push_back({b.start, b.cycles});
+                flags[offset] |= IDLE_LOOP;
+            }
+            break;
+        }
+    }
+
+    file_header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version         = VERSION;
+    header.rom_hash        = cart.hash;
+    header.prg_size        = static_cast<uint32_t>(size);
+    header.block_count     = static_cast<uint32_t>(blocks.size());
+    header.idle_loop_count = static_cast<uint32_t>(idle_loops.size());
+
+    predecode result;
+    std::vector<uint8_t> &image = result.owned_;
+    append(image, &header, 1U);
+    append(image, blocks.data(), blocks.size());
+    append(image, idle_loops.data(), idle_loops.size());
+    append(image, flags.data(), flags.size());
+
+    header.checksum = utils::hash64(image.data() + sizeof(header), image.size() - sizeof(header));
+    std::memcpy(image.data(), &header, sizeof(header));
+
+    result.bind(image.data(), image.size(), cart);
+    return result;
+}
+
+predecode predecode::load(const std::string &path, const cartridge &cart)
+{
+    const int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0)
+    {
+        throw std::runtime_error("Failed to open predecode cache!");
+    }
+
+    struct stat info;
+    void       *mapping = MAP_FAILED;
+    if(fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        mapping = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+
+    if(mapping == MAP_FAILED)
+    {
+        throw std::runtime_error("Failed to map predecode cache!");
+    }
+
+    predecode result;
+    result.mapping_      = mapping;
+    result.mapping_size_ = static_cast<std::size_t>(info.st_size);
+    result.bind(static_cast<const uint8_t *>(mapping), result.mapping_size_, cart);
+    return result;
+}
+
+predecode predecode::load_or_build(const cartridge &cart, const std::string &directory)
+{
+    const std::string path = cache_path(cart, directory);
+    try
+    {
+        return load(path, cart);
+    }
+    catch(const std::runtime_error &)
+    {
+        // Missing, stale or damaged: rebuild it below.
+    }
+
+    predecode built = analyze(cart);
+    try
+    {
+        built.save(path);
+    }
+    catch(const std::runtime_error &)
+    {
+        // An unwritable cache only costs the next process the analysis.
+    }
+    return built;
+}
+
+std::string predecode::cache_path(const cartridge &cart, const std::string &directory)
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.nesd", static_cast<unsigned long long>(cart.hash));
+    return directory + "/" + name;
+}
+
+void predecode::save(const std::string &path) const
+{
+    // Other processes may be mapping or writing the same file, so write elsewhere
+    // and rename over it.
+    const std::string temporary = path + ".tmp." + std::to_string(getpid());
+    {
+        std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char *>(image_), static_cast<std::streamsize>(image_size_));
+        if(!out)
+        {
+            std::remove(temporary.c_str());
+            throw std::runtime_error("Failed to write predecode cache!");
+        }
+    }
+
+    if(std::rename(temporary.c_str(), path.c_str()) != 0)
+    {
+        std::remove(temporary.c_str());
+        throw std::runtime_error("Failed to replace predecode cache!");
+    }
+}
+
+predecode::predecode(predecode &&other) noexcept
+{
+    *this = std::move(other);
+}
+
+predecode &predecode::operator=(predecode &&other) noexcept
+{
+    if(this != &other)
+    {
+        release();
+
+        // Moving a vector keeps its buffer, so the pointers stay valid.
+        owned_           = std::move(other.owned_);
+        mapping_         = other.mapping_;
+        mapping_size_    = other.mapping_size_;
+        image_           = other.image_;
+        image_size_      = other.image_size_;
+        flags_           = other.flags_;
+        prg_mask_        = other.prg_mask_;
+        blocks_          = other.blocks_;
+        block_count_     = other.block_count_;
+        idle_loops_      = other.idle_loops_;
+        idle_loop_count_ = other.idle_loop_count_;
+        rom_hash_        = other.rom_hash_;
+
+        other.mapping_ = nullptr;
+        other.image_   = nullptr;
+    }
+    return *this;
+}
+
+predecode::~predecode()
+{
+    release();
+}
+
+void predecode::release()
+{
+    if(mapping_ != nullptr)
+    {
+        munmap(mapping_, mapping_size_);
+        mapping_ = nullptr;
+    }
+}
+
+uint16_t predecode::idle_loop_cycles(const uint16_t address) const
+{
+    if((flags(address) & IDLE_LOOP) == 0U)
+    {
+        return 0U;
+    }
+
+    const auto found = std::lower_bound(idle_loops_, idle_loops_ + idle_loop_count_, address & prg_mask_,
+                                        [this](const idle_loop &loop, const uint32_t offset)
+                                        { return (loop.head & prg_mask_) < offset; });
+    return found != idle_loops_ + idle_loop_count_ && (found->head & prg_mask_) == (address & prg_mask_)
+               ? found->cycles
+               : 0U;
+}
+
+void predecode::bind(const uint8_t *image, const std::size_t size, const cartridge &cart)
+{
+    file_header header;
+    if(size < sizeof(header))
+    {
+        throw std::runtime_error("Predecode cache is truncated!");
+    }
+    std::memcpy(&header, image, sizeof(header));
+
+    if(std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+    {
+        throw std::runtime_error("Not a predecode cache!");
+    }
+    if(header.version != VERSION)
+    {
+        throw std::runtime_error("Unsupported predecode cache version!");
+    }
+    if(header.rom_hash != cart.hash || header.prg_size != cart.prg_rom.size())
+    {
+        throw std::runtime_error("Predecode cache is for a different ROM!");
+    }
+
+    const std::size_t expected = sizeof(header) + header.block_count * sizeof(block) +
+                                 header.idle_loop_count * sizeof(idle_loop) + header.prg_size;
+    if(size != expected)
+    {
+        throw std::runtime_error("Predecode cache is truncated!");
+    }
+    if(utils::hash64(image + sizeof(header), size - sizeof(header)) != header.checksum)
+    {
+        throw std::runtime_error("Predecode cache checksum mismatch!");
+    }
+
+    const uint8_t *cursor = image + sizeof(header);
+
+    image_      = image;
+    image_size_ = size;
+    rom_hash_   = header.rom_hash;
+    prg_mask_   = static_cast<uint16_t>(header.prg_size - 1U);
+
+    blocks_      = reinterpret_cast<const block *>(cursor);
+    block_count_ = header.block_count;
+    cursor += block_count_ * sizeof(block);
+
+    idle_loops_      = reinterpret_cast<const idle_loop *>(cursor);
+    idle_loop_count_ = header.idle_loop_count;
+    cursor += idle_loop_count_ * sizeof(idle_loop);
+
+    flags_ = cursor;
+}
+
+} // namespace nes
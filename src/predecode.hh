@@ -0,0 +1,124 @@
+#include "cartridge.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#pragma once
+
+//
+// Static analysis of a cartridge's PRG-ROM, cached on disk.
+//
+// Code is found by following every path from the reset, NMI and IRQ vectors. The
+// result flags each PRG byte (instruction start, basic-block leader, jump target, idle
+// loop head, compare-and-branch pair) and lists the basic blocks and idle loops. An
+// idle loop is a block that only reads memory without side effects and branches back
+// to itself, so once its registers stop changing only an interrupt can end it; the
+// console uses them to skip such loops whole.
+//
+// The analysis always lives in its file layout, so a cache file written once can be
+// mapped read-only by every later process instead of being rebuilt. Cache files are
+// named after the ROM hash and carry a version and a checksum; a file that fails
+// either check is rebuilt.
+//
+
+namespace nes
+{
+
+class predecode
+{
+public:
+    static constexpr uint32_t VERSION = 1U;
+
+    enum flag : uint8_t
+    {
+        INSTRUCTION = 1U << 0U,  // An instruction starts here.
+        BLOCK_START = 1U << 1U,  // ... and begins a basic block.
+        JUMP_TARGET = 1U << 2U,  // Something branches, jumps or calls here.
+        IDLE_LOOP   = 1U << 3U,  // Head of an idle loop.
+        FUSIBLE     = 1U << 4U   // Sets the flags a conditional branch right after tests.
+    };
+
+    struct block
+    {
+        uint16_t start;
+        uint16_t length;        // Bytes.
+        uint16_t instructions;
+        uint16_t cycles;        // Without branch and page-crossing penalties.
+    };
+
+    struct idle_loop
+    {
+        uint16_t head;
+        uint16_t cycles;        // Per iteration, including the branch back.
+    };
+
+    // Analyses `cart` in memory.
+    static predecode analyze(const cartridge &cart);
+
+    // Maps `path`. Throws std::runtime_error if it is not a valid cache for `cart`.
+    static predecode load(const std::string &path, const cartridge &cart);
+
+    // Maps `<directory>/<rom hash>.nesd`, analysing and writing it first if it is
+    // missing or invalid.
+    static predecode load_or_build(const cartridge &cart, const std::string &directory);
+
+    // Path of the cache file for `cart` in `directory`.
+    static std::string cache_path(const cartridge &cart, const std::string &directory);
+
+    // Writes the analysis to `path`, replacing it atomically.
+    void save(const std::string &path) const;
+
+    predecode(predecode &&other) noexcept;
+    predecode &operator=(predecode &&other) noexcept;
+    ~predecode();
+
+    predecode(const predecode &)            = delete;
+    predecode &operator=(const predecode &) = delete;
+
+    // Flags of the byte at CPU address `address`; zero outside PRG-ROM.
+    uint8_t flags(const uint16_t address) const
+    {
+        return address >= PRG_ROM_START ? flags_[address & prg_mask_] : 0U;
+    }
+
+    // Cycles per iteration of the idle loop starting at `address`, or zero.
+    uint16_t idle_loop_cycles(uint16_t address) const;
+
+    const block     *blocks() const { return blocks_; }
+    std::size_t      block_count() const { return block_count_; }
+    const idle_loop *idle_loops() const { return idle_loops_; }
+    std::size_t      idle_loop_count() const { return idle_loop_count_; }
+
+    uint64_t rom_hash() const { return rom_hash_; }
+
+    // True when the analysis is mapped from a cache file rather than built here.
+    bool mapped() const { return mapping_ != nullptr; }
+
+private:
+    static constexpr uint16_t PRG_ROM_START = 0x8000U;
+
+    predecode() = default;
+
+    // Points the accessors into `image` after checking it describes `cart`.
+    void bind(const uint8_t *image, std::size_t size, const cartridge &cart);
+    void release();
+
+    // Either `owned_` holds the image or it is mapped from a file.
+    std::vector<uint8_t> owned_;
+    void                *mapping_      = nullptr;
+    std::size_t          mapping_size_ = 0U;
+
+    const uint8_t   *image_           = nullptr;
+    std::size_t      image_size_      = 0U;
+    const uint8_t   *flags_           = nullptr;
+    uint16_t         prg_mask_        = 0U;
+    const block     *blocks_          = nullptr;
+    std::size_t      block_count_     = 0U;
+    const idle_loop *idle_loops_      = nullptr;
+    std::size_t      idle_loop_count_ = 0U;
+    uint64_t         rom_hash_        = 0U;
+};
+
+} // namespace nes
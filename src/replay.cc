@@ -0,0 +1,122 @@
+#include "replay.hh"
+#include "utils.hh"
+
+#include <chrono>
+#include <stdexcept>
+
+namespace nes
+{
+
+namespace
+{
+    uint64_t checkpoint_hash(console &c, const movie::checkpoint::kind k)
+    {
+        return (k == movie::checkpoint::kind::FRAME) ? frame_hash(c.latest_frame()) : c.state_hash();
+    }
+
+    // Calls `on_frame(index)` after each frame of `m` has been run on `c` to its end,
+    // through any debugger breaks, until it returns false.
+    template<typename Callback>
+    void play(console &c, const movie &m, const Callback &on_frame)
+    {
+        uint64_t index = 0U;
+        for(const movie::run &r : m.runs())
+        {
+            for(std::size_t port = 0U; port < movie::PORTS; ++port)
+            {
+                c.set_input(port, r.held[port]);
+            }
+
+            for(uint32_t i = 0U; i < r.length; ++i, ++index)
+            {
+                // A debugger break stops the frame part-way; carry on to its end.
+                while(!c.run_frame())
+                {
+                }
+                if(!on_frame(index))
+                {
+                    return;
+                }
+            }
+        }
+    }
+} // namespace
+
+uint64_t frame_hash(const ppu::frame &f)
+{
+    const uint64_t h = utils::hash64(f.pixels.data(), f.pixels.size());
+    return utils::hash64(f.emphasis.data(), f.emphasis.size(), h);
+}
+
+replay_report replay(console &c, const movie &m, const bool stop_on_divergence)
+{
+    if(m.rom_hash() != 0U && m.rom_hash() != c.rom_hash())
+    {
+        throw std::invalid_argument("Movie was recorded with a different ROM!");
+    }
+
+    replay_report report;
+
+    const auto &checkpoints = m.checkpoints();
+    std::size_t next        = 0U;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    play(c, m, [&](const uint64_t index)
+    {
+        ++report.frames;
+
+        for(; next < checkpoints.size() && checkpoints[next].frame == index; ++next)
+        {
+            const uint64_t actual = checkpoint_hash(c, checkpoints[next].type);
+            if(actual == checkpoints[next].hash)
+            {
+                ++report.checkpoints_passed;
+            }
+            else if(!report.diverged)
+            {
+                report.diverged    = true;
+                report.failure     = checkpoints[next];
+                report.actual_hash = actual;
+            }
+        }
+
+        return !(report.diverged && stop_on_divergence);
+    });
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    report.seconds = elapsed.count();
+
+    return report;
+}
+
+void record_checkpoints(console &c, movie &m, const movie::checkpoint::kind k, const uint64_t interval)
+{
+    if(interval == 0U)
+    {
+        throw std::invalid_argument("Checkpoint interval must be non-zero!");
+    }
+
+    movie recorded(c.rom_hash());
+    for(const movie::run &r : m.runs())
+    {
+        for(uint32_t i = 0U; i < r.length; ++i)
+        {
+            recorded.append(r.held);
+        }
+    }
+
+    const uint64_t last = m.frame_count() - 1U;
+    play(c, m, [&](const uint64_t index)
+    {
+        if(((index + 1U) % interval) == 0U || index == last)
+        {
+            recorded.add_checkpoint({index, k, checkpoint_hash(c, k)});
+        }
+        return true;
+    });
+
+    m = std::move(recorded);
+}
+
+} // namespace nes
@@ -0,0 +1,47 @@
+#include "console.hh"
+#include "movie.hh"
+
+#include <cstdint>
+
+#pragma once
+
+//
+// Plays movies back through a console as fast as the host allows.
+//
+// Input is fed to the controllers before each frame and nothing paces emulation, so
+// throughput is bound only by the core. Frame hashes need the frame to be rendered,
+// so in threaded mode the renderer is only waited on at FRAME checkpoints.
+//
+
+namespace nes
+{
+
+// Hash of a frame's pixels and emphasis bits.
+uint64_t frame_hash(const ppu::frame &f);
+
+struct replay_report
+{
+    uint64_t frames             = 0U;
+    uint64_t checkpoints_passed = 0U;
+
+    // First checkpoint that did not match, if any.
+    bool              diverged    = false;
+    movie::checkpoint failure     = {};
+    uint64_t          actual_hash = 0U;
+
+    double seconds = 0.0;  // Wall-clock time.
+
+    double frames_per_second() const { return seconds > 0.0 ? frames / seconds : 0.0; }
+};
+
+// Plays `m` on `c`, which must be freshly powered on. Frames are run through debugger
+// breaks, so checkpoints always see whole frames. Stops at the first checkpoint
+// that does not match unless `stop_on_divergence` is false. Throws
+// std::invalid_argument if the movie was recorded against a different ROM.
+replay_report replay(console &c, const movie &m, bool stop_on_divergence = true);
+
+// Plays `m` on `c` and appends a checkpoint of kind `k` every `interval` frames (and on
+// the last one), replacing any it had. Used to record the expected hashes.
+void record_checkpoints(console &c, movie &m, movie::checkpoint::kind k, uint64_t interval);
+
+} // namespace nes
@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+
+#pragma once
+
+namespace utils
+{
+    // Size of a cache-line on the hosts we run on. Used to keep data that is written
+    // by different threads from sharing a line.
+    constexpr std::size_t CACHE_LINE_SIZE = 64U;
+
+    //
+    // Single-producer/single-consumer ring buffer.
+    //
+    // Both ends are wait-free: a push or a pop is a bounded number of loads and stores
+    // and never waits on the other thread. Each side keeps a cached copy of the other
+    // side's index so that the shared cache-line is only touched once the cached view
+    // has been used up.
+    //
+    template<typename T, std::size_t Capacity>
+    class spsc_ring
+    {
+        static_assert(Capacity != 0U && (Capacity & (Capacity - 1U)) == 0U,
+                      "Capacity must be a power of two!");
+        static_assert(std::is_trivially_copyable<T>::value,
+                      "Elements are copied in bulk and must be trivially copyable!");
+
+    public:
+        static constexpr std::size_t capacity() { return Capacity; }
+
+        // Producer: returns false if the ring is full.
+        bool try_push(const T &value)
+        {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if(head - cached_tail_ == Capacity)
+            {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+                if(head - cached_tail_ == Capacity)
+                {
+                    return false;
+                }
+            }
+
+            buffer_[head & MASK] = value;
+            head_.store(head + 1U, std::memory_order_release);
+            return true;
+        }
+
+        // Producer: pushes as many of `values` as fit, returns the number pushed.
+        std::size_t push(const T *values, const std::size_t count)
+        {
+            const std::size_t head = head_.load(std::memory_order_relaxed);
+            if(Capacity - (head - cached_tail_) < count)
+            {
+                cached_tail_ = tail_.load(std::memory_order_acquire);
+            }
+
+            const std::size_t n = std::min(count, Capacity - (head - cached_tail_));
+            for(std::size_t i = 0U; i < n; ++i)
+            {
+                buffer_[(head + i) & MASK] = values[i];
+            }
+
+            head_.store(head + n, std::memory_order_release);
+            return n;
+        }
+
+        // Consumer: returns false if the ring is empty.
+        bool try_pop(T &value)
+        {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if(tail == cached_head_)
+            {
+                cached_head_ = head_.load(std::memory_order_acquire);
+                if(tail == cached_head_)
+                {
+                    return false;
+                }
+            }
+
+            value = buffer_[tail & MASK];
+            tail_.store(tail + 1U, std::memory_order_release);
+            return true;
+        }
+
+        // Consumer: pops up to `count` elements into `values`, returns the number popped.
+        std::size_t pop(T *values, const std::size_t count)
+        {
+            const std::size_t tail = tail_.load(std::memory_order_relaxed);
+            if(cached_head_ - tail < count)
+            {
+                cached_head_ = head_.load(std::memory_order_acquire);
+            }
+
+            const std::size_t n = std::min(count, cached_head_ - tail);
+            for(std::size_t i = 0U; i < n; ++i)
+            {
+                values[i] = buffer_[(tail + i) & MASK];
+            }
+
+            tail_.store(tail + n, std::memory_order_release);
+            return n;
+        }
+
+        // Number of queued elements. Only exact when called from one of the two ends
+        // while the other is idle.
+        std::size_t size() const
+        {
+            return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+        }
+
+        bool empty() const { return size() == 0U; }
+
+    private:
+        static constexpr std::size_t MASK = Capacity - 1U;
+
+        // Producer side.
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head_{0U};
+        std::size_t cached_tail_ = 0U;
+
+        // Consumer side.
+        alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail_{0U};
+        std::size_t cached_head_ = 0U;
+
+        alignas(CACHE_LINE_SIZE) std::array<T, Capacity> buffer_;
+    };
+
+} // namespace utils
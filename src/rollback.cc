@@ -0,0 +1,152 @@
+#include "rollback.hh"
+
+#include "movie.hh"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nes
+{
+
+loopback_link::loopback_link(const uint32_t delay, const uint32_t jitter, const uint32_t seed)
+    : delay_(delay),
+      jitter_(0U, jitter),
+      random_(seed),
+      endpoints_{end(*this, 0U), end(*this, 1U)}
+{
+}
+
+void loopback_link::end::send(const input_packet &packet)
+{
+    const uint64_t arrival = link_.now_ + link_.delay_ + link_.jitter_(link_.random_);
+    link_.queues_[peer_ ^ 1U].push_back({packet, arrival});
+}
+
+bool loopback_link::end::receive(input_packet &out)
+{
+    // Packets sent later may overtake earlier ones, so scan rather than pop the front.
+    auto &queue = link_.queues_[peer_];
+    const auto arrived = std::find_if(queue.begin(), queue.end(),
+                                      [this](const in_flight &f) { return f.arrival <= link_.now_; });
+    if(arrived == queue.end())
+    {
+        return false;
+    }
+
+    out = arrived->packet;
+    queue.erase(arrived);
+    return true;
+}
+
+rollback_session::rollback_session(console &c, transport &link, const std::size_t local_port,
+                                   const uint32_t max_rollback)
+    : console_(c),
+      link_(link),
+      local_port_(local_port),
+      max_rollback_(max_rollback),
+      snapshots_(max_rollback + 1U),
+      // The remote peer can be up to `max_rollback` frames ahead, so inputs cover that
+      // many frames on either side of ours.
+      inputs_(2U * (max_rollback + 1U))
+{
+    if(local_port >= movie::PORTS)
+    {
+        throw std::invalid_argument("Local port out of range!");
+    }
+    if(max_rollback == 0U)
+    {
+        throw std::invalid_argument("Rollback window must be at least one frame!");
+    }
+}
+
+bool rollback_session::advance(const uint8_t held)
+{
+    const uint64_t first_wrong = receive();
+
+    if(first_wrong < frame_)
+    {
+        ++rollbacks_;
+        console_.restore(snapshots_[first_wrong % snapshots_.size()]);
+
+        // The frame run next flushes the save file for the whole corrected stretch.
+        console_.set_rendering(false);
+        console_.set_audio(false);
+        console_.set_speculative(true);
+        for(uint64_t f = first_wrong; f < frame_; ++f)
+        {
+            if(f != first_wrong)
+            {
+                console_.save(snapshots_[f % snapshots_.size()]);
+            }
+            run(f);
+            ++resimulated_;
+        }
+        console_.set_rendering(true);
+        console_.set_audio(true);
+        console_.set_speculative(false);
+    }
+
+    if(frame_ >= confirmed_ + max_rollback_)
+    {
+        ++stalls_;
+        return false;
+    }
+
+    input_at(frame_).local = held;
+    link_.send({frame_, held});
+
+    console_.save(snapshots_[frame_ % snapshots_.size()]);
+    run(frame_);
+    ++frame_;
+    return true;
+}
+
+uint64_t rollback_session::receive()
+{
+    uint64_t     first_wrong = frame_;
+    input_packet packet;
+
+    while(link_.receive(packet))
+    {
+        if(packet.frame < confirmed_)
+        {
+            continue;
+        }
+        if(packet.frame >= frame_ + inputs_.size() / 2U)
+        {
+            throw std::runtime_error("Remote input too far ahead of the rollback window!");
+        }
+
+        frame_input &in = input_at(packet.frame);
+        if(packet.frame < frame_ && in.remote != packet.held)
+        {
+            first_wrong = std::min(first_wrong, packet.frame);
+        }
+        in.remote        = packet.held;
+        in.confirmed_for = packet.frame;
+    }
+
+    while(input_at(confirmed_).confirmed_for == confirmed_)
+    {
+        last_remote_ = input_at(confirmed_).remote;
+        ++confirmed_;
+    }
+
+    return first_wrong;
+}
+
+void rollback_session::run(const uint64_t frame)
+{
+    // Unconfirmed frames repeat the last confirmed remote input.
+    frame_input &in = input_at(frame);
+    if(in.confirmed_for != frame)
+    {
+        in.remote = last_remote_;
+    }
+
+    console_.set_input(local_port_, in.local);
+    console_.set_input(local_port_ ^ 1U, in.remote);
+    console_.run_frame();
+}
+
+} // namespace nes
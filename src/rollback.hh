@@ -0,0 +1,144 @@
+#include "console.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <random>
+#include <vector>
+
+#pragma once
+
+//
+// Rollback netplay.
+//
+// Each peer runs the game immediately with its own input and a prediction of the
+// remote one (the last input it received). Every frame's starting state is kept in a
+// ring of preallocated snapshots; when a remote input arrives that differs from what
+// was predicted, the console is restored to that frame and the frames since are run
+// again, without drawing or sound, before the current frame is run and shown. A peer
+// never runs more than `max_rollback` frames past the last confirmed remote input, so
+// a rollback always finds its snapshot and fits in one host frame.
+//
+
+namespace nes
+{
+
+// One player's input for one frame.
+struct input_packet
+{
+    uint64_t frame;
+    uint8_t  held;
+};
+
+// Delivers input packets to the other peer. Implementations may delay and reorder
+// packets but must not drop them.
+class transport
+{
+public:
+    virtual ~transport() = default;
+
+    virtual void send(const input_packet &packet) = 0;
+
+    // Takes the next packet that has arrived, if any. Never blocks.
+    virtual bool receive(input_packet &out) = 0;
+};
+
+//
+// In-process link between two peers that delays each packet by `delay` host frames
+// plus a random 0..`jitter`, so packets can also arrive out of order. The same seed
+// gives the same delivery schedule. `tick()` advances the link by one host frame.
+//
+class loopback_link
+{
+public:
+    loopback_link(uint32_t delay, uint32_t jitter, uint32_t seed = 1U);
+
+    loopback_link(const loopback_link &)            = delete;
+    loopback_link &operator=(const loopback_link &) = delete;
+
+    // Transport for peer 0 or 1; it sends to and receives from the other one.
+    transport &endpoint(std::size_t peer) { return endpoints_[peer]; }
+
+    void tick() { ++now_; }
+
+private:
+    struct in_flight
+    {
+        input_packet packet;
+        uint64_t     arrival;
+    };
+
+    class end : public transport
+    {
+    public:
+        end(loopback_link &link, std::size_t peer) : link_(link), peer_(peer) {}
+
+        void send(const input_packet &packet) override;
+        bool receive(input_packet &out) override;
+
+    private:
+        loopback_link &link_;
+        std::size_t    peer_;
+    };
+
+    uint32_t                                delay_;
+    std::uniform_int_distribution<uint32_t> jitter_;
+    std::minstd_rand                        random_;
+    uint64_t                                now_ = 0U;
+    std::deque<in_flight>                   queues_[2];
+    end                                     endpoints_[2];
+};
+
+class rollback_session
+{
+public:
+    // `local_port` is the controller this peer drives; the other one is remote.
+    rollback_session(console &c, transport &link, std::size_t local_port,
+                     uint32_t max_rollback);
+
+    // Runs one frame with `held` on the local port, first rolling back if remote input
+    // has contradicted a prediction. Returns false without running anything when the
+    // remote peer is `max_rollback` frames behind; call again next host frame.
+    bool advance(uint8_t held);
+
+    // Frames run so far, and how many of them have confirmed remote input.
+    uint64_t frame() const { return frame_; }
+    uint64_t confirmed_frames() const { return confirmed_; }
+
+    uint64_t rollbacks() const { return rollbacks_; }
+    uint64_t frames_resimulated() const { return resimulated_; }
+    uint64_t stalls() const { return stalls_; }
+
+private:
+    struct frame_input
+    {
+        uint8_t  local         = 0U;
+        uint8_t  remote        = 0U;
+        uint64_t confirmed_for = UINT64_MAX;  // Frame whose remote input is in `remote`.
+    };
+
+    frame_input &input_at(const uint64_t frame) { return inputs_[frame % inputs_.size()]; }
+
+    // Drains the transport and returns the oldest frame whose prediction was wrong,
+    // or `frame_` if none was.
+    uint64_t receive();
+
+    void run(uint64_t frame);
+
+    console                       &console_;
+    transport                     &link_;
+    std::size_t                    local_port_;
+    uint32_t                       max_rollback_;
+    std::vector<console::snapshot> snapshots_;
+    std::vector<frame_input>       inputs_;
+
+    uint64_t frame_       = 0U;
+    uint64_t confirmed_   = 0U;
+    uint8_t  last_remote_ = 0U;
+
+    uint64_t rollbacks_   = 0U;
+    uint64_t resimulated_ = 0U;
+    uint64_t stalls_      = 0U;
+};
+
+} // namespace nes
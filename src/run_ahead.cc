@@ -0,0 +1,56 @@
+#include "run_ahead.hh"
+
+#include <chrono>
+
+namespace nes
+{
+
+run_ahead::run_ahead(console &c, const uint32_t frames)
+    : console_(c),
+      frames_(frames),
+      snapshot_(std::make_unique<console::snapshot>())
+{
+}
+
+const ppu::frame &run_ahead::advance(const movie::input &held)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    for(std::size_t port = 0U; port < movie::PORTS; ++port)
+    {
+        console_.set_input(port, held[port]);
+    }
+
+    if(frames_ == 0U)
+    {
+        console_.run_frame();
+    }
+    else
+    {
+        // The real frame: heard, never seen.
+        console_.set_rendering(false);
+        console_.run_frame();
+        console_.save(*snapshot_);
+
+        // Speculative frames: only the last one is seen, none are heard or saved.
+        console_.set_audio(false);
+        console_.set_speculative(true);
+        for(uint32_t i = 1U; i < frames_; ++i)
+        {
+            console_.run_frame();
+        }
+        console_.set_rendering(true);
+        console_.run_frame();
+
+        console_.restore(*snapshot_);
+        console_.set_audio(true);
+        console_.set_speculative(false);
+    }
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    last_seconds_ = elapsed.count();
+
+    return console_.latest_frame();
+}
+
+} // namespace nes
@@ -0,0 +1,42 @@
+#include "console.hh"
+#include "movie.hh"
+
+#include <cstdint>
+#include <memory>
+
+#pragma once
+
+//
+// Run-ahead input latency reduction.
+//
+// Each host frame runs the real frame with audio but no drawing, saves the console,
+// runs `frames` more frames with the same input (drawing only the last) and presents
+// that one, then restores. The player sees the result of their input `frames` frames
+// sooner than the game would show it, at the cost of `frames + 1` emulated frames per
+// host frame, only one of which is drawn.
+//
+
+namespace nes
+{
+
+class run_ahead
+{
+public:
+    run_ahead(console &c, uint32_t frames);
+
+    // Advances one real frame with `held` and returns the frame to present.
+    const ppu::frame &advance(const movie::input &held);
+
+    uint32_t frames() const { return frames_; }
+
+    // Wall-clock time the last `advance()` took, to check it fits the frame budget.
+    double last_seconds() const { return last_seconds_; }
+
+private:
+    console                           &console_;
+    uint32_t                           frames_;
+    std::unique_ptr<console::snapshot> snapshot_;
+    double                             last_seconds_ = 0.0;
+};
+
+} // namespace nes
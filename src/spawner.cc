@@ -0,0 +1,210 @@
+#include "spawner.hh"
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace nes
+{
+
+memory_usage read_memory_usage(const pid_t pid)
+{
+    memory_usage  usage;
+    std::ifstream in("/proc/" + std::to_string(pid) + "/smaps_rollup");
+
+    // The first line describes the rolled up mapping; the rest are "Key: value kB".
+    std::string line;
+    while(std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string        key;
+        uint64_t           kib = 0U;
+        if(!(fields >> key >> kib))
+        {
+            continue;
+        }
+
+        if(key == "Rss:")
+        {
+            usage.rss_kib = kib;
+        }
+        else if(key == "Private_Clean:" || key == "Private_Dirty:")
+        {
+            usage.private_kib += kib;
+        }
+    }
+    return usage;
+}
+
+spawner::spawner(console &warmed)
+    : console_(warmed)
+{
+    if(warmed.video().threading() != ppu::pipeline::mode::INLINE)
+    {
+        throw std::invalid_argument("Only inline-mode consoles can be forked!");
+    }
+}
+
+spawner::~spawner()
+{
+    // Never leave zombies behind.
+    for(std::size_t i = 0U; i < workers_.size(); ++i)
+    {
+        collect(i);
+    }
+}
+
+std::size_t spawner::spawn(const job &work)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    // Close-on-exec, so nothing the parent execs holds a worker's pipe open.
+    int fds[2];
+    if(pipe2(fds, O_CLOEXEC) != 0)
+    {
+        throw std::runtime_error(std::string("Failed to create worker pipe: ") + std::strerror(errno));
+    }
+
+    // Buffered output would otherwise be written by both processes.
+    std::fflush(nullptr);
+
+    const std::size_t index = workers_.size();
+    const pid_t       pid   = fork();
+    if(pid < 0)
+    {
+        close(fds[0]);
+        close(fds[1]);
+        throw std::runtime_error(std::string("Failed to fork worker: ") + std::strerror(errno));
+    }
+    if(pid == 0)
+    {
+        // A fork keeps every descriptor, so drop the earlier workers' pipes as well.
+        close(fds[0]);
+        for(const worker &w : workers_)
+        {
+            if(!w.collected)
+            {
+                close(w.pipe);
+            }
+        }
+        run_worker(work, index, fds[1]);
+    }
+
+    close(fds[1]);
+    workers_.push_back({pid, fds[0], false});
+    results_.emplace_back();
+    results_.back().pid = pid;
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    last_spawn_seconds_ = elapsed.count();
+
+    return index;
+}
+
+void spawner::run_worker(const job &work, const std::size_t index, const int pipe)
+{
+    int status = 1;
+    try
+    {
+        // Workers share the parent's save file mapping; keep their writes to themselves.
+        console_.detach_battery();
+
+        report r;
+        r.value      = work(console_, index);
+        r.state_hash = console_.state_hash();
+        r.frames     = console_.frame_number();
+        r.memory     = read_memory_usage(getpid());
+
+        if(write(pipe, &r, sizeof(r)) == static_cast<ssize_t>(sizeof(r)))
+        {
+            status = 0;
+        }
+    }
+    catch(...)
+    {
+    }
+
+    // Skip the parent's atexit handlers and destructors; they are not ours to run.
+    std::fflush(nullptr);
+    _exit(status);
+}
+
+void spawner::sample_memory()
+{
+    for(std::size_t i = 0U; i < workers_.size(); ++i)
+    {
+        if(workers_[i].collected)
+        {
+            continue;
+        }
+
+        const memory_usage now  = read_memory_usage(workers_[i].pid);
+        memory_usage      &peak = results_[i].peak_sample;
+        peak.rss_kib     = std::max(peak.rss_kib, now.rss_kib);
+        peak.private_kib = std::max(peak.private_kib, now.private_kib);
+    }
+}
+
+const std::vector<spawner::result> &spawner::wait_all()
+{
+    for(std::size_t i = 0U; i < workers_.size(); ++i)
+    {
+        collect(i);
+    }
+    return results_;
+}
+
+void spawner::collect(const std::size_t index)
+{
+    worker &w = workers_[index];
+    if(w.collected)
+    {
+        return;
+    }
+
+    report      r;
+    auto       *out      = reinterpret_cast<uint8_t *>(&r);
+    std::size_t received = 0U;
+    while(received < sizeof(r))
+    {
+        const ssize_t n = read(w.pipe, out + received, sizeof(r) - received);
+        if(n < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(n <= 0)
+        {
+            break;
+        }
+        received += static_cast<std::size_t>(n);
+    }
+    close(w.pipe);
+
+    int status = 0;
+    while(waitpid(w.pid, &status, 0) < 0 && errno == EINTR)
+    {
+    }
+    w.collected = true;
+
+    result &res = results_[index];
+    res.ok      = received == sizeof(r) && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    if(res.ok)
+    {
+        res.value        = r.value;
+        res.state_hash   = r.state_hash;
+        res.frames       = r.frames;
+        res.final_memory = r.memory;
+    }
+}
+
+} // namespace nes
@@ -0,0 +1,100 @@
+#include "console.hh"
+
+#include <sys/types.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#pragma once
+
+//
+// Copy-on-write instance spawning.
+//
+// Boot a console once, run it to an interesting point, then `spawn()` workers from it.
+// Each worker is a `fork()` of the calling process, so it starts from the warmed state
+// in microseconds and shares every page with the parent until it writes to it. The
+// job's result comes back over a pipe together with the worker's own view of its
+// memory; the parent can also sample workers' memory from /proc while they run.
+//
+// Only inline-mode consoles can be forked: a rendering thread would not exist in the
+// child. Linux only.
+//
+
+namespace nes
+{
+
+// Resident memory of one process, from /proc/<pid>/smaps_rollup.
+struct memory_usage
+{
+    uint64_t rss_kib     = 0U;  // Everything resident.
+    uint64_t private_kib = 0U;  // Pages this process no longer shares.
+};
+
+// Reads the memory of `pid`. All zero if it cannot be read, e.g. after it exited.
+memory_usage read_memory_usage(pid_t pid);
+
+class spawner
+{
+public:
+    // Runs in the worker on its private copy of the console. `worker` is the index
+    // `spawn()` returned. The return value is reported back to the parent.
+    using job = std::function<uint64_t(console &c, std::size_t worker)>;
+
+    struct result
+    {
+        pid_t        pid        = -1;
+        bool         ok         = false;  // The job returned and the worker exited cleanly.
+        uint64_t     value      = 0U;     // What the job returned.
+        uint64_t     state_hash = 0U;     // The worker's console after the job.
+        uint64_t     frames     = 0U;
+        memory_usage final_memory;        // Measured by the worker as it finished.
+        memory_usage peak_sample;         // Largest of the parent's samples.
+    };
+
+    explicit spawner(console &warmed);
+    ~spawner();
+
+    spawner(const spawner &)            = delete;
+    spawner &operator=(const spawner &) = delete;
+
+    // Forks a worker running `work` and returns its index. Throws on failure.
+    std::size_t spawn(const job &work);
+
+    // Samples the memory of every worker not yet collected.
+    void sample_memory();
+
+    // Waits for every worker and returns their results, by index.
+    const std::vector<result> &wait_all();
+
+    // Wall-clock time the last `spawn()` took in the parent.
+    double last_spawn_seconds() const { return last_spawn_seconds_; }
+
+private:
+    struct worker
+    {
+        pid_t  pid;
+        int    pipe;
+        bool   collected;
+    };
+
+    // What a worker writes to its pipe. Well under PIPE_BUF, so written atomically.
+    struct report
+    {
+        uint64_t     value;
+        uint64_t     state_hash;
+        uint64_t     frames;
+        memory_usage memory;
+    };
+
+    [[noreturn]] void run_worker(const job &work, std::size_t index, int pipe);
+    void              collect(std::size_t index);
+
+    console             &console_;
+    std::vector<worker>  workers_;
+    std::vector<result>  results_;
+    double               last_spawn_seconds_ = 0.0;
+};
+
+} // namespace nes
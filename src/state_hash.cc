@@ -0,0 +1,61 @@
+#include "state_hash.hh"
+#include "utils.hh"
+
+#include <algorithm>
+
+namespace nes
+{
+
+std::size_t page_hasher::add_region(const uint8_t *data, const std::size_t size)
+{
+    const std::size_t first = pages_.size();
+
+    for(std::size_t offset = 0U; offset < size; offset += PAGE_SIZE)
+    {
+        pages_.push_back({data + offset, std::min(PAGE_SIZE, size - offset)});
+        hashes_.push_back(0U);
+        dirty_.push_back(1U);
+    }
+
+    return first;
+}
+
+void page_hasher::invalidate()
+{
+    std::fill(dirty_.begin(), dirty_.end(), 1U);
+}
+
+uint64_t page_hasher::root()
+{
+    for(std::size_t i = 0U; i < pages_.size(); ++i)
+    {
+        if(dirty_[i] == 0U)
+        {
+            continue;
+        }
+
+        const uint64_t h = utils::hash64(pages_[i].data, pages_[i].size, i);
+        sum_      += h - hashes_[i];
+        hashes_[i] = h;
+        dirty_[i]  = 0U;
+        ++rehashed_;
+    }
+
+    return sum_;
+}
+
+void page_hasher::save(snapshot &out) const
+{
+    out.hashes = hashes_;
+    out.dirty  = dirty_;
+    out.sum    = sum_;
+}
+
+void page_hasher::restore(const snapshot &in)
+{
+    std::copy(in.hashes.begin(), in.hashes.end(), hashes_.begin());
+    std::copy(in.dirty.begin(), in.dirty.end(), dirty_.begin());
+    sum_ = in.sum;
+}
+
+} // namespace nes
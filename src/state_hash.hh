@@ -0,0 +1,69 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#pragma once
+
+//
+// Incrementally maintained hash over a set of memory regions.
+//
+// Regions are split into 256-byte pages, each with a cached hash and a dirty flag that
+// writers set. `root()` rehashes only the dirty pages and folds the change into a
+// running sum of all page hashes, so its cost follows what changed since the last
+// call rather than the size of the address space. Page hashes are seeded with the
+// page index so that identical pages in different places do not cancel out.
+//
+
+namespace nes
+{
+
+class page_hasher
+{
+public:
+    static constexpr std::size_t PAGE_SIZE = 0x100U;
+
+    // Cached page hashes and dirty flags, saved alongside the memory they describe.
+    struct snapshot
+    {
+        std::vector<uint64_t> hashes;
+        std::vector<uint8_t>  dirty;
+        uint64_t              sum = 0U;
+    };
+
+    // Adds `size` bytes at `data` (the last page may be partial) and returns the index
+    // of its first page. All regions must be added before dirty flags are handed out.
+    std::size_t add_region(const uint8_t *data, std::size_t size);
+
+    // Flags for consecutive pages starting at `first_page`. Writers set them non-zero.
+    uint8_t *dirty_flags(const std::size_t first_page) { return &dirty_[first_page]; }
+    void     mark_dirty(const std::size_t page) { dirty_[page] = 1U; }
+
+    // Marks every page dirty, e.g. after the memory was replaced wholesale.
+    void invalidate();
+
+    // Combined hash of every page.
+    uint64_t root();
+
+    // Restoring reuses the existing flag storage, so handed out flags stay valid.
+    void save(snapshot &out) const;
+    void restore(const snapshot &in);
+
+    std::size_t page_count() const { return pages_.size(); }
+    uint64_t    pages_rehashed() const { return rehashed_; }
+
+private:
+    struct page
+    {
+        const uint8_t *data;
+        std::size_t    size;
+    };
+
+    std::vector<page>     pages_;
+    std::vector<uint64_t> hashes_;
+    std::vector<uint8_t>  dirty_;
+
+    uint64_t sum_      = 0U;
+    uint64_t rehashed_ = 0U;
+};
+
+} // namespace nes
@@ -0,0 +1,214 @@
+#include <catch2/catch.hpp>
+
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../interpreter.hh"
+#include "test_rom.hh"
+
+#include <initializer_list>
+#include <vector>
+
+namespace
+{
+
+constexpr uint16_t PROGRAM_START = 0x0200U;
+
+struct bus_access
+{
+    uint16_t address;
+    uint8_t  value;
+    bool     write;
+    uint64_t cycle;
+
+    bool operator==(const bus_access &other) const
+    {
+        return address == other.address && value == other.value && write == other.write && cycle == other.cycle;
+    }
+};
+
+// Flat 64 KiB of RAM that logs every access with the cycle it was made on.
+struct recording_bus
+{
+    cpu::memory             mem{};
+    const cpu::state       *s = nullptr;
+    std::vector<bus_access> log;
+
+    uint8_t read(const uint16_t address)
+    {
+        log.push_back({address, mem[address], false, s->cycles});
+        return mem[address];
+    }
+
+    void write(const uint16_t address, const uint8_t value)
+    {
+        log.push_back({address, value, true, s->cycles});
+        mem[address] = value;
+    }
+};
+
+struct machine
+{
+    recording_bus bus;
+    cpu::state    s;
+
+    explicit machine(const std::initializer_list<uint8_t> program = {})
+    {
+        for(std::size_t i = 0U; i < bus.mem.size(); ++i)
+        {
+            bus.mem[i] = static_cast<uint8_t>((i * 37U) + 11U);
+        }
+        std::copy(program.begin(), program.end(), bus.mem.begin() + PROGRAM_START);
+        bus.s = &s;
+        s.pc  = PROGRAM_START;
+        s.sp  = 0xFDU;
+    }
+
+    template<typename Accuracy>
+    uint32_t step()
+    {
+        bus.log.clear();
+        return cpu::step<Accuracy>(bus, s);
+    }
+};
+
+// Opcodes that skip their operand without touching memory.
+bool skips_operand(const uint8_t opcode)
+{
+    for(const uint8_t skipped : {0x0B, 0x2B, 0x4B, 0x6B, 0x8B, 0xAB, 0xCB, 0x93, 0x9B, 0x9C, 0x9E, 0x9F, 0xBB})
+    {
+        if(opcode == skipped)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+TEST_CASE("Accuracy: Exact makes one access per cycle with the same results", "[accuracy]")
+{
+    for(unsigned opcode = 0U; opcode < 0x100U; ++opcode)
+    {
+        // X and Y chosen so indexing crosses a page for some operands and not others;
+        // the two status values take each branch both ways.
+        for(const uint8_t status : {0x00, 0xC3})
+        {
+            machine fast({static_cast<uint8_t>(opcode)});
+            fast.s.reg_a = 0x5AU;
+            fast.s.reg_x = 0x81U;
+            fast.s.reg_y = 0x17U;
+            fast.s.status.from_byte(status);
+            machine exact = fast;
+            exact.bus.s   = &exact.s;
+
+            const uint32_t fast_cycles  = fast.step<cpu::accuracy::fast>();
+            const uint32_t exact_cycles = exact.step<cpu::accuracy::exact>();
+
+            INFO("Opcode " << opcode << ", status " << static_cast<unsigned>(status));
+            REQUIRE(exact_cycles == fast_cycles);
+            REQUIRE(exact.s.cycles == fast.s.cycles);
+            REQUIRE(exact.s.pc == fast.s.pc);
+            REQUIRE(exact.s.sp == fast.s.sp);
+            REQUIRE(exact.s.reg_a == fast.s.reg_a);
+            REQUIRE(exact.s.reg_x == fast.s.reg_x);
+            REQUIRE(exact.s.reg_y == fast.s.reg_y);
+            REQUIRE(exact.s.status.to_byte() == fast.s.status.to_byte());
+            REQUIRE(exact.bus.mem == fast.bus.mem);
+
+            if(!skips_operand(static_cast<uint8_t>(opcode)))
+            {
+                REQUIRE(exact.bus.log.size() == exact_cycles);
+                for(std::size_t i = 0U; i < exact.bus.log.size(); ++i)
+                {
+                    REQUIRE(exact.bus.log[i].cycle == i);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Accuracy: Exact issues dummy reads and double writes", "[accuracy]")
+{
+    SECTION("Indexed read crossing a page")
+    {
+        machine m({0xBD, 0xF0, 0x20});  // LDA $20F0,X
+        m.s.reg_x = 0x20U;
+        m.step<cpu::accuracy::exact>();
+
+        REQUIRE(m.bus.log.size() == 5U);
+        REQUIRE(m.bus.log[3].address == 0x2010U);
+        REQUIRE(m.bus.log[4].address == 0x2110U);
+        REQUIRE(m.s.reg_a == m.bus.mem[0x2110U]);
+    }
+
+    SECTION("Indexed store without crossing")
+    {
+        machine m({0x9D, 0x00, 0x20});  // STA $2000,X
+        m.s.reg_x = 0x05U;
+        m.step<cpu::accuracy::exact>();
+
+        REQUIRE(m.bus.log.size() == 5U);
+        REQUIRE(m.bus.log[3] == bus_access{0x2005U, m.bus.log[3].value, false, 3U});
+        REQUIRE(m.bus.log[4] == bus_access{0x2005U, m.s.reg_a, true, 4U});
+    }
+
+    SECTION("Read-modify-write")
+    {
+        machine m({0xE6, 0x10});  // INC $10
+        m.bus.mem[0x10U] = 0x41U;
+        m.step<cpu::accuracy::exact>();
+
+        REQUIRE(m.bus.log.size() == 5U);
+        REQUIRE(m.bus.log[2] == bus_access{0x0010U, 0x41U, false, 2U});
+        REQUIRE(m.bus.log[3] == bus_access{0x0010U, 0x41U, true, 3U});
+        REQUIRE(m.bus.log[4] == bus_access{0x0010U, 0x42U, true, 4U});
+    }
+
+    SECTION("Fast makes only the data accesses")
+    {
+        machine m({0xE6, 0x10});  // INC $10
+        m.step<cpu::accuracy::fast>();
+
+        REQUIRE(m.bus.log.size() == 4U);
+        REQUIRE(m.bus.log[3].cycle == 0U);
+        REQUIRE(m.s.cycles == 5U);
+    }
+}
+
+TEST_CASE("Accuracy: Exact interrupts take one access per cycle", "[accuracy]")
+{
+    machine fast;
+    machine exact;
+    exact.bus.s = &exact.s;
+
+    cpu::interrupt<cpu::accuracy::fast>(fast.bus, fast.s, cpu::NMI_VECTOR);
+    cpu::interrupt<cpu::accuracy::exact>(exact.bus, exact.s, cpu::NMI_VECTOR);
+
+    REQUIRE(exact.bus.log.size() == 7U);
+    REQUIRE(exact.s.cycles == 7U);
+    REQUIRE(exact.s.pc == fast.s.pc);
+    REQUIRE(exact.bus.mem == fast.bus.mem);
+}
+
+TEST_CASE("Accuracy: Consoles run the test ROM in either mode", "[accuracy]")
+{
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image());
+    nes::console         fast(cart);
+    nes::console         exact(cart);
+    exact.set_accuracy(nes::accuracy::EXACT);
+    REQUIRE(exact.get_accuracy() == nes::accuracy::EXACT);
+
+    for(int i = 0; i < 10; ++i)
+    {
+        fast.set_input(0U, static_cast<uint8_t>(i));
+        exact.set_input(0U, static_cast<uint8_t>(i));
+        fast.run_frame();
+        exact.run_frame();
+    }
+
+    // The same NMIs and input sums; only the cycles I/O lands on differ.
+    REQUIRE(exact.ram()[0x11U] == fast.ram()[0x11U]);
+    REQUIRE(exact.ram()[0x12U] == fast.ram()[0x12U]);
+    REQUIRE(exact.ram()[0x12U] > 0U);
+}
@@ -3,6 +3,9 @@
 
 #include "../cpu.hh"
 
+// These cover the deprecated `cpu::address` functions for as long as they remain.
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+
 namespace testing
 {
     // No-Op operation for testing addressing.
@@ -0,0 +1,182 @@
+#include <catch2/catch.hpp>
+
+#include "../apu.hh"
+#include "../blip_buffer.hh"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace
+{
+
+// Drains everything currently published by `apu`.
+std::vector<int16_t> collect(apu::processor &apu)
+{
+    std::vector<int16_t> samples;
+    int16_t              sample;
+
+    while(apu.output().try_pop(sample))
+    {
+        samples.push_back(sample);
+    }
+
+    return samples;
+}
+
+// Counts rising zero crossings.
+size_t count_cycles(const std::vector<int16_t> &samples)
+{
+    size_t crossings = 0U;
+    for(size_t i = 1U; i < samples.size(); ++i)
+    {
+        crossings += (samples[i - 1U] < 0 && samples[i] >= 0) ? 1U : 0U;
+    }
+
+    return crossings;
+}
+
+} // namespace
+
+TEST_CASE("APU: Blip buffer reconstructs a step", "[apu]")
+{
+    apu::blip_buffer blip(apu::CPU_CLOCK_RATE, apu::SAMPLE_RATE, 4096U);
+
+    blip.add_delta(1000U, 0.5F);
+    blip.end_frame(20000U);
+
+    std::vector<int16_t> samples(blip.samples_available());
+    REQUIRE(samples.size() == static_cast<size_t>(std::floor(20000.0 * apu::SAMPLE_RATE / apu::CPU_CLOCK_RATE)));
+    blip.read_samples(samples.data(), samples.size());
+
+    // Silent before the step, then settles near the step height (minus the slow DC blocker).
+    REQUIRE(samples[0] == 0);
+    REQUIRE(samples[40] > 14000);
+    REQUIRE(samples[40] <= 15000);
+}
+
+TEST_CASE("APU: Pulse channel pitch", "[apu]")
+{
+    apu::processor apu;
+
+    // 50% duty, constant volume 15, period 253 -> 1789773 / (16 * 254) = 440.4 Hz.
+    apu.write(0x4015, 0x01, 0U);
+    apu.write(0x4000, 0xBF, 0U);
+    apu.write(0x4002, 0xFD, 0U);
+    apu.write(0x4003, 0x08, 0U);  // Length index 1 (254 half-frames), period high 0.
+
+    apu.flush(apu::CPU_CLOCK_RATE / 2U);
+    const auto samples = collect(apu);
+
+    REQUIRE(samples.size() >= (apu::SAMPLE_RATE / 2U) - 1U);
+    REQUIRE(samples.size() <= (apu::SAMPLE_RATE / 2U) + 1U);
+    REQUIRE(count_cycles(samples) >= 218U);
+    REQUIRE(count_cycles(samples) <= 222U);
+    REQUIRE(apu.dropped_samples() == 0U);
+}
+
+TEST_CASE("APU: Length counters and frame IRQ", "[apu]")
+{
+    apu::processor apu;
+
+    apu.write(0x4015, 0x0F, 0U);
+    apu.write(0x4003, 0x18, 0U);  // Pulse 1, length index 3 -> 2 half-frames.
+    apu.write(0x400F, 0x08, 0U);  // Noise, length 254.
+
+    REQUIRE((apu.read_status(10U) & 0x09) == 0x09);
+
+    // Two half-frame clocks (one 4-step sequence) run the short counter out.
+    REQUIRE((apu.read_status(30000U) & 0x01) == 0x00);
+    REQUIRE((apu.read_status(30001U) & 0x08) == 0x08);
+
+    // The 4-step sequence raises the frame IRQ; reading $4015 clears it.
+    REQUIRE((apu.read_status(60000U) & 0x40) == 0x40);
+    REQUIRE((apu.read_status(60001U) & 0x40) == 0x00);
+
+    // Disabling a channel clears its length counter.
+    apu.write(0x4015, 0x00, 60002U);
+    REQUIRE((apu.read_status(60003U) & 0x0F) == 0x00);
+}
+
+TEST_CASE("APU: Silent noise keeps shifting", "[apu]")
+{
+    apu::processor audible;
+    apu::processor silent;
+
+    for(apu::processor *apu : {&audible, &silent})
+    {
+        apu->write(0x4015, 0x08, 0U);
+        apu->write(0x400E, 0x03, 0U);  // Period 32.
+        apu->write(0x400F, 0x08, 0U);  // Length 254.
+    }
+    audible.write(0x400C, 0x3F, 0U);  // Constant volume 15.
+    silent.write(0x400C, 0x30, 0U);   // Constant volume 0.
+
+    // Muted, the LFSR still steps with the timer.
+    audible.flush(20000U);
+    silent.flush(20000U);
+    REQUIRE(silent.get_state().noi.shift == audible.get_state().noi.shift);
+    REQUIRE(silent.get_state().noi.timer == audible.get_state().noi.timer);
+
+    // Unmuted, it carries on from the same state.
+    silent.write(0x400C, 0x3F, 20000U);
+    audible.flush(40000U);
+    silent.flush(40000U);
+    REQUIRE(silent.get_state().noi.shift == audible.get_state().noi.shift);
+    REQUIRE(silent.get_state().output == audible.get_state().output);
+}
+
+TEST_CASE("APU: DMC fetches samples through the memory reader", "[apu]")
+{
+    apu::processor        apu;
+    std::vector<uint16_t> fetched;
+
+    apu.set_memory_reader([&fetched](const uint16_t address)
+    {
+        fetched.push_back(address);
+        return uint8_t{0xFF};
+    });
+
+    apu.write(0x4010, 0x0F, 0U);  // Fastest rate, no loop.
+    apu.write(0x4012, 0x00, 0U);  // $C000
+    apu.write(0x4013, 0x01, 0U);  // 17 bytes
+    apu.write(0x4015, 0x10, 0U);
+    apu.flush(20000U);
+
+    REQUIRE(fetched.size() == 17U);
+    REQUIRE(fetched.front() == 0xC000);
+    REQUIRE(fetched.back() == 0xC010);
+    REQUIRE(apu.get_state().dm.level > 0U);
+}
+
+TEST_CASE("APU: WAV output", "[apu]")
+{
+    const std::string path = "test_apu_output.wav";
+    {
+        apu::processor    apu;
+        utils::wav_writer wav(path, apu::SAMPLE_RATE);
+
+        apu.write(0x4015, 0x04, 0U);
+        apu.write(0x4008, 0xFF, 0U);
+        apu.write(0x400A, 0x80, 0U);
+        apu.write(0x400B, 0x08, 0U);
+        apu.flush(apu::CPU_CLOCK_RATE / 10U);
+
+        const size_t drained = apu::drain(apu.output(), wav);
+        REQUIRE(drained == wav.samples_written());
+        REQUIRE(wav.samples_written() > 4000U);
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> bytes{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    std::remove(path.c_str());
+
+    REQUIRE(bytes.size() > 44U);
+    REQUIRE(std::string(bytes.data(), 4U) == "RIFF");
+    REQUIRE(std::string(bytes.data() + 8U, 4U) == "WAVE");
+
+    const uint32_t data_size = static_cast<uint8_t>(bytes[40]) | (static_cast<uint8_t>(bytes[41]) << 8U)
+                               | (static_cast<uint8_t>(bytes[42]) << 16U) | (static_cast<uint8_t>(bytes[43]) << 24U);
+    REQUIRE(data_size == bytes.size() - 44U);
+}
@@ -0,0 +1,165 @@
+#include <catch2/catch.hpp>
+
+#include "../assembler.hh"
+#include "test_rom.hh"
+
+#include <stdexcept>
+#include <string_view>
+
+namespace asm6502 = cpu::assembler;
+
+namespace
+{
+
+// test_rom::PROGRAM, from source.
+constexpr auto TEST_ROM = asm6502::assemble([]() { return R"(
+        .org $8000
+reset:  sei
+        cld
+        ldx #$FF
+        txs
+        lda #$80
+        sta $2000
+        lda #$08
+        sta $2001
+loop:   inc $20
+        jmp loop
+
+nmi:    lda #$01        ; Strobe the controllers.
+        sta $4016
+        lda #$00
+        sta $4016
+        ldx #$08
+read:   lda $4016
+        lsr a
+        rol $10
+        dex
+        bne read
+        ldx #$08
+read_2: lda $4017
+        lsr
+        rol $13
+        dex
+        bne read_2
+        lda $10
+        eor $13
+        clc
+        adc $11
+        sta $11
+        inc $12
+        lda #>$3F00
+        sta $2006
+        lda #<$3F00
+        sta $2006
+        lda $11
+        and #%00111111
+        sta $2007
+        lda #0
+        sta $2005
+        sta $2005
+        rti
+irq:    rti
+)"; });
+
+static_assert(TEST_ROM.size() == test_rom::PROGRAM.size(), "Assembled at compile time");
+
+} // namespace
+
+TEST_CASE("Assembler: Assembles the test ROM at compile time", "[assembler]")
+{
+    REQUIRE(TEST_ROM == test_rom::PROGRAM);
+}
+
+TEST_CASE("Assembler: Every addressing mode", "[assembler]")
+{
+    constexpr auto program = asm6502::assemble([]() { return R"(
+        .org $C000
+        asl a
+        asl
+        lda #'A'
+        lda $12
+        lda $12,x
+        ldx $12,Y
+        lda $1234
+        lda 300
+        lda $0012,X
+        lda $1234,y
+        stx $12,y
+        sty $12,X
+        jmp ($1234)
+        lda ($12,x)
+        lda ( $12 ), y
+        jsr target
+target: rts
+    )"; });
+
+    constexpr std::array<uint8_t, 37U> expected = {
+        0x0A,             // ASL A
+        0x0A,             // ASL A
+        0xA9, 0x41,       // LDA #'A'
+        0xA5, 0x12,       // LDA $12
+        0xB5, 0x12,       // LDA $12,X
+        0xB6, 0x12,       // LDX $12,Y
+        0xAD, 0x34, 0x12, // LDA $1234
+        0xAD, 0x2C, 0x01, // LDA 300
+        0xBD, 0x12, 0x00, // LDA $0012,X
+        0xB9, 0x34, 0x12, // LDA $1234,Y
+        0x96, 0x12,       // STX $12,Y
+        0x94, 0x12,       // STY $12,X
+        0x6C, 0x34, 0x12, // JMP ($1234)
+        0xA1, 0x12,       // LDA ($12,X)
+        0xB1, 0x12,       // LDA ($12),Y
+        0x20, 0x24, 0xC0, // JSR target
+        0x60};            // RTS
+    REQUIRE(program == expected);
+}
+
+TEST_CASE("Assembler: Branches resolve forward and backward", "[assembler]")
+{
+    constexpr auto program = asm6502::assemble([]() { return R"(
+        .org $8000
+back:   beq forward
+        nop
+forward:
+        bne back
+        bcc *
+    )"; });
+
+    constexpr std::array<uint8_t, 7U> expected = {0xF0, 0x01, 0xEA, 0xD0, 0xFB, 0x90, 0xFE};
+    REQUIRE(program == expected);
+}
+
+TEST_CASE("Assembler: Data directives and padding", "[assembler]")
+{
+    constexpr auto program = asm6502::assemble([]() { return R"(
+        .org $FFF0
+start:  .byte "Hi;\n", 0, <start, >start
+        .word start
+        .org $FFFA
+        .word start+1, start, start-$10
+    )"; });
+
+    constexpr std::array<uint8_t, 16U> expected = {'H',  'i',  ';',  '\n', 0x00, 0xF0, 0xFF, 0xF0,
+                                                   0xFF, 0x00, 0xF1, 0xFF,  0xF0, 0xFF, 0xE0, 0xFF};
+    REQUIRE(program == expected);
+}
+
+TEST_CASE("Assembler: Errors are reported", "[assembler]")
+{
+    REQUIRE(asm6502::assembled_size(" lda #1\n jmp later\n") == 5U);
+    REQUIRE_THROWS_AS(asm6502::assemble<2U>(" lda #1\n foo\n"), std::invalid_argument);
+    REQUIRE_THROWS_AS(asm6502::assemble<2U>(" jmp nowhere\n"), std::invalid_argument);
+    REQUIRE_THROWS_AS(asm6502::assemble<2U>(" lda #$100\n"), std::invalid_argument);
+    REQUIRE_THROWS_AS(asm6502::assemble<2U>(" stx $12,x\n"), std::invalid_argument);
+    REQUIRE_THROWS_AS(asm6502::assemble<3U>(" lda #1\n"), std::invalid_argument);
+    REQUIRE_THROWS_AS(asm6502::assemble<4U>("a: nop\na: nop\n"), std::invalid_argument);
+    REQUIRE_THROWS_AS(asm6502::assemble<2U>(" .org $10\n nop\n .org $0\n nop\n"), std::invalid_argument);
+
+    std::string far = "start: nop\n";
+    for(int i = 0; i < 130; ++i)
+    {
+        far += " nop\n";
+    }
+    far += " bne start\n";
+    REQUIRE_THROWS_AS(asm6502::assemble<133U>(far), std::invalid_argument);
+}
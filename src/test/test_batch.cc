@@ -0,0 +1,105 @@
+#include <catch2/catch.hpp>
+
+#include "../batch.hh"
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../nes_emu.h"
+#include "test_rom.hh"
+
+#include <cstring>
+#include <vector>
+
+namespace
+{
+
+constexpr std::size_t INSTANCES = 5U;
+
+uint8_t action_for(const std::size_t instance, const int step)
+{
+    return static_cast<uint8_t>((instance + 1U) * 29U + static_cast<unsigned>(step) * 3U);
+}
+
+} // namespace
+
+TEST_CASE("Batch: Parallel steps match consoles run one by one", "[batch]")
+{
+    constexpr uint32_t FRAMES_PER_STEP = 3U;
+    constexpr int      STEPS           = 6;
+
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image());
+
+    nes::batch b(cart, INSTANCES, 3U);
+    REQUIRE(b.size() == INSTANCES);
+    REQUIRE(b.threads() == 3U);
+
+    std::vector<uint8_t> observations(INSTANCES * nes::batch::OBSERVATION_SIZE);
+    uint8_t              actions[INSTANCES];
+    for(int s = 0; s < STEPS; ++s)
+    {
+        for(std::size_t i = 0U; i < INSTANCES; ++i)
+        {
+            actions[i] = action_for(i, s);
+        }
+        b.step(actions, FRAMES_PER_STEP, observations.data());
+    }
+
+    for(std::size_t i = 0U; i < INSTANCES; ++i)
+    {
+        nes::console reference(cart);
+        for(int s = 0; s < STEPS; ++s)
+        {
+            reference.set_input(0U, action_for(i, s));
+            for(uint32_t f = 0U; f < FRAMES_PER_STEP; ++f)
+            {
+                reference.run_frame();
+            }
+        }
+
+        REQUIRE(b.instance(i).state_hash() == reference.state_hash());
+        REQUIRE(std::memcmp(b.ram(i), reference.ram().data(), nes::RAM_SIZE) == 0);
+
+        const uint8_t *expected = reference.latest_frame().pixels.data();
+        const uint8_t *observed = observations.data() + i * nes::batch::OBSERVATION_SIZE;
+        REQUIRE(std::memcmp(observed, expected, nes::batch::OBSERVATION_SIZE) == 0);
+        REQUIRE(std::memcmp(b.framebuffer(i), expected, nes::batch::OBSERVATION_SIZE) == 0);
+    }
+}
+
+TEST_CASE("Batch: C interface", "[batch]")
+{
+    const std::vector<uint8_t> rom = test_rom::make_image();
+
+    nes_batch *batch = nes_create_batch(INSTANCES, rom.data(), rom.size(), 0U);
+    REQUIRE(batch != nullptr);
+    REQUIRE(nes_batch_size(batch) == INSTANCES);
+
+    std::vector<uint8_t> observations(INSTANCES * NES_SCREEN_HEIGHT * NES_SCREEN_WIDTH);
+    const uint8_t        actions[INSTANCES] = {NES_BUTTON_A, NES_BUTTON_B, NES_BUTTON_START,
+                                               NES_BUTTON_UP, NES_BUTTON_RIGHT};
+    REQUIRE(nes_step_batch(batch, actions, 3U, observations.data()) == 0);
+
+    // The NMI handler keeps a running sum of the buttons in $11, so each instance's RAM
+    // follows its own action.
+    for(uint32_t i = 0U; i < INSTANCES; ++i)
+    {
+        const uint8_t *ram = nes_ram(batch, i);
+        REQUIRE(ram != nullptr);
+        REQUIRE(ram[0x12] == 3U);
+        REQUIRE(ram[0x11] != 0U);
+        if(i > 0U)
+        {
+            REQUIRE(ram[0x11] != nes_ram(batch, 0U)[0x11]);
+        }
+        REQUIRE(std::memcmp(nes_framebuffer(batch, i),
+                            observations.data() + i * NES_SCREEN_HEIGHT * NES_SCREEN_WIDTH,
+                            NES_SCREEN_HEIGHT * NES_SCREEN_WIDTH) == 0);
+    }
+
+    REQUIRE(nes_ram(batch, INSTANCES) == nullptr);
+    REQUIRE(std::strlen(nes_last_error()) > 0U);
+    nes_destroy_batch(batch);
+
+    const uint8_t garbage[4] = {1U, 2U, 3U, 4U};
+    REQUIRE(nes_create_batch(1U, garbage, sizeof(garbage), 0U) == nullptr);
+    REQUIRE(std::string(nes_last_error()) == "Not an iNES image!");
+}
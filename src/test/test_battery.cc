@@ -0,0 +1,147 @@
+#include <catch2/catch.hpp>
+
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../run_ahead.hh"
+#include "../utils.hh"
+#include "test_rom.hh"
+
+#include <unistd.h>
+
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <string>
+
+namespace
+{
+
+constexpr uint16_t NMI_ADDRESS = 0x8009U;
+constexpr uint16_t IRQ_ADDRESS = 0x800DU;
+
+// Counts NMIs in PRG-RAM at $6000.
+constexpr std::array<uint8_t, 0x0EU> SAVING_PROGRAM = {
+    // reset:
+    0x78,              // SEI
+    0xA9, 0x80,        // LDA #$80
+    0x8D, 0x00, 0x20,  // STA $2000
+    // loop:
+    0x4C, 0x06, 0x80,  // JMP loop
+    // nmi:
+    0xEE, 0x00, 0x60,  // INC $6000
+    0x40,              // RTI
+    // irq:
+    0x40};             // RTI
+
+template<std::size_t N>
+nes::cartridge battery_cartridge(const std::array<uint8_t, N> &program, const uint16_t nmi, const uint16_t irq)
+{
+    std::vector<uint8_t> image = test_rom::make_image(program, test_rom::RESET_ADDRESS, nmi, irq);
+    image[6] |= 0x02U;  // Battery.
+    return nes::load_ines(image);
+}
+
+nes::cartridge saving_cartridge()
+{
+    return battery_cartridge(SAVING_PROGRAM, NMI_ADDRESS, IRQ_ADDRESS);
+}
+
+// A save file path, removed again at the end of the test.
+struct scratch_file
+{
+    std::string path = "/tmp/nes-emu-battery-" + std::to_string(getpid()) + ".sav";
+
+    ~scratch_file() { std::remove(path.c_str()); }
+};
+
+} // namespace
+
+TEST_CASE("Battery: PRG-RAM persists through the save file", "[battery]")
+{
+    const scratch_file   save;
+    const nes::cartridge cart = saving_cartridge();
+    REQUIRE(cart.battery);
+
+    {
+        nes::console backed(cart, ppu::pipeline::mode::INLINE, save.path);
+        nes::console plain(cart);
+        REQUIRE(backed.battery() != nullptr);
+        REQUIRE(plain.battery() == nullptr);
+
+        for(int i = 0; i < 10; ++i)
+        {
+            backed.run_frame();
+            plain.run_frame();
+            REQUIRE(backed.state_hash() == plain.state_hash());
+        }
+        REQUIRE(backed.prg_ram()[0] == 10U);
+
+        // One flush per frame that wrote PRG-RAM, and the file is current after each.
+        REQUIRE(backed.battery()->flushes() == 10U);
+
+        const std::vector<uint8_t> contents = utils::read_file(save.path);
+        REQUIRE(contents.size() == nes::PRG_RAM_SIZE);
+        REQUIRE(contents[0] == 10U);
+    }
+
+    nes::console resumed(cart, ppu::pipeline::mode::INLINE, save.path);
+    REQUIRE(resumed.prg_ram()[0] == 10U);
+    test_rom::run_frames(resumed, 5);
+    REQUIRE(utils::read_file(save.path)[0] == 15U);
+}
+
+TEST_CASE("Battery: Frames that leave PRG-RAM alone do not flush", "[battery]")
+{
+    const scratch_file save;
+
+    nes::console c(battery_cartridge(test_rom::PROGRAM, test_rom::NMI_ADDRESS, test_rom::IRQ_ADDRESS),
+                   ppu::pipeline::mode::INLINE, save.path);
+    test_rom::run_frames(c, 10);
+    REQUIRE(c.battery()->flushes() == 0U);
+
+    // Restoring identical contents is not a change either.
+    auto snapshot = std::make_unique<nes::console::snapshot>();
+    c.save(*snapshot);
+    c.restore(*snapshot);
+    test_rom::run_frames(c, 1);
+    REQUIRE(c.battery()->flushes() == 0U);
+}
+
+TEST_CASE("Battery: Speculative frames are not flushed", "[battery]")
+{
+    const scratch_file save;
+
+    nes::console   c(saving_cartridge(), ppu::pipeline::mode::INLINE, save.path);
+    nes::run_ahead ahead(c, 2U);
+    for(int i = 0; i < 10; ++i)
+    {
+        ahead.advance({0x00U, 0x00U});
+    }
+
+    // Only the real frames were committed; the frames run ahead were restored over.
+    REQUIRE(c.prg_ram()[0] == 10U);
+    REQUIRE(c.battery()->flushes() == 10U);
+}
+
+TEST_CASE("Battery: Detached consoles keep writes to themselves", "[battery]")
+{
+    const scratch_file   save;
+    const nes::cartridge cart = saving_cartridge();
+
+    nes::console c(cart, ppu::pipeline::mode::INLINE, save.path);
+    test_rom::run_frames(c, 3);
+    const uint8_t *before = c.prg_ram();
+
+    c.detach_battery();
+    REQUIRE(c.battery()->is_private());
+    REQUIRE(c.prg_ram() == before);
+    REQUIRE(c.prg_ram()[0] == 3U);
+
+    test_rom::run_frames(c, 4);
+    REQUIRE(c.prg_ram()[0] == 7U);
+    REQUIRE(utils::read_file(save.path)[0] == 3U);
+
+    // A cartridge without a battery ignores the save path.
+    nes::console no_battery(nes::load_ines(test_rom::make_image()), ppu::pipeline::mode::INLINE, save.path);
+    REQUIRE(no_battery.battery() == nullptr);
+}
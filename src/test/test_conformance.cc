@@ -0,0 +1,159 @@
+#include <catch2/catch.hpp>
+
+#include "../assembler.hh"
+#include "../cartridge.hh"
+#include "../conformance.hh"
+#include "test_files.hh"
+#include "test_rom.hh"
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace
+{
+
+// Counts X down from 5; PRG is mirrored, so it also runs from $C000 like nestest.
+constexpr auto COUNTDOWN = cpu::assembler::assemble([]() { return R"(
+        .org $C000
+        ldx #$05
+loop:   dex
+        bne loop
+)"; });
+
+// Its golden log, in nestest.log layout.
+const char *const COUNTDOWN_LOG =
+    "C000  A2 05     LDX #$05                        A:00 X:00 Y:00 P:24 SP:FD PPU:  0, 21 CYC:7\n"
+    "C002  CA        DEX                             A:00 X:05 Y:00 P:24 SP:FD PPU:  0, 27 CYC:9\n"
+    "C003  D0 FD     BNE $C002                       A:00 X:04 Y:00 P:24 SP:FD PPU:  0, 33 CYC:11\n"
+    "C002  CA        DEX                             A:00 X:04 Y:00 P:24 SP:FD PPU:  0, 42 CYC:14\n"
+    "C003  D0 FD     BNE $C002                       A:00 X:03 Y:00 P:24 SP:FD PPU:  0, 48 CYC:16\n"
+    "C002  CA        DEX                             A:00 X:03 Y:00 P:24 SP:FD PPU:  0, 57 CYC:19\n";
+
+// Writes the status ROM signature and message, then `status`, and spins.
+constexpr std::array<uint8_t, 0x2DU> status_program(const uint8_t status)
+{
+    return {
+        0xA9, 0xDE,        // LDA #$DE
+        0x8D, 0x01, 0x60,  // STA $6001
+        0xA9, 0xB0,        // LDA #$B0
+        0x8D, 0x02, 0x60,  // STA $6002
+        0xA9, 0x61,        // LDA #$61
+        0x8D, 0x03, 0x60,  // STA $6003
+        0xA2, 0x00,        // LDX #$00
+        // copy:
+        0xBD, 0x25, 0x80,  // LDA message,X
+        0x9D, 0x04, 0x60,  // STA $6004,X
+        0xF0, 0x04,        // BEQ done
+        0xE8,              // INX
+        0x4C, 0x11, 0x80,  // JMP copy
+        // done:
+        0xA9, status,      // LDA #status
+        0x8D, 0x00, 0x60,  // STA $6000
+        // spin:
+        0x4C, 0x22, 0x80,  // JMP spin
+        // message:
+        'P', 'a', 's', 's', 'e', 'd', '\n', 0x00};
+}
+
+nes::cartridge countdown_cart()
+{
+    return nes::load_ines(test_rom::make_image(COUNTDOWN));
+}
+
+} // namespace
+
+TEST_CASE("Conformance: Golden log lines are parsed", "[conformance]")
+{
+    nes::trace_fields fields;
+    REQUIRE(nes::parse_trace_line("C72A  A9 FF     LDA #$FF                        A:F5 X:0A Y:6E P:E5 SP:FB "
+                                  "PPU: 30,174 CYC:3440",
+                                  fields));
+    REQUIRE(fields.pc == 0xC72AU);
+    REQUIRE(fields.a == 0xF5U);
+    REQUIRE(fields.x == 0x0AU);
+    REQUIRE(fields.y == 0x6EU);
+    REQUIRE(fields.p == 0xE5U);
+    REQUIRE(fields.sp == 0xFBU);
+    REQUIRE(fields.timed);
+    REQUIRE(fields.cycles == 3440U);
+
+    // Older logs have no cycle count.
+    REQUIRE(nes::parse_trace_line("C000  4C F5 C5  JMP $C5F5  A:00 X:00 Y:00 P:24 SP:FD", fields));
+    REQUIRE_FALSE(fields.timed);
+
+    // In the original nestest.log format, CYC: is the PPU dot.
+    REQUIRE(nes::parse_trace_line("C5F5  A2 00     LDX #$00                        A:00 X:00 Y:00 P:24 SP:FD "
+                                  "CYC:  9 SL:241",
+                                  fields));
+    REQUIRE(fields.pc == 0xC5F5U);
+    REQUIRE(fields.sp == 0xFDU);
+    REQUIRE_FALSE(fields.timed);
+
+    REQUIRE_FALSE(nes::parse_trace_line("C000  4C F5 C5  JMP $C5F5  A:00 X:00 Y:00", fields));
+    REQUIRE_FALSE(nes::parse_trace_line("", fields));
+}
+
+TEST_CASE("Conformance: A matching trace passes", "[conformance]")
+{
+    std::istringstream            golden(COUNTDOWN_LOG);
+    const nes::conformance_result result = nes::run_trace(countdown_cart(), golden);
+
+    INFO(result.detail);
+    REQUIRE(result.passed);
+    REQUIRE(result.instructions == 6U);
+    REQUIRE(result.cycles == 21U);
+}
+
+TEST_CASE("Conformance: A trace fails at its first divergence", "[conformance]")
+{
+    std::string log = COUNTDOWN_LOG;
+    log.replace(log.find("X:04", log.find("C002  CA", 100U)), 4U, "X:07");
+
+    std::istringstream            golden(log);
+    const nes::conformance_result result = nes::run_trace(countdown_cart(), golden);
+
+    REQUIRE_FALSE(result.passed);
+    REQUIRE(result.instructions == 3U);
+    REQUIRE(result.detail.find("line 4") != std::string::npos);
+    REQUIRE(result.detail.find("C002  CA        A:00 X:04 Y:00 P:24 SP:FD CYC:14") != std::string::npos);
+}
+
+TEST_CASE("Conformance: Status ROMs report their result code", "[conformance]")
+{
+    const nes::conformance_result passed =
+        nes::run_status_rom(nes::load_ines(test_rom::make_image(status_program(0x00U))), 10U);
+    REQUIRE(passed.passed);
+    REQUIRE(passed.detail == "Passed");
+
+    const nes::conformance_result failed =
+        nes::run_status_rom(nes::load_ines(test_rom::make_image(status_program(0x02U))), 10U);
+    REQUIRE_FALSE(failed.passed);
+    REQUIRE(failed.detail == "Result 2: Passed");
+
+    // Never writes a status.
+    const nes::conformance_result timeout = nes::run_status_rom(countdown_cart(), 3U);
+    REQUIRE_FALSE(timeout.passed);
+    REQUIRE(timeout.detail == "No result after 3 frames");
+}
+
+TEST_CASE("Conformance: Directories are run in parallel", "[conformance]")
+{
+    const test_files::scratch_directory dir("conformance");
+    dir.write("a_trace.nes", test_rom::make_image(COUNTDOWN));
+    std::ofstream(dir.path / "a_trace.log") << COUNTDOWN_LOG;
+    dir.write("b_status.nes", test_rom::make_image(status_program(0x00U)));
+    dir.write("c_broken.nes", {'N', 'O', 'P', 'E'});
+
+    const std::vector<nes::conformance_result> results = nes::run_conformance({dir.path.string()}, 3U, 10U);
+
+    REQUIRE(results.size() == 3U);
+    REQUIRE(results[0].rom == (dir.path / "a_trace.nes").string());
+    REQUIRE(results[0].passed);
+    REQUIRE(results[0].instructions == 6U);
+    REQUIRE(results[1].passed);
+    REQUIRE_FALSE(results[2].passed);
+    REQUIRE_FALSE(results[2].detail.empty());
+}
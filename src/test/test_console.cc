@@ -0,0 +1,318 @@
+#include <catch2/catch.hpp>
+
+#include "../assembler.hh"
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../debugger.hh"
+#include "../interpreter.hh"
+#include "test_rom.hh"
+
+#include <initializer_list>
+
+namespace
+{
+
+using flags = cpu::flags;
+
+constexpr uint16_t PROGRAM_START = 0x0200U;
+
+// Flat 64 KiB of RAM.
+struct flat_bus
+{
+    cpu::memory mem{};
+
+    uint8_t read(const uint16_t address) { return mem[address]; }
+    void    write(const uint16_t address, const uint8_t value) { mem[address] = value; }
+};
+
+// CPU with `program` loaded at `PROGRAM_START`.
+struct machine
+{
+    flat_bus   bus;
+    cpu::state s;
+
+    explicit machine(const std::initializer_list<uint8_t> program)
+    {
+        std::copy(program.begin(), program.end(), bus.mem.begin() + PROGRAM_START);
+        s.pc = PROGRAM_START;
+        s.sp = 0xFDU;
+    }
+
+    uint32_t step() { return cpu::step(bus, s); }
+};
+
+// Fills RAM page $02 with 0, 1, 2..., points OAMADDR at $10 and DMAs the page to OAM.
+constexpr auto OAM_DMA_PROGRAM = cpu::assembler::assemble([]() { return R"(
+        .org $8000
+        ldx #$00
+fill:   txa
+        sta $0200,x
+        inx
+        bne fill
+        lda #$10
+        sta $2003
+        lda #$02
+        sta $4014
+done:   jmp done
+)"; });
+
+constexpr uint16_t OAM_DMA_ADDRESS = 0x8010U;  // STA $4014
+constexpr uint16_t OAM_DONE        = 0x8013U;
+
+// Runs OAM_DMA_PROGRAM up to `done`, returning the cycles the DMA instruction took.
+uint64_t run_oam_dma(nes::console &c, nes::debugger &d)
+{
+    d.add_breakpoint(OAM_DMA_ADDRESS);
+    d.add_breakpoint(OAM_DONE);
+
+    REQUIRE_FALSE(c.run_frame());
+    REQUIRE(c.cpu_state().pc == OAM_DMA_ADDRESS);
+    const uint64_t start = c.cpu_state().cycles;
+    REQUIRE(start % 2U == 0U);
+
+    REQUIRE_FALSE(c.run_frame());
+    REQUIRE(c.cpu_state().pc == OAM_DONE);
+    return c.cpu_state().cycles - start;
+}
+
+} // namespace
+
+TEST_CASE("CPU: ADC sets carry and overflow", "[cpu]")
+{
+    machine m({0xA9, 0x50,    // LDA #$50
+               0x69, 0x50,    // ADC #$50
+               0x69, 0x70});  // ADC #$70
+    m.step();
+    m.step();
+
+    REQUIRE(m.s.reg_a == 0xA0U);
+    REQUIRE(m.s.status.at(flags::OVERFLOW));
+    REQUIRE(m.s.status.at(flags::NEGATIVE));
+    REQUIRE_FALSE(m.s.status.at(flags::CARRY));
+
+    m.step();
+    REQUIRE(m.s.reg_a == 0x10U);
+    REQUIRE(m.s.status.at(flags::CARRY));
+    REQUIRE_FALSE(m.s.status.at(flags::OVERFLOW));
+}
+
+TEST_CASE("CPU: SBC borrows", "[cpu]")
+{
+    machine m({0x38,          // SEC
+               0xA9, 0x00,    // LDA #$00
+               0xE9, 0x01});  // SBC #$01
+    m.step();
+    m.step();
+    m.step();
+
+    REQUIRE(m.s.reg_a == 0xFFU);
+    REQUIRE_FALSE(m.s.status.at(flags::CARRY));
+    REQUIRE(m.s.status.at(flags::NEGATIVE));
+}
+
+TEST_CASE("CPU: Operations only touch their own flags", "[cpu]")
+{
+    machine m({0x38,          // SEC
+               0xA9, 0x00});  // LDA #$00
+    m.step();
+    m.step();
+
+    REQUIRE(m.s.status.at(flags::CARRY));
+    REQUIRE(m.s.status.at(flags::ZERO));
+}
+
+TEST_CASE("CPU: JSR and RTS", "[cpu]")
+{
+    machine m({0x20, 0x10, 0x02});  // JSR $0210
+    m.bus.mem[0x0210U] = 0x60;      // RTS
+
+    REQUIRE(m.step() == 6U);
+    REQUIRE(m.s.pc == 0x0210U);
+    REQUIRE(m.s.sp == 0xFBU);
+    REQUIRE(m.bus.mem[0x01FDU] == 0x02U);
+    REQUIRE(m.bus.mem[0x01FCU] == 0x02U);
+
+    REQUIRE(m.step() == 6U);
+    REQUIRE(m.s.pc == PROGRAM_START + 3U);
+    REQUIRE(m.s.sp == 0xFDU);
+}
+
+TEST_CASE("CPU: Branch and page-crossing cycles", "[cpu]")
+{
+    SECTION("Not taken")
+    {
+        machine m({0xD0, 0x10});  // BNE +16, Z set
+        m.s.status.at(flags::ZERO) = true;
+        REQUIRE(m.step() == 2U);
+        REQUIRE(m.s.pc == PROGRAM_START + 2U);
+    }
+
+    SECTION("Taken, same page")
+    {
+        machine m({0xD0, 0x10});
+        REQUIRE(m.step() == 3U);
+        REQUIRE(m.s.pc == PROGRAM_START + 0x12U);
+    }
+
+    SECTION("Taken, other page")
+    {
+        machine m({0xD0, 0x80});  // BNE -128
+        REQUIRE(m.step() == 4U);
+        REQUIRE(m.s.pc == PROGRAM_START + 2U - 0x80U);
+    }
+
+    SECTION("Indexed read crossing a page")
+    {
+        machine m({0xBD, 0xFF, 0x12});  // LDA $12FF,X
+        m.s.reg_x = 1U;
+        m.bus.mem[0x1300U] = 0x42U;
+        REQUIRE(m.step() == 5U);
+        REQUIRE(m.s.reg_a == 0x42U);
+    }
+
+    SECTION("Indexed store never pays for crossing")
+    {
+        machine m({0x9D, 0xFF, 0x12});  // STA $12FF,X
+        m.s.reg_x = 1U;
+        REQUIRE(m.step() == 5U);
+    }
+}
+
+TEST_CASE("CPU: JMP indirect wraps within the pointer's page", "[cpu]")
+{
+    machine m({0x6C, 0xFF, 0x10});  // JMP ($10FF)
+    m.bus.mem[0x10FFU] = 0x34U;
+    m.bus.mem[0x1000U] = 0x12U;
+    m.bus.mem[0x1100U] = 0x56U;
+
+    m.step();
+    REQUIRE(m.s.pc == 0x1234U);
+}
+
+TEST_CASE("CPU: PHP pushes B and bit 5, PLP ignores them", "[cpu]")
+{
+    machine m({0x08,    // PHP
+               0x28});  // PLP
+    m.s.status.at(flags::CARRY) = true;
+
+    m.step();
+    REQUIRE(m.bus.mem[0x01FDU] == 0x31U);
+
+    m.step();
+    REQUIRE(m.s.status.to_byte() == 0x21U);
+}
+
+TEST_CASE("CPU: Read-modify-write and unofficial opcodes", "[cpu]")
+{
+    machine m({0x06, 0x10,    // ASL $10
+               0xC7, 0x11,    // DCP $11
+               0xA7, 0x12});  // LAX $12
+    m.bus.mem[0x10U] = 0x81U;
+    m.bus.mem[0x11U] = 0x01U;
+    m.bus.mem[0x12U] = 0x99U;
+
+    REQUIRE(m.step() == 5U);
+    REQUIRE(m.bus.mem[0x10U] == 0x02U);
+    REQUIRE(m.s.status.at(flags::CARRY));
+
+    m.step();
+    REQUIRE(m.bus.mem[0x11U] == 0x00U);
+    REQUIRE(m.s.status.at(flags::ZERO));  // A (0) == M (0)
+
+    m.step();
+    REQUIRE(m.s.reg_a == 0x99U);
+    REQUIRE(m.s.reg_x == 0x99U);
+}
+
+TEST_CASE("Cartridge: iNES parsing", "[console]")
+{
+    auto image = test_rom::make_image();
+
+    const nes::cartridge cart = nes::load_ines(image);
+    REQUIRE(cart.prg_rom.size() == nes::PRG_BANK_SIZE);
+    REQUIRE(cart.chr.size() == nes::CHR_BANK_SIZE);
+    REQUIRE(cart.mode == ppu::mirroring::HORIZONTAL);
+
+    image[6] = 0x10U;  // Mapper 1
+    REQUIRE_THROWS_AS(nes::load_ines(image), std::runtime_error);
+
+    image[0] = 'X';
+    REQUIRE_THROWS_AS(nes::load_ines(image), std::runtime_error);
+}
+
+TEST_CASE("Console: Controllers shift out buttons", "[console]")
+{
+    nes::controller c;
+    c.buttons = nes::buttons::A | nes::buttons::START;
+
+    c.write(0x01U);
+    c.write(0x00U);
+
+    const std::array<uint8_t, 9U> expected = {1, 0, 0, 1, 0, 0, 0, 0, 1};
+    for(const uint8_t bit : expected)
+    {
+        REQUIRE(c.read() == bit);
+    }
+}
+
+TEST_CASE("Console: Boots, takes NMIs and reads input", "[console]")
+{
+    nes::console console(nes::load_ines(test_rom::make_image()));
+    REQUIRE(console.cpu_state().pc == test_rom::RESET_ADDRESS);
+
+    console.set_input(0U, nes::buttons::RIGHT | nes::buttons::A);
+    for(int i = 0; i < 3; ++i)
+    {
+        console.run_frame();
+    }
+
+    REQUIRE(console.frame_number() == 3U);
+    REQUIRE(console.cpu_state().cycles >= nes::frame_start_cycle(3U));
+    REQUIRE(console.ram()[0x12U] == 3U);    // One NMI per frame.
+    REQUIRE(console.ram()[0x10U] == 0x81U);
+    REQUIRE(console.ram()[0x11U] == 0x83U);  // 3 * 0x81, mod 256.
+
+    // The backdrop colour follows the sum written in the NMI.
+    REQUIRE(console.latest_frame().pixels[0] == (0x02U & 0x3FU));
+}
+
+TEST_CASE("Console: OAM DMA copies memory pages in bulk", "[console]")
+{
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image(OAM_DMA_PROGRAM));
+
+    for(const auto a : {nes::accuracy::FAST, nes::accuracy::EXACT})
+    {
+        nes::console c(cart);
+        c.set_accuracy(a);
+        nes::debugger  d(c);
+        const uint64_t cycles = run_oam_dma(c, d);
+
+        // The STA starts on an even cycle, so writes $4014 on an odd one: 513 cycles of
+        // DMA plus one to align.
+        REQUIRE(cycles == 5U + nes::OAM_DMA_CYCLES);
+
+        const auto &oam = c.video().shadow().oam;
+        for(std::size_t i = 0U; i < oam.size(); ++i)
+        {
+            REQUIRE(oam[(i + 0x10U) & 0xFFU] == i);
+        }
+        REQUIRE(c.video().shadow().oam_addr == 0x10U);
+
+        // A watched page is read byte by byte, and ends up the same.
+        nes::console watched(cart);
+        watched.set_accuracy(a);
+        nes::debugger watcher(watched);
+        int           reads = 0;
+        watcher.add_watchpoint(0x0200U, 0x02FFU, nes::debugger::READ, [&reads](const cpu::state &)
+                               {
+                                   ++reads;
+                                   return false;
+                               });
+
+        // Exact runs also see the dummy reads of the fill loop's STA $0200,X.
+        REQUIRE(run_oam_dma(watched, watcher) == cycles);
+        REQUIRE(reads == (a == nes::accuracy::EXACT ? 512 : 256));
+        REQUIRE(watched.video().shadow().oam == oam);
+        REQUIRE(watched.state_hash() == c.state_hash());
+    }
+}
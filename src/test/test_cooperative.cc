@@ -0,0 +1,182 @@
+#ifdef NES_COROUTINES
+
+#include <catch2/catch.hpp>
+
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../cooperative.hh"
+#include "../debugger.hh"
+#include "../replay.hh"
+#include "test_rom.hh"
+
+#include <array>
+#include <string>
+#include <vector>
+
+namespace
+{
+
+// Starts a square wave, so the two models have audio to compare.
+void start_tone(nes::console &c)
+{
+    c.audio().write(0x4015, 0x01, 0U);
+    c.audio().write(0x4000, 0xBF, 0U);
+    c.audio().write(0x4002, 0xFD, 0U);
+    c.audio().write(0x4003, 0x00, 0U);
+}
+
+// Enables the APU frame IRQ and counts IRQs in $30, acknowledging each through $4015.
+constexpr uint16_t IRQ_COUNT = 0x0030U;
+
+constexpr std::array<uint8_t, 0x13U> IRQ_PROGRAM = {
+    // reset:
+    0xA9, 0x00,        // LDA #$00
+    0x8D, 0x17, 0x40,  // STA $4017
+    0x58,              // CLI
+    // loop:
+    0xE6, 0x20,        // INC $20
+    0x4C, 0x06, 0x80,  // JMP loop
+    // irq:
+    0xE6, 0x30,        // INC $30
+    0xAD, 0x15, 0x40,  // LDA $4015
+    0x40,              // RTI
+    // nmi:
+    0x40};             // RTI
+
+std::vector<int16_t> drain_samples(nes::console &c)
+{
+    std::vector<int16_t> samples;
+    int16_t              sample = 0;
+    while(c.audio().output().try_pop(sample))
+    {
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+nes::cooperative_scheduler::task count_up(nes::cooperative_scheduler &s, std::string &log, const char name,
+                                          const uint64_t step)
+{
+    for(uint64_t time = 0U;; time += step)
+    {
+        log += name;
+        co_await s.until(time + step);
+    }
+}
+
+} // namespace
+
+TEST_CASE("Cooperative: Scheduler resumes the component furthest behind", "[cooperative]")
+{
+    nes::cooperative_scheduler s;
+    std::string                log;
+    s.add(count_up(s, log, 'a', 3U));
+    s.add(count_up(s, log, 'b', 2U));
+
+    // a at 0, 3, 6; b at 0, 2, 4, 6, with a first on ties.
+    s.run_until(7U);
+    REQUIRE(log == "abbabab");
+    REQUIRE(s.switches() == 7U);
+
+    s.run_until(7U);
+    REQUIRE(log == "abbabab");
+}
+
+TEST_CASE("Cooperative: Runs identically to the catch-up model", "[cooperative]")
+{
+    SECTION("Driven by NMIs and input, with a tone playing")
+    {
+        const nes::cartridge cart = test_rom::make_cartridge();
+        nes::console         reference(cart);
+        nes::console         cooperative(cart);
+        start_tone(reference);
+        start_tone(cooperative);
+
+        nes::cooperative_runner runner(cooperative);
+        for(int i = 0; i < 30; ++i)
+        {
+            const uint8_t held = static_cast<uint8_t>(i * 7);
+            reference.set_input(0U, held);
+            cooperative.set_input(0U, held);
+
+            reference.run_frame();
+            runner.run_frame();
+
+            REQUIRE(cooperative.frame_number() == reference.frame_number());
+            REQUIRE(cooperative.state_hash() == reference.state_hash());
+            REQUIRE(nes::frame_hash(cooperative.latest_frame()) == nes::frame_hash(reference.latest_frame()));
+        }
+
+        const std::vector<int16_t> samples = drain_samples(reference);
+        REQUIRE(samples.size() > 10000U);
+        REQUIRE(drain_samples(cooperative) == samples);
+    }
+
+    SECTION("Driven by APU frame IRQs")
+    {
+        const nes::cartridge cart =
+            nes::load_ines(test_rom::make_image(IRQ_PROGRAM, test_rom::RESET_ADDRESS, 0x8012U, 0x800BU));
+        nes::console reference(cart);
+        nes::console cooperative(cart);
+
+        nes::cooperative_runner runner(cooperative);
+        for(int i = 0; i < 30; ++i)
+        {
+            reference.run_frame();
+            runner.run_frame();
+
+            REQUIRE(cooperative.state_hash() == reference.state_hash());
+        }
+        REQUIRE(reference.ram()[IRQ_COUNT] > 10U);
+        REQUIRE(cooperative.ram()[IRQ_COUNT] == reference.ram()[IRQ_COUNT]);
+    }
+}
+
+TEST_CASE("Cooperative: Takes over from a console already running", "[cooperative]")
+{
+    const nes::cartridge cart = test_rom::make_cartridge();
+    nes::console         reference(cart);
+    nes::console         cooperative(cart);
+
+    for(int i = 0; i < 5; ++i)
+    {
+        reference.run_frame();
+        cooperative.run_frame();
+    }
+
+    nes::cooperative_runner runner(cooperative);
+    for(int i = 0; i < 5; ++i)
+    {
+        reference.run_frame();
+        runner.run_frame();
+    }
+    REQUIRE(cooperative.state_hash() == reference.state_hash());
+}
+
+TEST_CASE("Cooperative: Stops at debugger breaks and counts opcodes", "[cooperative]")
+{
+    const nes::cartridge cart = test_rom::make_cartridge();
+    nes::console         reference(cart);
+    nes::console         cooperative(cart);
+    reference.set_profiling(true);
+    cooperative.set_profiling(true);
+
+    nes::debugger d(cooperative);
+    d.add_breakpoint(test_rom::NMI_ADDRESS);
+
+    // Breaks once per frame, in the NMI handler; resuming finishes the frame.
+    nes::cooperative_runner runner(cooperative);
+    for(int i = 0; i < 5; ++i)
+    {
+        REQUIRE_FALSE(runner.run_frame());
+        REQUIRE(cooperative.cpu_state().pc == test_rom::NMI_ADDRESS);
+        REQUIRE(runner.run_frame());
+
+        reference.run_frame();
+        REQUIRE(cooperative.frame_number() == reference.frame_number());
+        REQUIRE(cooperative.state_hash() == reference.state_hash());
+    }
+    REQUIRE(*cooperative.opcode_counts() == *reference.opcode_counts());
+}
+
+#endif
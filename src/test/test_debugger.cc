@@ -0,0 +1,141 @@
+#include <catch2/catch.hpp>
+
+#include "../bus.hh"
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../debugger.hh"
+#include "test_rom.hh"
+
+#include <array>
+#include <stdexcept>
+
+namespace
+{
+
+constexpr uint16_t LOOP_ADDRESS = 0x800FU;  // INC $20
+constexpr uint16_t NMI_COUNT    = 0x0012U;
+
+// Runs `c` until `frames` frames have finished, resuming after each break. Returns
+// the number of breaks.
+int run_through(nes::console &c, const uint64_t frames)
+{
+    int breaks = 0;
+    while(c.frame_number() < frames)
+    {
+        if(!c.run_frame())
+        {
+            ++breaks;
+        }
+    }
+    return breaks;
+}
+
+} // namespace
+
+TEST_CASE("Debugger: Watched pages leave the fast path", "[debugger]")
+{
+    std::array<uint8_t, 0x200U> memory{};
+    nes::memory_map             map;
+    map.map(0x0000U, 0x0200U, memory.data(), memory.size(), nes::memory_map::access::READ_WRITE);
+
+    map.watch(0x0100U, false, true);
+    REQUIRE(map.read_page(0x0100U) == memory.data() + 0x100U);
+    REQUIRE(map.write_page(0x0100U) == nullptr);
+    REQUIRE(map.mapped_write_page(0x0100U) == memory.data() + 0x100U);
+    REQUIRE(map.write_page(0x0000U) == memory.data());
+
+    // Remapping keeps the watch; clearing it restores the page.
+    map.map(0x0000U, 0x0200U, memory.data(), memory.size(), nes::memory_map::access::READ_WRITE);
+    REQUIRE(map.write_page(0x0100U) == nullptr);
+    map.watch(0x0100U, false, false);
+    REQUIRE(map.write_page(0x0100U) == memory.data() + 0x100U);
+}
+
+TEST_CASE("Debugger: Breakpoints stop before the instruction", "[debugger]")
+{
+    const nes::cartridge cart = test_rom::make_cartridge();
+    nes::console         reference(cart);
+    nes::console         c(cart);
+    nes::debugger        d(c);
+
+    const std::size_t id = d.add_breakpoint(test_rom::NMI_ADDRESS);
+    REQUIRE_FALSE(c.run_frame());
+    REQUIRE(c.cpu_state().pc == test_rom::NMI_ADDRESS);
+    REQUIRE(c.ram()[NMI_COUNT] == 0U);
+    REQUIRE(d.last_hit().id == id);
+    REQUIRE(d.last_hit().what == nes::debugger::EXECUTE);
+    REQUIRE(d.last_hit().value == 0xA9U);  // LDA #$01
+
+    // Resuming steps over the breakpoint and finishes the frame.
+    REQUIRE(c.run_frame());
+    REQUIRE(c.frame_number() == 1U);
+
+    REQUIRE(run_through(c, 10U) == 9);
+    run_through(reference, 10U);
+    REQUIRE(c.state_hash() == reference.state_hash());
+}
+
+TEST_CASE("Debugger: Watchpoints stop after the access", "[debugger]")
+{
+    const nes::cartridge cart = test_rom::make_cartridge();
+    nes::console         reference(cart);
+    nes::console         c(cart);
+    nes::debugger        d(c);
+
+    d.add_watchpoint(NMI_COUNT, NMI_COUNT, nes::debugger::WRITE);
+    REQUIRE_FALSE(c.run_frame());
+    REQUIRE(d.last_hit().what == nes::debugger::WRITE);
+    REQUIRE(d.last_hit().address == NMI_COUNT);
+    REQUIRE(d.last_hit().value == 1U);
+    REQUIRE(c.ram()[NMI_COUNT] == 1U);
+
+    // The rest of this frame leaves the controllers alone; the next one reads them.
+    d.clear();
+    d.add_watchpoint(0x4016U, 0x4016U, nes::debugger::READ);
+    REQUIRE(c.run_frame());
+    REQUIRE_FALSE(c.run_frame());
+    REQUIRE(d.last_hit().address == 0x4016U);
+    REQUIRE(d.hits() == 2U);
+
+    d.clear();
+    run_through(c, 10U);
+    run_through(reference, 10U);
+    REQUIRE(c.state_hash() == reference.state_hash());
+}
+
+TEST_CASE("Debugger: Conditions pick which hits break", "[debugger]")
+{
+    nes::console  c(test_rom::make_cartridge());
+    nes::debugger d(c);
+
+    // X is $FF from reset until the first NMI handler counts it down to zero.
+    d.add_breakpoint(LOOP_ADDRESS, [](const cpu::state &s) { return s.reg_x == 0x00U; });
+    REQUIRE_FALSE(c.run_frame());
+    REQUIRE(c.cpu_state().pc == LOOP_ADDRESS);
+    REQUIRE(c.ram()[NMI_COUNT] == 1U);
+    REQUIRE(d.last_hit().cpu.reg_x == 0x00U);
+}
+
+TEST_CASE("Debugger: Removing watches restores normal running", "[debugger]")
+{
+    nes::console c(test_rom::make_cartridge());
+    {
+        nes::debugger     d(c);
+        const std::size_t id = d.add_watchpoint(0x0000U, 0x07FFU, nes::debugger::READ | nes::debugger::WRITE);
+
+        REQUIRE_THROWS_AS(nes::debugger(c), std::logic_error);
+        REQUIRE_THROWS_AS(d.add_watchpoint(0x0010U, 0x000FU, nes::debugger::READ), std::invalid_argument);
+        REQUIRE_THROWS_AS(d.add_watchpoint(0x0010U, 0x0010U, 0x00U), std::invalid_argument);
+
+        d.remove(id);
+        REQUIRE_THROWS_AS(d.remove(id), std::invalid_argument);
+        REQUIRE(c.run_frame());
+        REQUIRE(d.hits() == 0U);
+
+        d.add_breakpoint(LOOP_ADDRESS);
+    }
+
+    // The debugger took its breakpoint with it.
+    REQUIRE(c.run_frame());
+    nes::debugger again(c);
+}
@@ -0,0 +1,179 @@
+#include <catch2/catch.hpp>
+
+#include "../assembler.hh"
+#include "../disassembler.hh"
+#include "../utils.hh"
+#include "test_files.hh"
+
+#include <numeric>
+#include <sstream>
+#include <string>
+
+namespace disasm = cpu::disassembler;
+
+namespace
+{
+
+// One of each addressing mode, and an unofficial opcode.
+constexpr auto EVERY_MODE = cpu::assembler::assemble([]() { return R"(
+        .org $C000
+        asl a
+        lda #$41
+        lda $12
+        lda $12,x
+        ldx $12,y
+        lda $1234
+        lda $1234,x
+        lda $1234,y
+        jmp ($1234)
+        lda ($12,x)
+        lda ($12),y
+        bne *
+        beq $C000
+        .byte $A7, $12  ; LAX $12
+        rts
+)"; });
+
+// Reset counts down through a subroutine, then jumps somewhere unknown; the NMI and
+// IRQ return at once. The bytes at `data` are never run.
+constexpr auto REACHABILITY = cpu::assembler::assemble([]() { return R"(
+        .org $C000
+reset:  ldx #$00
+loop:   jsr count
+        bne loop
+        jmp ($0300)
+count:  dex
+        rts
+data:   .byte $A9, $A9, $A9
+nmi:    rti
+        .org $FFFA
+        .word nmi, reset, nmi
+)"; });
+
+std::string listing(const uint8_t *bytes, const std::size_t size, const uint16_t address)
+{
+    std::ostringstream stream;
+    {
+        utils::buffered_writer out(stream, 16U);
+        disasm::write_listing(out, bytes, size, address);
+    }
+    return stream.str();
+}
+
+// The instructions of a listing, as source.
+std::string source_of(const std::string &text)
+{
+    std::istringstream lines(text);
+    std::string        line;
+    std::string        source;
+    while(std::getline(lines, line))
+    {
+        source += " " + line.substr(16U) + "\n";
+    }
+    return source;
+}
+
+std::vector<uint8_t> ines_image(const std::vector<uint8_t> &prg, const uint8_t mapper)
+{
+    std::vector<uint8_t> image = {'N', 'E', 'S', 0x1AU, static_cast<uint8_t>(prg.size() / 0x4000U), 0U,
+                                  static_cast<uint8_t>(mapper << 4U), 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U, 0U};
+    image.insert(image.end(), prg.begin(), prg.end());
+    return image;
+}
+
+} // namespace
+
+TEST_CASE("Disassembler: The opcode table is packed and matches the interpreter", "[disassembler]")
+{
+    static_assert(sizeof(disasm::OPCODES) == 1024U, "Four bytes per opcode");
+
+    const disasm::opcode_info &lda = disasm::OPCODES[0xB1U];
+    REQUIRE(std::string(lda.mnemonic, 3U) == "LDA");
+    REQUIRE(lda.addressing() == cpu::assembler::mode::INDIRECT_Y);
+    REQUIRE(lda.length() == 2U);
+
+    REQUIRE_FALSE(disasm::OPCODES[0xA7U].official());
+    for(std::size_t op = 0U; op < disasm::OPCODES.size(); ++op)
+    {
+        REQUIRE(disasm::OPCODES[op].length() == cpu::LENGTHS[op]);
+    }
+}
+
+TEST_CASE("Disassembler: Listings reassemble to the same bytes", "[disassembler]")
+{
+    const std::string text = listing(EVERY_MODE.data(), EVERY_MODE.size(), 0xC000U);
+
+    REQUIRE(text.substr(0U, 26U) == "C000  0A        ASL A\nC001");
+    REQUIRE(text.find("C019  D0 FE     BNE $C019\n") != std::string::npos);
+    REQUIRE(text.find("C01B  F0 E3     BEQ $C000\n") != std::string::npos);
+    REQUIRE(text.find("C01D  A7 12     .byte $A7, $12\n") != std::string::npos);
+
+    const std::string source = "  .org $C000\n" + source_of(text);
+    INFO(source);
+    REQUIRE(cpu::assembler::assemble<EVERY_MODE.size()>(source) == EVERY_MODE);
+}
+
+TEST_CASE("Disassembler: Truncated instructions are written as data", "[disassembler]")
+{
+    const std::array<uint8_t, 2U> bytes = {0xADU, 0x34U};  // LDA $??34
+    REQUIRE(listing(bytes.data(), bytes.size(), 0x8000U) == "8000  AD 34     .byte $AD, $34\n");
+}
+
+TEST_CASE("Disassembler: Buffered writer", "[disassembler]")
+{
+    std::ostringstream stream;
+    {
+        utils::buffered_writer out(stream, 4U);
+        out.put("0x");
+        out.hex16(0xBEEFU);
+        out.put(' ');
+        out.hex8(0x07U);
+        out.put(" 1234567890 ");
+        out.decimal(0U);
+        out.put(' ');
+        out.decimal(18446744073709551615ULL);
+    }
+    REQUIRE(stream.str() == "0xBEEF 07 1234567890 0 18446744073709551615");
+}
+
+TEST_CASE("Disassembler: Reachability follows control flow from the vectors", "[disassembler]")
+{
+    const std::vector<uint8_t>    prg(REACHABILITY.begin(), REACHABILITY.end());
+    const disasm::rom_statistics stats = disasm::scan_prg(prg);
+
+    // LDX, JSR, BNE, JMP (), DEX, RTS and RTI: not the data or the vectors.
+    REQUIRE(stats.prg_bytes == 0x4000U);
+    REQUIRE(stats.reachable_instructions == 7U);
+    REQUIRE(stats.reachable_bytes == 13U);
+    REQUIRE(stats.reachable_opcodes[0xA9U] == 0U);
+    REQUIRE(stats.reachable_opcodes[0x20U] == 1U);
+    REQUIRE(stats.reachable_opcodes[0x40U] == 1U);
+
+    // The sweep decodes everything, data included.
+    REQUIRE(stats.swept_opcodes[0xA9U] == 2U);  // The third is an operand.
+    REQUIRE(std::accumulate(stats.swept_opcodes.begin(), stats.swept_opcodes.end(), uint64_t{0U}) > 0x3000U);
+}
+
+TEST_CASE("Disassembler: ROM libraries are scanned in parallel", "[disassembler]")
+{
+    const test_files::scratch_directory dir("disasm");
+
+    // Four banks with the code in the last, fixed one, as UxROM boards have it.
+    std::vector<uint8_t> banked(3U * 0x4000U, 0xFFU);
+    banked.insert(banked.end(), REACHABILITY.begin(), REACHABILITY.end());
+    dir.write("a_nrom.nes", ines_image(std::vector<uint8_t>(REACHABILITY.begin(), REACHABILITY.end()), 0U));
+    dir.write("b_uxrom.nes", ines_image(banked, 2U));
+    dir.write("c_broken.nes", {'N', 'E', 'S'});
+
+    const std::vector<disasm::rom_statistics> results = disasm::scan_corpus({dir.path.string()}, 2U);
+
+    REQUIRE(results.size() == 3U);
+    REQUIRE(results[0].rom == (dir.path / "a_nrom.nes").string());
+    REQUIRE(results[0].error.empty());
+    REQUIRE(results[0].reachable_bytes == 13U);
+    REQUIRE(results[1].error.empty());
+    REQUIRE(results[1].prg_bytes == 0x10000U);
+    REQUIRE(results[1].reachable_opcodes == results[0].reachable_opcodes);
+    REQUIRE(results[1].swept_opcodes[0xFFU] > results[0].swept_opcodes[0xFFU]);
+    REQUIRE_FALSE(results[2].error.empty());
+}
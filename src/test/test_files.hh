@@ -0,0 +1,38 @@
+#include <unistd.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#pragma once
+
+namespace test_files
+{
+    // A fresh directory, `nes-emu-<name>-<pid>` in the temporary directory, removed again
+    // at the end of the test.
+    struct scratch_directory
+    {
+        std::filesystem::path path;
+
+        explicit scratch_directory(const std::string &name)
+            : path(std::filesystem::temp_directory_path() / ("nes-emu-" + name + "-" + std::to_string(getpid())))
+        {
+            std::filesystem::create_directories(path);
+        }
+
+        ~scratch_directory() { std::filesystem::remove_all(path); }
+
+        scratch_directory(const scratch_directory &)            = delete;
+        scratch_directory &operator=(const scratch_directory &) = delete;
+
+        // Writes `bytes` to the file `name` in the directory.
+        void write(const std::string &name, const std::vector<uint8_t> &bytes) const
+        {
+            std::ofstream out(path / name, std::ios::binary);
+            out.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+        }
+    };
+
+} // namespace test_files
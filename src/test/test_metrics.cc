@@ -0,0 +1,157 @@
+#include <catch2/catch.hpp>
+
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../metrics.hh"
+#include "test_rom.hh"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace
+{
+
+// A segment name of this test process that other tests do not use.
+std::string test_name(const char *suffix)
+{
+    return nes::metrics_name(getpid()) + "-" + suffix;
+}
+
+uint64_t histogram_total(const nes::metrics_sample &s)
+{
+    return std::accumulate(s.frame_times.begin(), s.frame_times.end(), uint64_t{0U});
+}
+
+} // namespace
+
+TEST_CASE("Metrics: Frame times are bucketed by powers of two", "[metrics]")
+{
+    REQUIRE(nes::frame_time_bucket(0.0) == 0U);
+    REQUIRE(nes::frame_time_bucket(0.0009) == 0U);
+    REQUIRE(nes::frame_time_bucket(0.0015) == 1U);
+    REQUIRE(nes::frame_time_bucket(0.016) == 5U);
+    REQUIRE(nes::frame_time_bucket(10.0) == nes::FRAME_TIME_BUCKETS - 1U);
+}
+
+TEST_CASE("Metrics: Published counters can be read back", "[metrics]")
+{
+    const std::string name = test_name("counters");
+    nes::console      c(nes::load_ines(test_rom::make_image()));
+    c.set_profiling(true);
+
+    {
+        nes::metrics_publisher publisher(name);
+
+        auto snapshot = std::make_unique<nes::console::snapshot>();
+        for(int i = 0; i < 5; ++i)
+        {
+            c.run_frame();
+            c.save(*snapshot);
+            publisher.publish(c);
+        }
+
+        const std::vector<std::string> names = nes::list_metrics();
+        REQUIRE(std::find(names.begin(), names.end(), name) != names.end());
+
+        pid_t                     pid = 0;
+        const nes::metrics_sample s   = nes::read_metrics(name, &pid);
+        REQUIRE(pid == getpid());
+        REQUIRE(s.frames == 5U);
+        REQUIRE(s.started_ns > 0U);
+        REQUIRE(s.started_ns <= s.updated_ns);
+        REQUIRE(s.cycles == c.cpu_state().cycles);
+        REQUIRE(s.instructions == c.instructions());
+        REQUIRE(s.instructions > 0U);
+        REQUIRE(s.exact == 0U);
+        REQUIRE(s.snapshots_saved == 5U);
+        REQUIRE(s.snapshot_bytes == 5U * sizeof(nes::console::snapshot));
+        REQUIRE(histogram_total(s) == 4U);
+
+        // Every instruction run from the ROM is counted by opcode.
+        REQUIRE(s.profiling == 1U);
+        REQUIRE(std::accumulate(s.opcodes.begin(), s.opcodes.end(), uint64_t{0U}) == s.instructions);
+        REQUIRE(s.opcodes[0xE6U] > 0U);  // INC $20
+    }
+
+    // Removed with the publisher.
+    REQUIRE_THROWS_AS(nes::read_metrics(name), std::runtime_error);
+}
+
+TEST_CASE("Metrics: Readers never see a torn sample", "[metrics]")
+{
+    const std::string      name = test_name("seqlock");
+    nes::console           c(nes::load_ines(test_rom::make_image()));
+    nes::metrics_publisher publisher(name);
+    publisher.publish(c);
+
+    // The histogram gains one entry per frame, the publication before the first having
+    // nothing to time, so it always matches the frame count. The two are separate
+    // words: a torn read would break this.
+    constexpr uint64_t FRAMES = 300U;
+    std::atomic<bool>  done(false);
+    std::thread        writer([&]()
+                       {
+                           for(uint64_t i = 0U; i < FRAMES; ++i)
+                           {
+                               c.run_frame();
+                               publisher.publish(c);
+                           }
+                           done = true;
+                       });
+
+    bool torn = false;
+    while(!done)
+    {
+        const nes::metrics_sample s = nes::read_metrics(name);
+        torn                        = torn || histogram_total(s) != s.frames || s.frames > FRAMES;
+    }
+    writer.join();
+
+    REQUIRE_FALSE(torn);
+    REQUIRE(nes::read_metrics(name).frames == FRAMES);
+}
+
+TEST_CASE("Metrics: Readers give up on a publisher that died mid-update", "[metrics]")
+{
+    const std::string      name = test_name("abandoned");
+    nes::console           c(nes::load_ines(test_rom::make_image()));
+    nes::metrics_publisher publisher(name);
+    publisher.publish(c);
+
+    // Leaves the sequence odd, as a publisher killed between its two stores would. It
+    // follows the 16-byte header.
+    const int fd = shm_open(name.c_str(), O_RDWR, 0);
+    REQUIRE(fd >= 0);
+    void *mapping = mmap(nullptr, 24U, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    REQUIRE(mapping != MAP_FAILED);
+    auto *sequence = reinterpret_cast<std::atomic<uint64_t> *>(static_cast<uint8_t *>(mapping) + 16U);
+    ++*sequence;
+
+    REQUIRE_THROWS_AS(nes::read_metrics(name), std::runtime_error);
+
+    ++*sequence;
+    munmap(mapping, 24U);
+    REQUIRE(nes::read_metrics(name).frames == c.frame_number());
+}
+
+TEST_CASE("Metrics: Segments that are not set up yet are skipped", "[metrics]")
+{
+    // Created but not yet sized, as a publisher leaves it for a moment on start-up.
+    const std::string name = test_name("unsized");
+    const int         fd   = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+    REQUIRE(fd >= 0);
+    close(fd);
+
+    REQUIRE_THROWS_AS(nes::read_metrics(name), std::runtime_error);
+    shm_unlink(name.c_str());
+}
@@ -0,0 +1,243 @@
+#include <catch2/catch.hpp>
+
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../debugger.hh"
+#include "../movie.hh"
+#include "../replay.hh"
+#include "test_rom.hh"
+
+namespace
+{
+
+using checkpoint = nes::movie::checkpoint;
+
+// 120 frames: idle, then holding A|RIGHT, then a few single-frame presses.
+nes::movie make_movie(const uint64_t rom_hash)
+{
+    nes::movie m(rom_hash);
+
+    for(int i = 0; i < 60; ++i)
+    {
+        m.append({0x00U, 0x00U});
+    }
+    for(int i = 0; i < 50; ++i)
+    {
+        m.append({nes::buttons::A | nes::buttons::RIGHT, 0x00U});
+    }
+    for(int i = 0; i < 10; ++i)
+    {
+        m.append({static_cast<uint8_t>(i), 0x00U});
+    }
+
+    return m;
+}
+
+void put_u32(std::vector<uint8_t> &bytes, const uint32_t value)
+{
+    for(std::size_t i = 0U; i < sizeof(value); ++i)
+    {
+        bytes.push_back(static_cast<uint8_t>(value >> (8U * i)));
+    }
+}
+
+// An empty movie's header, up to the run count.
+std::vector<uint8_t> movie_header()
+{
+    std::vector<uint8_t> bytes = nes::movie(0U).serialize();
+    bytes.resize(bytes.size() - 2U * sizeof(uint32_t));
+    return bytes;
+}
+
+// A header and one run of eight idle frames, up to the checkpoint count.
+std::vector<uint8_t> eight_frames()
+{
+    std::vector<uint8_t> bytes = movie_header();
+    put_u32(bytes, 1U);
+    bytes.insert(bytes.end(), {0x08U, 0x00U, 0x00U});
+    return bytes;
+}
+
+} // namespace
+
+TEST_CASE("Movie: Input is run-length encoded", "[movie]")
+{
+    const nes::movie m = make_movie(0U);
+
+    REQUIRE(m.frame_count() == 120U);
+    REQUIRE(m.runs().size() == 12U);
+    REQUIRE(m.runs()[0].length == 60U);
+    REQUIRE(m.runs()[1].length == 50U);
+}
+
+TEST_CASE("Movie: Checkpoints must be in order and within the movie", "[movie]")
+{
+    nes::movie m = make_movie(0U);
+    m.add_checkpoint({10U, checkpoint::kind::FRAME, 0U});
+    m.add_checkpoint({10U, checkpoint::kind::STATE, 0U});
+
+    REQUIRE_THROWS_AS(m.add_checkpoint({9U, checkpoint::kind::FRAME, 0U}), std::invalid_argument);
+    REQUIRE_THROWS_AS(m.add_checkpoint({120U, checkpoint::kind::FRAME, 0U}), std::invalid_argument);
+    m.add_checkpoint({119U, checkpoint::kind::FRAME, 0U});
+    REQUIRE(m.checkpoints().size() == 3U);
+}
+
+TEST_CASE("Movie: Serialization round trip", "[movie]")
+{
+    nes::movie m = make_movie(0x1234U);
+    m.add_checkpoint({10U, checkpoint::kind::FRAME, 0xDEADBEEFU});
+    m.add_checkpoint({119U, checkpoint::kind::STATE, 0xFFFFFFFFFFFFFFFFULL});
+
+    const nes::movie loaded = nes::movie::deserialize(m.serialize());
+
+    REQUIRE(loaded.rom_hash() == 0x1234U);
+    REQUIRE(loaded.frame_count() == m.frame_count());
+    REQUIRE(loaded.runs().size() == m.runs().size());
+    REQUIRE(loaded.runs()[1].held == m.runs()[1].held);
+    REQUIRE(loaded.checkpoints().size() == 2U);
+    REQUIRE(loaded.checkpoints()[1].frame == 119U);
+    REQUIRE(loaded.checkpoints()[1].type == checkpoint::kind::STATE);
+    REQUIRE(loaded.checkpoints()[1].hash == 0xFFFFFFFFFFFFFFFFULL);
+
+    std::vector<uint8_t> truncated = m.serialize();
+    truncated.resize(truncated.size() - 1U);
+    REQUIRE_THROWS_AS(nes::movie::deserialize(truncated), std::runtime_error);
+}
+
+TEST_CASE("Movie: Corrupt fields are rejected", "[movie]")
+{
+    SECTION("Run count larger than the file")
+    {
+        std::vector<uint8_t> bytes = movie_header();
+        put_u32(bytes, 0xFFFFFFFFU);
+        put_u32(bytes, 0U);
+        REQUIRE_THROWS_AS(nes::movie::deserialize(bytes), std::runtime_error);
+    }
+
+    SECTION("Run longer than 32 bits")
+    {
+        std::vector<uint8_t> bytes = movie_header();
+        put_u32(bytes, 1U);
+        bytes.insert(bytes.end(), {0x80U, 0x80U, 0x80U, 0x80U, 0x10U});  // 2^32
+        bytes.insert(bytes.end(), {0x00U, 0x00U});
+        put_u32(bytes, 0U);
+        REQUIRE_THROWS_AS(nes::movie::deserialize(bytes), std::runtime_error);
+    }
+
+    SECTION("Unknown checkpoint kind")
+    {
+        std::vector<uint8_t> bytes = eight_frames();
+        put_u32(bytes, 1U);
+        bytes.insert(bytes.end(), {0x00U, 0x07U});
+        bytes.insert(bytes.end(), sizeof(uint64_t), 0x00U);
+        REQUIRE_THROWS_AS(nes::movie::deserialize(bytes), std::runtime_error);
+
+        bytes[bytes.size() - 9U] = static_cast<uint8_t>(checkpoint::kind::STATE);
+        REQUIRE(nes::movie::deserialize(bytes).checkpoints().size() == 1U);
+    }
+
+    SECTION("Checkpoints out of order")
+    {
+        std::vector<uint8_t> bytes = eight_frames();
+        put_u32(bytes, 2U);
+        for(const uint8_t frame : {0x05U, 0x04U})
+        {
+            bytes.insert(bytes.end(), {frame, 0x00U});
+            bytes.insert(bytes.end(), sizeof(uint64_t), 0x00U);
+        }
+        REQUIRE_THROWS_AS(nes::movie::deserialize(bytes), std::runtime_error);
+    }
+
+    SECTION("Checkpoint past the last frame")
+    {
+        std::vector<uint8_t> bytes = eight_frames();
+        put_u32(bytes, 1U);
+        bytes.insert(bytes.end(), {0x08U, 0x00U});
+        bytes.insert(bytes.end(), sizeof(uint64_t), 0x00U);
+        REQUIRE_THROWS_AS(nes::movie::deserialize(bytes), std::runtime_error);
+
+        bytes[bytes.size() - 10U] = 0x07U;
+        REQUIRE(nes::movie::deserialize(bytes).checkpoints().size() == 1U);
+    }
+}
+
+TEST_CASE("Replay: Recorded checkpoints replay deterministically", "[movie]")
+{
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image());
+
+    for(const auto k : {checkpoint::kind::STATE, checkpoint::kind::FRAME})
+    {
+        nes::movie m = make_movie(cart.hash);
+        {
+            nes::console recorder(cart);
+            nes::record_checkpoints(recorder, m, k, 30U);
+        }
+        REQUIRE(m.checkpoints().size() == 4U);
+
+        // Threaded rendering must produce the same frames as inline.
+        for(const auto mode : {ppu::pipeline::mode::INLINE, ppu::pipeline::mode::THREADED})
+        {
+            nes::console              player(cart, mode);
+            const nes::replay_report report = nes::replay(player, m);
+
+            REQUIRE_FALSE(report.diverged);
+            REQUIRE(report.frames == 120U);
+            REQUIRE(report.checkpoints_passed == 4U);
+            REQUIRE(report.frames_per_second() > 0.0);
+        }
+    }
+}
+
+TEST_CASE("Replay: Divergence is reported at the first bad checkpoint", "[movie]")
+{
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image());
+
+    nes::movie m = make_movie(cart.hash);
+    {
+        nes::console recorder(cart);
+        nes::record_checkpoints(recorder, m, checkpoint::kind::STATE, 30U);
+    }
+
+    // Same checkpoints, different input from frame 60 on.
+    nes::movie altered(cart.hash);
+    for(uint64_t i = 0U; i < m.frame_count(); ++i)
+    {
+        altered.append({static_cast<uint8_t>(i < 60U ? 0x00U : nes::buttons::B), 0x00U});
+    }
+    for(const checkpoint &c : m.checkpoints())
+    {
+        altered.add_checkpoint(c);
+    }
+
+    nes::console              player(cart);
+    const nes::replay_report report = nes::replay(player, altered);
+
+    REQUIRE(report.diverged);
+    REQUIRE(report.failure.frame == 89U);
+    REQUIRE(report.checkpoints_passed == 2U);
+    REQUIRE(report.frames == 90U);
+
+    nes::console other(nes::load_ines(test_rom::make_image(std::array<uint8_t, 1U>{0xEA})));
+    REQUIRE_THROWS_AS(nes::replay(other, m), std::invalid_argument);
+}
+
+TEST_CASE("Replay: Debugger breaks do not split frames", "[movie]")
+{
+    const nes::cartridge cart = test_rom::make_cartridge();
+
+    nes::movie m = make_movie(cart.hash);
+    {
+        nes::console recorder(cart);
+        nes::record_checkpoints(recorder, m, checkpoint::kind::STATE, 30U);
+    }
+
+    // Breaks once per frame, in the NMI handler.
+    nes::console  player(cart);
+    nes::debugger d(player);
+    d.add_breakpoint(test_rom::NMI_ADDRESS);
+
+    const nes::replay_report report = nes::replay(player, m);
+    REQUIRE_FALSE(report.diverged);
+    REQUIRE(report.frames == 120U);
+    REQUIRE(report.checkpoints_passed == 4U);
+}
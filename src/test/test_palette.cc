@@ -0,0 +1,101 @@
+#include <catch2/catch.hpp>
+
+#include "../palette.hh"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+std::unique_ptr<ppu::frame> create_mock_frame()
+{
+    auto         f = std::make_unique<ppu::frame>();
+    std::mt19937 rng(1234U);
+
+    for(auto &pixel : f->pixels)
+    {
+        pixel = static_cast<uint8_t>(rng());  // Includes out-of-range bits, which must be masked.
+    }
+
+    for(size_t y = 0U; y < f->emphasis.size(); ++y)
+    {
+        f->emphasis[y] = static_cast<uint8_t>(y % 8U);
+    }
+
+    return f;
+}
+
+} // namespace
+
+TEST_CASE("Palette: Table", "[palette]")
+{
+    const auto table = palette::make_table();
+
+    // Black, grey and white with no emphasis.
+    REQUIRE(table.entries[0x0F] == palette::make_rgba(0, 0, 0));
+    REQUIRE(table.entries[0x30] == palette::make_rgba(236, 238, 236));
+
+    // Red emphasis darkens green and blue only.
+    const palette::rgba emphasised = table.entries[(1U << 6U) | 0x30U];
+    REQUIRE((emphasised & 0xFFU) == 236U);
+    REQUIRE(((emphasised >> 8U) & 0xFFU) < 238U);
+    REQUIRE(((emphasised >> 16U) & 0xFFU) < 236U);
+}
+
+TEST_CASE("Palette: Kernels match the scalar reference", "[palette]")
+{
+    const auto frame = create_mock_frame();
+    const auto table = palette::make_table();
+
+    for(const auto k : {palette::kernel::SSE2, palette::kernel::AVX2})
+    {
+        if(!palette::supported(k))
+        {
+            WARN("Kernel " << static_cast<int>(k) << " not supported on this host, skipping.");
+            continue;
+        }
+
+        for(uint32_t scale = 1U; scale <= 3U; ++scale)
+        {
+            // Pitch wider than the image, with a guard value in the padding.
+            const size_t pitch = (ppu::SCREEN_WIDTH * scale) + 16U;
+            std::vector<palette::rgba> expected(pitch * ppu::SCREEN_HEIGHT * scale, 0xDEADBEEF);
+            std::vector<palette::rgba> actual(expected.size(), 0xDEADBEEF);
+
+            palette::convert(*frame, table, expected.data(), pitch, scale, palette::kernel::SCALAR);
+            palette::convert(*frame, table, actual.data(), pitch, scale, k);
+
+            const bool identical = (actual == expected);
+            REQUIRE(identical);
+            REQUIRE(actual[pitch - 1U] == 0xDEADBEEF);
+            REQUIRE(actual[(pitch * scale) - 1U] == 0xDEADBEEF);
+        }
+    }
+}
+
+TEST_CASE("Palette: Scaling", "[palette]")
+{
+    auto       frame = std::make_unique<ppu::frame>();
+    const auto table = palette::make_table();
+
+    frame->pixels[0] = 0x30;  // White top-left pixel, the rest black.
+    frame->pixels[1] = 0x0F;
+
+    std::vector<palette::rgba> out(ppu::SCREEN_WIDTH * 3U * ppu::SCREEN_HEIGHT * 3U);
+    palette::convert(*frame, table, out.data(), ppu::SCREEN_WIDTH * 3U, 3U);
+
+    const size_t pitch = ppu::SCREEN_WIDTH * 3U;
+    for(size_t y = 0U; y < 3U; ++y)
+    {
+        for(size_t x = 0U; x < 3U; ++x)
+        {
+            REQUIRE(out[(y * pitch) + x] == table.entries[0x30]);
+        }
+        REQUIRE(out[(y * pitch) + 3U] == table.entries[0x0F]);
+    }
+
+    REQUIRE_THROWS_AS(palette::convert(*frame, table, out.data(), pitch, 4U), std::invalid_argument);
+    REQUIRE_THROWS_AS(palette::convert(*frame, table, out.data(), ppu::SCREEN_WIDTH, 2U), std::invalid_argument);
+}
@@ -0,0 +1,188 @@
+#include <catch2/catch.hpp>
+
+#include "../ppu.hh"
+#include "../ppu_pipeline.hh"
+
+#include <memory>
+#include <vector>
+
+namespace
+{
+
+using registers = ppu::registers;
+
+// CPU cycle at which `scanline` of `frame` starts.
+uint64_t cycle_at(const uint64_t frame, const uint32_t scanline)
+{
+    const uint64_t dot = (frame * ppu::DOTS_PER_FRAME) + (scanline * ppu::DOTS_PER_SCANLINE);
+    return (dot + ppu::DOTS_PER_CPU_CYCLE - 1U) / ppu::DOTS_PER_CPU_CYCLE;
+}
+
+// State with a solid tile 1, a nametable full of it and sprite 0 over the middle.
+ppu::state create_mock_state()
+{
+    ppu::state s;
+
+    for(size_t row = 0U; row < 8U; ++row)
+    {
+        s.chr[16U + row] = 0xFF;
+    }
+
+    std::fill(s.vram.begin(), s.vram.begin() + 0x3C0, 0x01);
+    for(size_t i = 0U; i < s.palette.size(); ++i)
+    {
+        s.palette[i] = static_cast<uint8_t>(i);
+    }
+
+    s.oam[0] = 99U;   // Y (displayed from line 100)
+    s.oam[1] = 0x01;  // Tile
+    s.oam[2] = 0x00;  // Attributes
+    s.oam[3] = 120U;  // X
+    s.mask   = 0x1E;  // Background + sprites, no left clipping.
+
+    return s;
+}
+
+// Drives a pipeline through a few frames with mid-frame scroll changes, collecting
+// every frame from the pipeline's output.
+std::vector<ppu::frame> run_frames(const ppu::pipeline::mode mode)
+{
+    std::vector<ppu::frame> frames;
+    auto pipeline = std::make_unique<ppu::pipeline>(create_mock_state(), mode);
+
+    for(uint64_t frame = 0U; frame < 4U; ++frame)
+    {
+        pipeline->write(registers::MASK, frame % 2U ? 0x1E : 0x3E, cycle_at(frame, 50U));
+        pipeline->read(registers::STATUS, cycle_at(frame, 120U));
+        pipeline->write(registers::SCROLL, static_cast<uint8_t>(frame * 3U), cycle_at(frame, 242U));
+        pipeline->write(registers::SCROLL, 0x00, cycle_at(frame, 242U) + 1U);
+        pipeline->end_frame(cycle_at(frame + 1U, 0U));
+        pipeline->flush();
+
+        if(pipeline->output().acquire())
+        {
+            frames.push_back(pipeline->output().front());
+        }
+    }
+
+    return frames;
+}
+
+} // namespace
+
+TEST_CASE("PPU: Scroll and address registers", "[ppu]")
+{
+    ppu::state s;
+
+    ppu::write_register(s, registers::SCROLL, 0x7D);  // Coarse X 15, fine X 5.
+    REQUIRE(s.w);
+    REQUIRE(s.x == 0x05);
+    REQUIRE((s.t & 0x001F) == 15U);
+
+    ppu::write_register(s, registers::SCROLL, 0x5E);  // Coarse Y 11, fine Y 6.
+    REQUIRE(!s.w);
+    REQUIRE(((s.t >> 5U) & 0x1F) == 11U);
+    REQUIRE(((s.t >> 12U) & 0x07) == 6U);
+
+    ppu::write_register(s, registers::ADDR, 0x21);
+    ppu::write_register(s, registers::ADDR, 0x08);
+    REQUIRE(s.v == 0x2108);
+
+    // Reading $2002 resets the write toggle.
+    ppu::write_register(s, registers::ADDR, 0x3F);
+    ppu::read_register(s, registers::STATUS);
+    REQUIRE(!s.w);
+}
+
+TEST_CASE("PPU: VRAM mirroring and buffered reads", "[ppu]")
+{
+    ppu::state s;
+
+    SECTION("Horizontal")
+    {
+        s.mode = ppu::mirroring::HORIZONTAL;
+        ppu::write_vram(s, 0x2005, 0xAB);
+        REQUIRE(ppu::read_vram(s, 0x2405) == 0xAB);
+        REQUIRE(ppu::read_vram(s, 0x2805) != 0xAB);
+    }
+
+    SECTION("Vertical")
+    {
+        s.mode = ppu::mirroring::VERTICAL;
+        ppu::write_vram(s, 0x2005, 0xAB);
+        REQUIRE(ppu::read_vram(s, 0x2805) == 0xAB);
+        REQUIRE(ppu::read_vram(s, 0x2405) != 0xAB);
+    }
+
+    SECTION("Palette")
+    {
+        ppu::write_vram(s, 0x3F10, 0x2A);
+        REQUIRE(ppu::read_vram(s, 0x3F00) == 0x2A);
+    }
+
+    SECTION("$2007 read buffer")
+    {
+        ppu::write_vram(s, 0x2000, 0x11);
+        ppu::write_vram(s, 0x2001, 0x22);
+        s.v = 0x2000;
+
+        ppu::read_register(s, registers::DATA);  // Primes the buffer.
+        REQUIRE(ppu::read_register(s, registers::DATA) == 0x11);
+        REQUIRE(ppu::read_register(s, registers::DATA) == 0x22);
+    }
+}
+
+TEST_CASE("PPU: Timing model", "[ppu]")
+{
+    auto         s = create_mock_state();
+    ppu::timing  timing;
+
+    SECTION("Vblank is raised at scanline 241 and cleared by a read")
+    {
+        REQUIRE((timing.read_status(s, cycle_at(0U, 100U)) & ppu::STATUS_VBLANK) == 0U);
+        REQUIRE((timing.read_status(s, cycle_at(0U, 242U)) & ppu::STATUS_VBLANK) != 0U);
+        REQUIRE((timing.read_status(s, cycle_at(0U, 243U)) & ppu::STATUS_VBLANK) == 0U);
+        REQUIRE((timing.read_status(s, cycle_at(1U, 242U)) & ppu::STATUS_VBLANK) != 0U);
+    }
+
+    SECTION("Sprite-0 hit agrees with the renderer")
+    {
+        timing.begin_frame(s, 0U);
+        REQUIRE((timing.read_status(s, cycle_at(0U, 99U)) & ppu::STATUS_SPRITE_ZERO_HIT) == 0U);
+        REQUIRE((timing.read_status(s, cycle_at(0U, 101U)) & ppu::STATUS_SPRITE_ZERO_HIT) != 0U);
+        REQUIRE((timing.read_status(s, cycle_at(0U, 261U) + 1U) & ppu::STATUS_SPRITE_ZERO_HIT) == 0U);
+
+        ppu::renderer renderer;
+        auto          frame = std::make_unique<ppu::frame>();
+        renderer.begin_frame(*frame, 0U);
+        renderer.finish_frame(s, *frame);
+        REQUIRE(renderer.sprite_zero_hit());
+    }
+
+    SECTION("No hit while sprites are disabled")
+    {
+        s.mask = 0x0A;
+        timing.begin_frame(s, 0U);
+        REQUIRE((timing.read_status(s, cycle_at(0U, 200U)) & ppu::STATUS_SPRITE_ZERO_HIT) == 0U);
+    }
+}
+
+TEST_CASE("PPU: Threaded pipeline matches inline rendering", "[ppu]")
+{
+    const auto inline_frames   = run_frames(ppu::pipeline::mode::INLINE);
+    const auto threaded_frames = run_frames(ppu::pipeline::mode::THREADED);
+
+    REQUIRE(inline_frames.size() == 4U);
+    REQUIRE(threaded_frames.size() == inline_frames.size());
+
+    for(size_t i = 0U; i < inline_frames.size(); ++i)
+    {
+        REQUIRE(threaded_frames[i].number == i);
+        REQUIRE(threaded_frames[i].pixels == inline_frames[i].pixels);
+        REQUIRE(threaded_frames[i].emphasis == inline_frames[i].emphasis);
+    }
+
+    // The mask change at scanline 50 only shows up from the following lines.
+    REQUIRE(inline_frames[0].emphasis[49] == 0x00);
+    REQUIRE(inline_frames[0].emphasis[51] == 0x01);
+}
@@ -0,0 +1,148 @@
+#include <catch2/catch.hpp>
+
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../predecode.hh"
+#include "test_files.hh"
+#include "test_rom.hh"
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+namespace
+{
+
+constexpr uint16_t WAIT_ADDRESS = 0x800FU;
+constexpr uint16_t NMI_ADDRESS  = 0x801CU;
+
+// Waits for each NMI in an idle loop, then counts it in $20.
+constexpr std::array<uint8_t, 0x20U> IDLE_PROGRAM = {
+    // reset:
+    0x78,              // SEI
+    0xD8,              // CLD
+    0xA2, 0xFF,        // LDX #$FF
+    0x9A,              // TXS
+    0xA9, 0x80,        // LDA #$80
+    0x8D, 0x00, 0x20,  // STA $2000
+    0xA9, 0x08,        // LDA #$08
+    0x8D, 0x01, 0x20,  // STA $2001
+    // wait:
+    0xA5, 0x12,        // LDA $12
+    0xC5, 0x13,        // CMP $13
+    0xF0, 0xFA,        // BEQ wait
+    0x85, 0x13,        // STA $13
+    0xE6, 0x20,        // INC $20
+    0x4C, 0x0F, 0x80,  // JMP wait
+    // nmi:
+    0xE6, 0x12,        // INC $12
+    0x40,              // RTI
+    // irq:
+    0x40};             // RTI
+
+nes::cartridge idle_cartridge()
+{
+    return nes::load_ines(test_rom::make_image(IDLE_PROGRAM, test_rom::RESET_ADDRESS, NMI_ADDRESS, 0x801FU));
+}
+
+} // namespace
+
+TEST_CASE("Predecode: Finds blocks, jump targets and idle loops", "[predecode]")
+{
+    const nes::predecode analysis = nes::predecode::analyze(idle_cartridge());
+    REQUIRE_FALSE(analysis.mapped());
+
+    using flag = nes::predecode::flag;
+    REQUIRE((analysis.flags(WAIT_ADDRESS) & flag::JUMP_TARGET) != 0U);
+    REQUIRE((analysis.flags(WAIT_ADDRESS) & flag::IDLE_LOOP) != 0U);
+    REQUIRE((analysis.flags(WAIT_ADDRESS + 2U) & flag::FUSIBLE) != 0U);
+    REQUIRE((analysis.flags(WAIT_ADDRESS + 1U) & flag::INSTRUCTION) == 0U);
+    REQUIRE(analysis.flags(0x0000U) == 0U);
+
+    // LDA zp + CMP zp + taken BEQ.
+    REQUIRE(analysis.idle_loop_cycles(WAIT_ADDRESS) == 9U);
+    REQUIRE(analysis.idle_loop_cycles(WAIT_ADDRESS + 0x4000U) == 9U);  // 16 KiB mirror.
+    REQUIRE(analysis.idle_loop_cycles(0x8015U) == 0U);
+    REQUIRE(analysis.idle_loop_count() == 1U);
+
+    // reset, wait, the code after it, nmi and irq.
+    REQUIRE(analysis.block_count() == 5U);
+    const nes::predecode::block &wait = analysis.blocks()[1];
+    REQUIRE(wait.start == WAIT_ADDRESS);
+    REQUIRE(wait.length == 6U);
+    REQUIRE(wait.instructions == 3U);
+
+    // The test ROM's main loop writes memory, so it is not idle.
+    const nes::predecode busy = nes::predecode::analyze(nes::load_ines(test_rom::make_image()));
+    REQUIRE(busy.idle_loop_count() == 0U);
+}
+
+TEST_CASE("Predecode: Skipping idle loops does not change emulation", "[predecode]")
+{
+    const nes::cartridge cart     = idle_cartridge();
+    const nes::predecode analysis = nes::predecode::analyze(cart);
+
+    nes::console plain(cart);
+    nes::console skipping(cart);
+    skipping.set_predecode(&analysis);
+
+    for(int i = 0; i < 60; ++i)
+    {
+        plain.run_frame();
+        skipping.run_frame();
+        REQUIRE(skipping.state_hash() == plain.state_hash());
+    }
+    REQUIRE(skipping.ram()[0x20] == 60U);
+    REQUIRE(plain.idle_cycles_skipped() == 0U);
+
+    // Nearly all of a frame is spent waiting.
+    REQUIRE(skipping.idle_cycles_skipped() > nes::frame_start_cycle(60U) * 9U / 10U);
+
+    const nes::predecode other = nes::predecode::analyze(nes::load_ines(test_rom::make_image()));
+    REQUIRE_THROWS_AS(skipping.set_predecode(&other), std::invalid_argument);
+}
+
+TEST_CASE("Predecode: Cache files are mapped, versioned and checked", "[predecode]")
+{
+    const test_files::scratch_directory dir("predecode");
+    const nes::cartridge    cart = idle_cartridge();
+    const std::string       path = nes::predecode::cache_path(cart, dir.path.string());
+
+    const nes::predecode built = nes::predecode::load_or_build(cart, dir.path.string());
+    REQUIRE_FALSE(built.mapped());
+    REQUIRE(std::filesystem::exists(path));
+
+    const nes::predecode cached = nes::predecode::load_or_build(cart, dir.path.string());
+    REQUIRE(cached.mapped());
+    REQUIRE(cached.rom_hash() == cart.hash);
+    REQUIRE(cached.block_count() == built.block_count());
+    REQUIRE(cached.idle_loop_cycles(WAIT_ADDRESS) == 9U);
+    for(uint32_t address = 0x8000U; address < 0x10000U; ++address)
+    {
+        if(cached.flags(static_cast<uint16_t>(address)) != built.flags(static_cast<uint16_t>(address)))
+        {
+            FAIL("Flags differ at " << address);
+        }
+    }
+
+    const auto patch = [&path](const std::streamoff offset, const char value)
+    {
+        std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(offset);
+        file.put(value);
+    };
+
+    // Damage a flag byte at the end of the file.
+    patch(static_cast<std::streamoff>(std::filesystem::file_size(path) - 1U), 0x7F);
+    REQUIRE_THROWS_WITH(nes::predecode::load(path, cart), "Predecode cache checksum mismatch!");
+    REQUIRE_FALSE(nes::predecode::load_or_build(cart, dir.path.string()).mapped());
+    REQUIRE(nes::predecode::load(path, cart).mapped());
+
+    const nes::cartridge other = nes::load_ines(test_rom::make_image());
+    REQUIRE_THROWS_WITH(nes::predecode::load(path, other), "Predecode cache is for a different ROM!");
+
+    // Version field.
+    patch(4, 0x7F);
+    REQUIRE_THROWS_WITH(nes::predecode::load(path, cart), "Unsupported predecode cache version!");
+}
@@ -0,0 +1,121 @@
+#include <catch2/catch.hpp>
+
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../rollback.hh"
+#include "test_rom.hh"
+
+#include <array>
+
+namespace
+{
+
+constexpr uint64_t FRAMES       = 200U;
+constexpr uint64_t INPUT_FRAMES = 150U;
+
+// Each player changes buttons on their own rhythm, then lets go for the last frames so
+// that every peer's trailing predictions are right.
+uint8_t held_by(const std::size_t player, const uint64_t frame)
+{
+    if(frame >= INPUT_FRAMES)
+    {
+        return 0x00U;
+    }
+    return player == 0U ? static_cast<uint8_t>((frame / 7U) * 37U)
+                        : static_cast<uint8_t>((frame / 5U) * 11U + 1U);
+}
+
+} // namespace
+
+TEST_CASE("Rollback: Loopback link delays and reorders", "[rollback]")
+{
+    nes::loopback_link link(2U, 3U, 7U);
+    nes::input_packet  packet;
+
+    for(uint64_t frame = 0U; frame < 32U; ++frame)
+    {
+        link.endpoint(0U).send({frame, static_cast<uint8_t>(frame)});
+    }
+    REQUIRE_FALSE(link.endpoint(1U).receive(packet));
+    REQUIRE_FALSE(link.endpoint(0U).receive(packet));
+
+    std::array<bool, 32> seen{};
+    for(int tick = 0; tick < 6; ++tick)
+    {
+        link.tick();
+        while(link.endpoint(1U).receive(packet))
+        {
+            REQUIRE(packet.held == packet.frame);
+            seen[packet.frame] = true;
+        }
+    }
+    for(const bool s : seen)
+    {
+        REQUIRE(s);
+    }
+}
+
+TEST_CASE("Rollback: Peers converge on the true inputs", "[rollback]")
+{
+    constexpr uint32_t WINDOW = 8U;
+
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image());
+
+    nes::console          consoles[2] = {nes::console(cart), nes::console(cart)};
+    nes::loopback_link    link(3U, 3U);
+    nes::rollback_session peers[2] = {
+        nes::rollback_session(consoles[0], link.endpoint(0U), 0U, WINDOW),
+        nes::rollback_session(consoles[1], link.endpoint(1U), 1U, WINDOW)};
+
+    // Peer 1 starts late, so peer 0 has to stall and both have to roll back.
+    for(int tick = 0; tick < 1000 && (peers[0].frame() < FRAMES || peers[1].frame() < FRAMES); ++tick)
+    {
+        for(std::size_t p = 0U; p < 2U; ++p)
+        {
+            if((p == 1U && tick < 5) || peers[p].frame() >= FRAMES)
+            {
+                continue;
+            }
+            peers[p].advance(held_by(p, peers[p].frame()));
+        }
+        link.tick();
+    }
+
+    nes::console reference(cart);
+    for(uint64_t frame = 0U; frame < FRAMES; ++frame)
+    {
+        reference.set_input(0U, held_by(0U, frame));
+        reference.set_input(1U, held_by(1U, frame));
+        reference.run_frame();
+    }
+
+    for(std::size_t p = 0U; p < 2U; ++p)
+    {
+        REQUIRE(peers[p].frame() == FRAMES);
+        REQUIRE(peers[p].confirmed_frames() + WINDOW >= FRAMES);
+        REQUIRE(peers[p].rollbacks() > 0U);
+        REQUIRE(peers[p].frames_resimulated() <= peers[p].rollbacks() * WINDOW);
+        REQUIRE(consoles[p].state_hash() == reference.state_hash());
+    }
+    REQUIRE(peers[0].stalls() > 0U);
+}
+
+TEST_CASE("Rollback: Stalls at the edge of the window", "[rollback]")
+{
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image());
+
+    nes::console          c(cart);
+    nes::loopback_link    link(1U, 0U);
+    nes::rollback_session session(c, link.endpoint(0U), 0U, 4U);
+
+    for(int i = 0; i < 4; ++i)
+    {
+        REQUIRE(session.advance(nes::buttons::A));
+        link.tick();
+    }
+    REQUIRE_FALSE(session.advance(nes::buttons::A));
+    REQUIRE(session.frame() == 4U);
+    REQUIRE(session.stalls() == 1U);
+
+    REQUIRE_THROWS_AS(nes::rollback_session(c, link.endpoint(0U), 2U, 4U), std::invalid_argument);
+}
@@ -0,0 +1,127 @@
+#include "../cartridge.hh"
+#include "../console.hh"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#pragma once
+
+namespace test_rom
+{
+    //
+    // NROM image whose state depends on controller input and timing.
+    //
+    // Reset enables NMI and background rendering, then increments $20 forever. The NMI
+    // handler reads controller 1 into $10 and controller 2 into $13, adds their XOR to a
+    // running sum in $11, counts NMIs in $12 and writes the sum to the backdrop colour,
+    // so both the state hash and the frame hash follow the input.
+    //
+    constexpr uint16_t RESET_ADDRESS = 0x8000U;
+    constexpr uint16_t NMI_ADDRESS   = 0x8014U;
+    constexpr uint16_t IRQ_ADDRESS   = 0x8059U;
+
+    constexpr std::array<uint8_t, 0x5AU> PROGRAM = {
+        // reset:
+        0x78,              // SEI
+        0xD8,              // CLD
+        0xA2, 0xFF,        // LDX #$FF
+        0x9A,              // TXS
+        0xA9, 0x80,        // LDA #$80
+        0x8D, 0x00, 0x20,  // STA $2000
+        0xA9, 0x08,        // LDA #$08
+        0x8D, 0x01, 0x20,  // STA $2001
+        // loop:
+        0xE6, 0x20,        // INC $20
+        0x4C, 0x0F, 0x80,  // JMP loop
+        // nmi:
+        0xA9, 0x01,        // LDA #$01
+        0x8D, 0x16, 0x40,  // STA $4016
+        0xA9, 0x00,        // LDA #$00
+        0x8D, 0x16, 0x40,  // STA $4016
+        0xA2, 0x08,        // LDX #$08
+        // read:
+        0xAD, 0x16, 0x40,  // LDA $4016
+        0x4A,              // LSR A
+        0x26, 0x10,        // ROL $10
+        0xCA,              // DEX
+        0xD0, 0xF7,        // BNE read
+        0xA2, 0x08,        // LDX #$08
+        // read_2:
+        0xAD, 0x17, 0x40,  // LDA $4017
+        0x4A,              // LSR A
+        0x26, 0x13,        // ROL $13
+        0xCA,              // DEX
+        0xD0, 0xF7,        // BNE read_2
+        0xA5, 0x10,        // LDA $10
+        0x45, 0x13,        // EOR $13
+        0x18,              // CLC
+        0x65, 0x11,        // ADC $11
+        0x85, 0x11,        // STA $11
+        0xE6, 0x12,        // INC $12
+        0xA9, 0x3F,        // LDA #$3F
+        0x8D, 0x06, 0x20,  // STA $2006
+        0xA9, 0x00,        // LDA #$00
+        0x8D, 0x06, 0x20,  // STA $2006
+        0xA5, 0x11,        // LDA $11
+        0x29, 0x3F,        // AND #$3F
+        0x8D, 0x07, 0x20,  // STA $2007
+        0xA9, 0x00,        // LDA #$00
+        0x8D, 0x05, 0x20,  // STA $2005
+        0x8D, 0x05, 0x20,  // STA $2005
+        0x40,              // RTI
+        // irq:
+        0x40};             // RTI
+
+    // Builds a 16 KiB PRG / 8 KiB CHR iNES image around `program`, loaded at $8000.
+    template<std::size_t N>
+    std::vector<uint8_t> make_image(const std::array<uint8_t, N> &program,
+                                    const uint16_t reset = RESET_ADDRESS,
+                                    const uint16_t nmi   = NMI_ADDRESS,
+                                    const uint16_t irq   = IRQ_ADDRESS)
+    {
+        constexpr std::size_t HEADER = 16U;
+        constexpr std::size_t PRG    = 0x4000U;
+        constexpr std::size_t CHR    = 0x2000U;
+
+        std::vector<uint8_t> image(HEADER + PRG + CHR, 0x00U);
+        image[0] = 'N';
+        image[1] = 'E';
+        image[2] = 'S';
+        image[3] = 0x1AU;
+        image[4] = 1U;
+        image[5] = 1U;
+
+        std::copy(program.begin(), program.end(), image.begin() + HEADER);
+
+        const auto put_vector = [&image](const std::size_t offset, const uint16_t address)
+        {
+            image[HEADER + offset]      = static_cast<uint8_t>(address);
+            image[HEADER + offset + 1U] = static_cast<uint8_t>(address >> 8U);
+        };
+        put_vector(0x3FFAU, nmi);
+        put_vector(0x3FFCU, reset);
+        put_vector(0x3FFEU, irq);
+
+        return image;
+    }
+
+    inline std::vector<uint8_t> make_image()
+    {
+        return make_image(PROGRAM);
+    }
+
+    inline nes::cartridge make_cartridge()
+    {
+        return nes::load_ines(make_image());
+    }
+
+    inline void run_frames(nes::console &c, const int count)
+    {
+        for(int i = 0; i < count; ++i)
+        {
+            c.run_frame();
+        }
+    }
+
+} // namespace test_rom
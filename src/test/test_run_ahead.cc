@@ -0,0 +1,103 @@
+#include <catch2/catch.hpp>
+
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../replay.hh"
+#include "../run_ahead.hh"
+#include "test_rom.hh"
+
+#include <memory>
+
+TEST_CASE("Snapshot: Restore rewinds and replays identically", "[run_ahead]")
+{
+    const nes::cartridge cart = test_rom::make_cartridge();
+
+    for(const auto mode : {ppu::pipeline::mode::INLINE, ppu::pipeline::mode::THREADED})
+    {
+        nes::console c(cart, mode);
+        auto         saved = std::make_unique<nes::console::snapshot>();
+
+        c.set_input(0U, nes::buttons::A);
+        test_rom::run_frames(c, 10);
+        c.save(*saved);
+        const uint64_t at_save = c.state_hash();
+
+        c.set_input(0U, nes::buttons::B);
+        test_rom::run_frames(c, 10);
+        const uint64_t later       = c.state_hash();
+        const uint64_t later_frame = nes::frame_hash(c.latest_frame());
+
+        // Held buttons are part of the snapshot.
+        c.restore(*saved);
+        REQUIRE(c.frame_number() == 10U);
+        REQUIRE(c.state_hash() == at_save);
+
+        c.set_input(0U, nes::buttons::B);
+        test_rom::run_frames(c, 10);
+        REQUIRE(c.state_hash() == later);
+        REQUIRE(nes::frame_hash(c.latest_frame()) == later_frame);
+    }
+}
+
+TEST_CASE("Snapshot: Frames without drawing do not change emulation", "[run_ahead]")
+{
+    const nes::cartridge cart = test_rom::make_cartridge();
+
+    nes::console drawn(cart);
+    nes::console skipped(cart);
+    skipped.set_input(0U, nes::buttons::UP);
+    drawn.set_input(0U, nes::buttons::UP);
+
+    test_rom::run_frames(drawn, 20);
+
+    test_rom::run_frames(skipped, 5);
+    skipped.set_rendering(false);
+    skipped.set_audio(false);
+    test_rom::run_frames(skipped, 10);
+    skipped.set_rendering(true);
+    skipped.set_audio(true);
+    test_rom::run_frames(skipped, 5);
+
+    REQUIRE(skipped.state_hash() == drawn.state_hash());
+    REQUIRE(nes::frame_hash(skipped.latest_frame()) == nes::frame_hash(drawn.latest_frame()));
+}
+
+TEST_CASE("Run-ahead: Presents the frame N frames ahead", "[run_ahead]")
+{
+    constexpr uint32_t AHEAD = 2U;
+    constexpr int      STEPS = 12;
+
+    const nes::cartridge    cart = test_rom::make_cartridge();
+    const nes::movie::input held = {nes::buttons::RIGHT, 0x00U};
+
+    nes::console   c(cart);
+    nes::run_ahead ahead(c, AHEAD);
+
+    uint64_t presented = 0U;
+    for(int i = 0; i < STEPS; ++i)
+    {
+        presented = nes::frame_hash(ahead.advance(held));
+    }
+    REQUIRE(ahead.last_seconds() > 0.0);
+
+    // Real state is STEPS frames in, the picture is AHEAD frames further.
+    nes::console reference(cart);
+    reference.set_input(0U, held[0]);
+
+    test_rom::run_frames(reference, STEPS);
+    REQUIRE(c.frame_number() == static_cast<uint64_t>(STEPS));
+    REQUIRE(c.state_hash() == reference.state_hash());
+
+    test_rom::run_frames(reference, AHEAD);
+    REQUIRE(presented == nes::frame_hash(reference.latest_frame()));
+
+    // Audio only comes from the real frames. Muting flushes the blip buffer early, so
+    // compare once both are flushed to the same cycle.
+    nes::console plain(cart);
+    test_rom::run_frames(plain, STEPS);
+
+    const uint64_t end = nes::frame_start_cycle(STEPS);
+    c.audio().flush(end);
+    plain.audio().flush(end);
+    REQUIRE(c.audio().output().size() == plain.audio().output().size());
+}
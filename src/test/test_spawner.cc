@@ -0,0 +1,133 @@
+#include <catch2/catch.hpp>
+
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../spawner.hh"
+#include "test_rom.hh"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+
+namespace
+{
+
+constexpr int WARM_FRAMES = 30;
+constexpr int JOB_FRAMES  = 20;
+
+uint8_t held_by(const std::size_t worker)
+{
+    return static_cast<uint8_t>(1U << worker);
+}
+
+uint64_t play(nes::console &c, const std::size_t worker)
+{
+    c.set_input(0U, held_by(worker));
+    for(int i = 0; i < JOB_FRAMES; ++i)
+    {
+        c.run_frame();
+    }
+    return c.ram()[0x11];
+}
+
+} // namespace
+
+TEST_CASE("Spawner: Workers start from the warmed state", "[spawner]")
+{
+    constexpr std::size_t WORKERS = 4U;
+
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image());
+
+    nes::console c(cart);
+    for(int i = 0; i < WARM_FRAMES; ++i)
+    {
+        c.run_frame();
+    }
+
+    // Expected results, computed in process from the same warmed state.
+    auto warmed = std::make_unique<nes::console::snapshot>();
+    c.save(*warmed);
+
+    uint64_t expected_value[WORKERS];
+    uint64_t expected_hash[WORKERS];
+    for(std::size_t w = 0U; w < WORKERS; ++w)
+    {
+        c.restore(*warmed);
+        expected_value[w] = play(c, w);
+        expected_hash[w]  = c.state_hash();
+    }
+    c.restore(*warmed);
+
+    nes::spawner spawner(c);
+    for(std::size_t w = 0U; w < WORKERS; ++w)
+    {
+        REQUIRE(spawner.spawn(play) == w);
+    }
+    spawner.sample_memory();
+
+    const auto &results = spawner.wait_all();
+    REQUIRE(results.size() == WORKERS);
+    for(std::size_t w = 0U; w < WORKERS; ++w)
+    {
+        REQUIRE(results[w].ok);
+        REQUIRE(results[w].pid > 0);
+        REQUIRE(results[w].value == expected_value[w]);
+        REQUIRE(results[w].state_hash == expected_hash[w]);
+        REQUIRE(results[w].frames == static_cast<uint64_t>(WARM_FRAMES + JOB_FRAMES));
+        REQUIRE(results[w].final_memory.rss_kib > 0U);
+        REQUIRE(results[w].final_memory.private_kib <= results[w].final_memory.rss_kib);
+    }
+
+    // The parent's console is untouched by its workers.
+    REQUIRE(c.frame_number() == static_cast<uint64_t>(WARM_FRAMES));
+}
+
+TEST_CASE("Spawner: Failed jobs are reported", "[spawner]")
+{
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image());
+
+    nes::console c(cart);
+    nes::spawner spawner(c);
+    spawner.spawn([](nes::console &, std::size_t) -> uint64_t { throw std::runtime_error("job"); });
+    spawner.spawn([](nes::console &, std::size_t) -> uint64_t { return 7U; });
+
+    const auto &results = spawner.wait_all();
+    REQUIRE_FALSE(results[0].ok);
+    REQUIRE(results[1].ok);
+    REQUIRE(results[1].value == 7U);
+
+    REQUIRE(nes::read_memory_usage(getpid()).rss_kib > 0U);
+}
+
+TEST_CASE("Spawner: Workers do not hold each other's pipes", "[spawner]")
+{
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image());
+
+    nes::console c(cart);
+    nes::spawner spawner(c);
+    for(int i = 0; i < 3; ++i)
+    {
+        spawner.spawn([](nes::console &, std::size_t) -> uint64_t
+                      {
+                          const std::filesystem::directory_iterator fds("/proc/self/fd");
+                          return static_cast<uint64_t>(std::distance(fds, std::filesystem::directory_iterator()));
+                      });
+    }
+
+    // Later workers would otherwise see one more descriptor per earlier worker.
+    const auto &results = spawner.wait_all();
+    REQUIRE(results[0].ok);
+    REQUIRE(results[1].value == results[0].value);
+    REQUIRE(results[2].value == results[0].value);
+}
+
+TEST_CASE("Spawner: Threaded consoles cannot be forked", "[spawner]")
+{
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image());
+
+    nes::console c(cart, ppu::pipeline::mode::THREADED);
+    REQUIRE_THROWS_AS(nes::spawner(c), std::invalid_argument);
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch.hpp>
+
+#include "../cartridge.hh"
+#include "../console.hh"
+#include "../state_hash.hh"
+#include "test_rom.hh"
+
+#include <array>
+
+namespace
+{
+
+// Root of a hasher that has never seen `memory` before.
+uint64_t fresh_root(const std::array<uint8_t, 0x1000> &memory)
+{
+    nes::page_hasher h;
+    h.add_region(memory.data(), memory.size());
+    return h.root();
+}
+
+} // namespace
+
+TEST_CASE("State hash: Incremental root matches a full rehash", "[state_hash]")
+{
+    std::array<uint8_t, 0x1000> memory{};
+
+    nes::page_hasher hasher;
+    const std::size_t first = hasher.add_region(memory.data(), memory.size());
+    REQUIRE(hasher.page_count() == 16U);
+
+    const uint64_t initial = hasher.root();
+    REQUIRE(hasher.pages_rehashed() == 16U);
+
+    // Nothing dirty, nothing rehashed.
+    REQUIRE(hasher.root() == initial);
+    REQUIRE(hasher.pages_rehashed() == 16U);
+
+    memory[0x345] = 0x12U;
+    hasher.mark_dirty(first + 3U);
+
+    const uint64_t changed = hasher.root();
+    REQUIRE(changed != initial);
+    REQUIRE(changed == fresh_root(memory));
+    REQUIRE(hasher.pages_rehashed() == 17U);
+
+    // Reverting the write restores the original root.
+    memory[0x345] = 0x00U;
+    hasher.mark_dirty(first + 3U);
+    REQUIRE(hasher.root() == initial);
+}
+
+TEST_CASE("State hash: Identical pages in different places still count", "[state_hash]")
+{
+    std::array<uint8_t, 0x1000> memory{};
+    memory[0x000] = 0x01U;
+    memory[0x100] = 0x01U;
+    const uint64_t both = fresh_root(memory);
+
+    memory[0x100] = 0x00U;
+    REQUIRE(fresh_root(memory) != both);
+}
+
+TEST_CASE("State hash: Console hash is incremental and follows input", "[state_hash]")
+{
+    const nes::cartridge cart = nes::load_ines(test_rom::make_image());
+
+    nes::console every_frame(cart);
+    nes::console at_end(cart);
+    nes::console other_input(cart);
+
+    other_input.set_input(0U, nes::buttons::START);
+
+    for(int i = 0; i < 20; ++i)
+    {
+        every_frame.run_frame();
+        every_frame.state_hash();
+
+        at_end.run_frame();
+        other_input.run_frame();
+    }
+
+    REQUIRE(every_frame.state_hash() == at_end.state_hash());
+    REQUIRE(every_frame.state_hash() != other_input.state_hash());
+}
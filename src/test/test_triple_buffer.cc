@@ -0,0 +1,89 @@
+#include <catch2/catch.hpp>
+
+#include "../triple_buffer.hh"
+
+#include <array>
+#include <thread>
+
+namespace
+{
+
+// Large enough that a torn read would show up as mismatched words.
+using mock_frame = std::array<uint64_t, 4096U>;
+
+} // namespace
+
+TEST_CASE("Triple buffer: Hand-off", "[triple_buffer]")
+{
+    utils::triple_buffer<int> buffer;
+
+    REQUIRE(!buffer.acquire());
+
+    buffer.back() = 1;
+    buffer.publish();
+    buffer.back() = 2;
+    buffer.publish();
+
+    // Only the latest value is seen, and only once.
+    REQUIRE(buffer.acquire());
+    REQUIRE(buffer.front() == 2);
+    REQUIRE(!buffer.acquire());
+    REQUIRE(buffer.front() == 2);
+    REQUIRE(buffer.published() == 2U);
+}
+
+TEST_CASE("Triple buffer: Slots are cache-line aligned and stable", "[triple_buffer]")
+{
+    utils::triple_buffer<mock_frame> buffer;
+    const mock_frame *first = &buffer.back();
+
+    REQUIRE(reinterpret_cast<uintptr_t>(first) % utils::CACHE_LINE_SIZE == 0U);
+
+    // Cycling never allocates: the producer only ever sees the same three slots.
+    for(size_t i = 0U; i < 6U; ++i)
+    {
+        buffer.publish();
+        buffer.acquire();
+        REQUIRE(reinterpret_cast<uintptr_t>(&buffer.back()) % utils::CACHE_LINE_SIZE == 0U);
+    }
+    REQUIRE(&buffer.back() != &buffer.front());
+}
+
+TEST_CASE("Triple buffer: Concurrent readers never see torn frames", "[triple_buffer]")
+{
+    constexpr uint64_t FRAMES = 2000U;
+
+    auto buffer = std::make_unique<utils::triple_buffer<mock_frame>>();
+
+    std::thread producer([&buffer]
+    {
+        for(uint64_t n = 1U; n <= FRAMES; ++n)
+        {
+            buffer->back().fill(n);
+            buffer->publish();
+        }
+    });
+
+    uint64_t last = 0U;
+    bool     torn = false;
+    while(last < FRAMES)
+    {
+        if(!buffer->acquire())
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const mock_frame &frame = buffer->front();
+        for(const uint64_t word : frame)
+        {
+            torn = torn || (word != frame[0]);
+        }
+
+        REQUIRE(frame[0] > last);
+        last = frame[0];
+    }
+
+    producer.join();
+    REQUIRE(!torn);
+}
@@ -0,0 +1,166 @@
+#include <signal.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "metrics.hh"
+
+//
+// nes-emu-top: shows the live metrics of every running nes-emu started with --metrics.
+//
+
+namespace
+{
+    constexpr std::size_t TOP_OPCODES = 3U;
+
+    void print_usage()
+    {
+        std::cerr << "usage: nes-emu-top [--interval <seconds>] [--count <refreshes>]\n";
+    }
+
+    // Upper bound of a frame-time bucket, in milliseconds.
+    std::string bucket_label(const std::size_t bucket)
+    {
+        if(bucket + 1U == nes::FRAME_TIME_BUCKETS)
+        {
+            return ">=" + std::to_string(1U << (bucket - 1U));
+        }
+        return "<" + std::to_string(1U << bucket);
+    }
+
+    // Most common frame-time bucket so far.
+    std::string typical_frame_time(const nes::metrics_sample &s)
+    {
+        const auto most = std::max_element(s.frame_times.begin(), s.frame_times.end());
+        if(*most == 0U)
+        {
+            return "-";
+        }
+        return bucket_label(static_cast<std::size_t>(most - s.frame_times.begin())) + "ms";
+    }
+
+    std::string top_opcodes(const nes::metrics_sample &s)
+    {
+        if(s.profiling == 0U)
+        {
+            return "-";
+        }
+
+        std::vector<std::size_t> order(s.opcodes.size());
+        for(std::size_t i = 0U; i < order.size(); ++i)
+        {
+            order[i] = i;
+        }
+        std::partial_sort(order.begin(), order.begin() + TOP_OPCODES, order.end(),
+                          [&s](const std::size_t a, const std::size_t b) { return s.opcodes[a] > s.opcodes[b]; });
+
+        std::ostringstream out;
+        for(std::size_t i = 0U; i < TOP_OPCODES && s.instructions > 0U; ++i)
+        {
+            out << std::hex << std::uppercase << std::setw(2) << std::setfill('0') << order[i] << std::dec << ":"
+                << (100U * s.opcodes[order[i]] / s.instructions) << "% ";
+        }
+        return out.str();
+    }
+
+    double per_second(const uint64_t now, const uint64_t before, const double seconds)
+    {
+        return seconds > 0.0 ? static_cast<double>(now - before) / seconds : 0.0;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    double   interval = 1.0;
+    uint64_t count    = 0U;  // Forever.
+
+    for(int i = 1; i < argc; ++i)
+    {
+        if(std::strcmp(argv[i], "--interval") == 0 && i + 1 < argc)
+        {
+            interval = std::stod(argv[++i]);
+        }
+        else if(std::strcmp(argv[i], "--count") == 0 && i + 1 < argc)
+        {
+            count = std::stoull(argv[++i]);
+        }
+        else
+        {
+            print_usage();
+            return 2;
+        }
+    }
+
+    std::map<std::string, nes::metrics_sample> previous;
+    for(uint64_t refresh = 0U; count == 0U || refresh < count; ++refresh)
+    {
+        if(refresh > 0U)
+        {
+            std::this_thread::sleep_for(std::chrono::duration<double>(interval));
+        }
+
+        std::cout << std::left << std::setw(8) << "PID" << std::right << std::setw(10) << "FRAMES" << std::setw(8)
+                  << "FPS" << std::setw(8) << "MIPS" << std::setw(8) << "MHZ" << std::setw(7) << "SKIP%"
+                  << std::setw(7) << "FRAME" << std::setw(7) << "MODE" << std::setw(10) << "SNAPS" << std::setw(10)
+                  << "SNAP-MB" << "  TOP OPCODES\n";
+
+        std::map<std::string, nes::metrics_sample> current;
+        for(const std::string &name : nes::list_metrics())
+        {
+            pid_t               pid = 0;
+            nes::metrics_sample s;
+            try
+            {
+                s = nes::read_metrics(name, &pid);
+            }
+            catch(const std::runtime_error &)
+            {
+                continue;  // Another version, gone since listing, or stuck mid-update.
+            }
+
+            // Left behind by a process that did not exit cleanly.
+            if(kill(pid, 0) != 0 && errno == ESRCH)
+            {
+                continue;
+            }
+            current[name] = s;
+
+            // Rates over the last interval, or since the start for a new process: it
+            // began with every counter at zero.
+            nes::metrics_sample before{};
+            before.updated_ns = s.started_ns;
+            const auto found  = previous.find(name);
+            if(found != previous.end())
+            {
+                before = found->second;
+            }
+            const double seconds = static_cast<double>(s.updated_ns - before.updated_ns) / 1e9;
+
+            const double skipped =
+                s.cycles > 0U ? 100.0 * static_cast<double>(s.idle_cycles_skipped) / static_cast<double>(s.cycles) : 0.0;
+
+            std::cout << std::left << std::setw(8) << pid << std::right << std::setw(10) << s.frames << std::fixed
+                      << std::setprecision(1) << std::setw(8) << per_second(s.frames, before.frames, seconds)
+                      << std::setw(8) << per_second(s.instructions, before.instructions, seconds) / 1e6
+                      << std::setw(8) << per_second(s.cycles, before.cycles, seconds) / 1e6 << std::setw(7)
+                      << skipped << std::setw(7) << typical_frame_time(s) << std::setw(7)
+                      << (s.exact != 0U ? "exact" : "fast") << std::setw(10)
+                      << (s.snapshots_saved + s.snapshots_restored) << std::setw(10)
+                      << static_cast<double>(s.snapshot_bytes) / (1024.0 * 1024.0) << "  " << top_opcodes(s)
+                      << std::defaultfloat << "\n";
+        }
+        std::cout << std::endl;
+        previous = std::move(current);
+    }
+
+    return 0;
+}
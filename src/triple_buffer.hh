@@ -0,0 +1,86 @@
+#include "ring_buffer.hh"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#pragma once
+
+namespace utils
+{
+    //
+    // Lock-free triple buffer.
+    //
+    // The producer always owns one slot (`back`) and the consumer another (`front`).
+    // The third slot sits in the middle: publishing swaps the producer's slot into it,
+    // acquiring swaps it out to the consumer. Both swaps are a single atomic exchange,
+    // so neither side ever waits on the other or copies a slot; the consumer simply
+    // skips frames it was too slow to see.
+    //
+    // Slots are allocated once, each on its own cache-lines.
+    //
+    template<typename T>
+    class triple_buffer
+    {
+    public:
+        triple_buffer() : slots_(new slot[3U]) {}
+
+        triple_buffer(const triple_buffer &)            = delete;
+        triple_buffer &operator=(const triple_buffer &) = delete;
+
+        //
+        // Producer
+        //
+
+        // Slot the producer is currently writing.
+        T &back() { return slots_[back_].value; }
+
+        // Publishes `back()` as the latest complete value and hands the producer a new slot.
+        void publish()
+        {
+            back_ = middle_.exchange(back_ | FRESH, std::memory_order_acq_rel) & INDEX_MASK;
+            published_.fetch_add(1U, std::memory_order_release);
+        }
+
+        //
+        // Consumer
+        //
+
+        // Takes the latest published value if there is one newer than `front()`.
+        // Returns false (and leaves `front()` alone) otherwise.
+        bool acquire()
+        {
+            if((middle_.load(std::memory_order_relaxed) & FRESH) == 0U)
+            {
+                return false;
+            }
+
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+            return true;
+        }
+
+        // Most recently acquired value.
+        const T &front() const { return slots_[front_].value; }
+
+        // Number of values published so far.
+        uint64_t published() const { return published_.load(std::memory_order_acquire); }
+
+    private:
+        static constexpr uint8_t FRESH      = 0x04U;
+        static constexpr uint8_t INDEX_MASK = 0x03U;
+
+        struct alignas(CACHE_LINE_SIZE) slot
+        {
+            T value;
+        };
+
+        std::unique_ptr<slot[]> slots_;
+
+        alignas(CACHE_LINE_SIZE) std::atomic<uint8_t> middle_{1U};
+        std::atomic<uint64_t> published_{0U};
+
+        alignas(CACHE_LINE_SIZE) uint8_t back_  = 0U;  // Producer only.
+        alignas(CACHE_LINE_SIZE) uint8_t front_ = 2U;  // Consumer only.
+    };
+
+} // namespace utils
@@ -1,26 +1,222 @@
 #include "utils.hh"
 
+#include <atomic>
+#include <cstring>
 #include <fstream>
-#include <iostream>
 #include <iterator>
 #include <stdexcept>
+#include <thread>
 
 namespace utils
 {
-    // NOTE: Maybe we can move this over to a std::array<std::uint8_t, 0xFFFF>,
-    //       since the amount of accessible memory is something that is always
-    //       constant.
-    std::vector<uint8_t> read_binary_blob(const std::string &file_path)
+    std::vector<uint8_t> read_file(const std::string &file_path)
     {
-        std::ifstream bs(file_path);
-        
+        std::ifstream bs(file_path, std::ios::binary);
         if(!bs.is_open())
         {
             throw std::runtime_error("Failed to open file at given path!");
         }
-    
-        std::cout << "Successfully opened " << file_path << "!" << std::endl;
         return {std::istreambuf_iterator<char>(bs), std::istreambuf_iterator<char>()};
     }
 
+    void parallel_for(const std::size_t count, unsigned jobs, const std::function<void(std::size_t)> &fn)
+    {
+        if(jobs == 0U)
+        {
+            jobs = std::max(1U, std::thread::hardware_concurrency());
+        }
+        jobs = static_cast<unsigned>(std::min<std::size_t>(jobs, std::max<std::size_t>(count, 1U)));
+
+        std::atomic<std::size_t> next(0U);
+        std::vector<std::thread> workers;
+        for(unsigned i = 0U; i < jobs; ++i)
+        {
+            workers.emplace_back([&]()
+                                 {
+                                     for(std::size_t j = next++; j < count; j = next++)
+                                     {
+                                         fn(j);
+                                     }
+                                 });
+        }
+        for(std::thread &worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    namespace
+    {
+        constexpr uint64_t HASH_PRIME_1 = 0x9E3779B97F4A7C15ULL;
+        constexpr uint64_t HASH_PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+
+        uint64_t hash_mix(uint64_t h)
+        {
+            h ^= h >> 33U;
+            h *= HASH_PRIME_2;
+            h ^= h >> 29U;
+            return h;
+        }
+    } // namespace
+
+    uint64_t hash64(const void *data, const std::size_t size, const uint64_t seed)
+    {
+        const auto *bytes = static_cast<const uint8_t *>(data);
+        uint64_t    h     = seed ^ (size * HASH_PRIME_1);
+
+        std::size_t i = 0U;
+        for(; i + 8U <= size; i += 8U)
+        {
+            uint64_t word;
+            std::memcpy(&word, bytes + i, sizeof(word));
+            h = (h ^ hash_mix(word * HASH_PRIME_1)) * HASH_PRIME_1;
+        }
+
+        uint64_t tail = 0U;
+        for(std::size_t shift = 0U; i < size; ++i, shift += 8U)
+        {
+            tail |= static_cast<uint64_t>(bytes[i]) << shift;
+        }
+
+        return hash_mix(h ^ hash_mix(tail * HASH_PRIME_1));
+    }
+
+    namespace
+    {
+        // WAV fields are little-endian.
+        template<typename T>
+        void write_le(std::ofstream &stream, const T value)
+        {
+            for(std::size_t i = 0U; i < sizeof(T); ++i)
+            {
+                stream.put(static_cast<char>((value >> (8U * i)) & 0xFFU));
+            }
+        }
+    } // namespace
+
+    wav_writer::wav_writer(const std::string &file_path, const uint32_t sample_rate, const uint16_t channels)
+        : stream_(file_path, std::ios::binary | std::ios::trunc),
+          sample_rate_(sample_rate),
+          channels_(channels)
+    {
+        if(!stream_.is_open())
+        {
+            throw std::runtime_error("Failed to open WAV file for writing!");
+        }
+
+        write_header();
+    }
+
+    wav_writer::~wav_writer()
+    {
+        close();
+    }
+
+    void wav_writer::write(const int16_t *samples, const std::size_t count)
+    {
+        for(std::size_t i = 0U; i < count; ++i)
+        {
+            write_le(stream_, static_cast<uint16_t>(samples[i]));
+        }
+
+        samples_written_ += count;
+    }
+
+    void wav_writer::close()
+    {
+        if(!stream_.is_open())
+        {
+            return;
+        }
+
+        stream_.seekp(0);
+        write_header();
+        stream_.close();
+    }
+
+    void wav_writer::write_header()
+    {
+        const uint32_t data_size = static_cast<uint32_t>(samples_written_ * sizeof(int16_t));
+
+        stream_.write("RIFF", 4);
+        write_le<uint32_t>(stream_, 36U + data_size);
+        stream_.write("WAVE", 4);
+
+        stream_.write("fmt ", 4);
+        write_le<uint32_t>(stream_, 16U);                                   // Chunk size
+        write_le<uint16_t>(stream_, 1U);                                    // PCM
+        write_le<uint16_t>(stream_, channels_);
+        write_le<uint32_t>(stream_, sample_rate_);
+        write_le<uint32_t>(stream_, sample_rate_ * channels_ * 2U);         // Byte rate
+        write_le<uint16_t>(stream_, static_cast<uint16_t>(channels_ * 2U)); // Block align
+        write_le<uint16_t>(stream_, 16U);                                   // Bits per sample
+
+        stream_.write("data", 4);
+        write_le<uint32_t>(stream_, data_size);
+    }
+
+    namespace
+    {
+        constexpr char HEX_DIGITS[] = "0123456789ABCDEF";
+    } // namespace
+
+    buffered_writer::buffered_writer(std::ostream &out, const std::size_t capacity)
+        : out_(out), buffer_(capacity > 0U ? capacity : 1U)
+    {
+    }
+
+    buffered_writer::~buffered_writer()
+    {
+        flush();
+    }
+
+    void buffered_writer::put(const std::string_view text)
+    {
+        for(std::size_t done = 0U; done < text.size();)
+        {
+            if(size_ == buffer_.size())
+            {
+                flush();
+            }
+            const std::size_t count = std::min(text.size() - done, buffer_.size() - size_);
+            std::memcpy(buffer_.data() + size_, text.data() + done, count);
+            size_ += count;
+            done  += count;
+        }
+    }
+
+    void buffered_writer::hex8(const uint8_t value)
+    {
+        put(HEX_DIGITS[value >> 4U]);
+        put(HEX_DIGITS[value & 0x0FU]);
+    }
+
+    void buffered_writer::hex16(const uint16_t value)
+    {
+        hex8(static_cast<uint8_t>(value >> 8U));
+        hex8(static_cast<uint8_t>(value));
+    }
+
+    void buffered_writer::decimal(uint64_t value)
+    {
+        char        digits[20];
+        std::size_t count = 0U;
+        do
+        {
+            digits[count++] = static_cast<char>('0' + value % 10U);
+            value /= 10U;
+        } while(value != 0U);
+
+        while(count > 0U)
+        {
+            put(digits[--count]);
+        }
+    }
+
+    void buffered_writer::flush()
+    {
+        out_.write(buffer_.data(), static_cast<std::streamsize>(size_));
+        size_ = 0U;
+    }
+
 } // namespace utils
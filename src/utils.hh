@@ -1,26 +1,106 @@
 #include <algorithm>
 #include <array>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <ostream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
+#pragma once
+
 namespace utils
 {
-    // Funtion will attempt to open file containing 
-    std::vector<uint8_t> read_binary_blob(const std::string &file_path);
+    // The whole file at `file_path`, read as binary. Throws std::runtime_error if it
+    // cannot be opened.
+    std::vector<uint8_t> read_file(const std::string &file_path);
 
-    // Function will take a text file containing assembly instructions
-    // and generate machine code.
-    //void generate_assembly(const);
+    // Assembly to machine code is cpu::assembler::assemble() (assembler.hh), which runs
+    // at compile time.
 
-    // Function will take a generated machine code, and convert it to
-    // human-readable assembly.
-    //void generate_disassembly(const auto path, const bool header=true);
+    // Machine code to assembly is cpu::disassembler (disassembler.hh).
 
     // Function will... TBD.
     //void pretty_print_hex();
 
+    // Fast non-cryptographic 64-bit hash, stable across runs and (little-endian) hosts.
+    uint64_t hash64(const void *data, std::size_t size, uint64_t seed = 0U);
+
+    // Writes 16-bit PCM samples to a WAV file. The header is written up-front with
+    // zero sizes and patched with the real ones on `close()`.
+    class wav_writer
+    {
+    public:
+        wav_writer(const std::string &file_path, uint32_t sample_rate, uint16_t channels = 1U);
+        ~wav_writer();
+
+        wav_writer(const wav_writer &)            = delete;
+        wav_writer &operator=(const wav_writer &) = delete;
+
+        void write(const int16_t *samples, std::size_t count);
+        void close();
+
+        std::size_t samples_written() const { return samples_written_; }
+
+    private:
+        void write_header();
+
+        std::ofstream stream_;
+        uint32_t      sample_rate_;
+        uint16_t      channels_;
+        std::size_t   samples_written_ = 0U;
+    };
+
+    // Collects text in a fixed buffer and hands it to a stream in large writes, for
+    // output too bulky for per-item stream formatting. Flushes when full and when
+    // destroyed.
+    class buffered_writer
+    {
+    public:
+        explicit buffered_writer(std::ostream &out, std::size_t capacity = 1U << 16U);
+        ~buffered_writer();
+
+        buffered_writer(const buffered_writer &)            = delete;
+        buffered_writer &operator=(const buffered_writer &) = delete;
+
+        void put(const char c)
+        {
+            if(size_ == buffer_.size())
+            {
+                flush();
+            }
+            buffer_[size_++] = c;
+        }
+
+        void put(std::string_view text);
+
+        // Upper-case hex, zero-padded; unpadded decimal.
+        void hex8(uint8_t value);
+        void hex16(uint16_t value);
+        void decimal(uint64_t value);
+
+        void flush();
+
+    private:
+        std::ostream     &out_;
+        std::vector<char> buffer_;
+        std::size_t       size_ = 0U;
+    };
+
+    // Calls `fn(i)` for each `i` below `count` on `jobs` threads (0 for one per core).
+    // Workers take the next index until none are left; returns once all are done.
+    void parallel_for(std::size_t count, unsigned jobs, const std::function<void(std::size_t)> &fn);
+
+    // Calls `fn(item, index)` for each of `items`, as `parallel_for()` does.
+    template<typename Item, typename Function>
+    void parallel_for_each(const std::vector<Item> &items, const unsigned jobs, const Function &fn)
+    {
+        parallel_for(items.size(), jobs, [&items, &fn](const std::size_t i) { fn(items[i], i); });
+    }
+
     // Constexpr map
     template<typename Key, typename Value, std::size_t Size>
     struct Map {